@@ -0,0 +1,134 @@
+//
+//  main.cpp
+//  AssetPacker
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "../../common/asset_archive.h"
+
+// 资源打包工具
+// 把一个目录下的所有文件打成归档，条目名是相对这个目录的路径
+//
+// 用法：AssetPacker [-c lz4|zstd] [-a 对齐] output.pak 目录
+//       AssetPacker --list archive.pak
+
+bool readFile(const std::string &path, std::vector<uint8_t> &data)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? size : 0);
+    size_t read = fread(data.data(), 1, data.size(), file);
+    fclose(file);
+    return read == data.size();
+}
+
+// 递归收集文件，跳过隐藏文件
+void collectFiles(const std::string &root, const std::string &relative, std::vector<std::string> &files)
+{
+    std::string directory = relative.empty() ? root : root + "/" + relative;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent *item = readdir(dir))
+    {
+        if (item->d_name[0] == '.')
+            continue;
+        std::string name = relative.empty() ? item->d_name : relative + "/" + item->d_name;
+        struct stat info;
+        if (stat((root + "/" + name).c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+            collectFiles(root, name, files);
+        else if (S_ISREG(info.st_mode))
+            files.push_back(name);
+    }
+    closedir(dir);
+}
+
+int list(const char *path)
+{
+    AssetArchive archive;
+    if (!archive.open(path))
+    {
+        std::cout << "Failed to open " << path << std::endl;
+        return -1;
+    }
+    for (uint32_t i = 0; i < archive.size(); i++)
+    {
+        const AssetArchiveEntry &entry = archive.entry(i);
+        printf("%10llu %10llu %-6s %016llx %s\n", (unsigned long long)entry.offset, (unsigned long long)entry.rawSize,
+               assetCompressionName(entry.compression), (unsigned long long)entry.contentHash, archive.name(entry).c_str());
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "--list") == 0)
+        return list(argv[2]);
+
+    AssetPackOptions options;
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+    {
+        if (strcmp(argv[arg], "-c") == 0)
+        {
+            if (strcmp(argv[arg + 1], "lz4") == 0)
+                options.compression = ASSET_LZ4;
+            else if (strcmp(argv[arg + 1], "zstd") == 0)
+                options.compression = ASSET_ZSTD;
+        }
+        else if (strcmp(argv[arg], "-a") == 0)
+            options.alignment = std::max(1, atoi(argv[arg + 1]));
+    }
+    if (argc - arg != 2)
+    {
+        std::cout << "usage: AssetPacker [-c lz4|zstd] [-a alignment] output.pak directory\n"
+                     "       AssetPacker --list archive.pak" << std::endl;
+        return -1;
+    }
+#if !HAVE_LZ4
+    if (options.compression == ASSET_LZ4)
+        std::cout << "Built without HAVE_LZ4, entries are stored uncompressed" << std::endl;
+#endif
+#if !HAVE_ZSTD
+    if (options.compression == ASSET_ZSTD)
+        std::cout << "Built without HAVE_ZSTD, entries are stored uncompressed" << std::endl;
+#endif
+
+    std::string output = argv[arg], root = argv[arg + 1];
+    std::vector<std::string> files;
+    collectFiles(root, "", files);
+    std::sort(files.begin(), files.end());
+    AssetArchiveWriter writer;
+    for (const std::string &name : files)
+    {
+        std::vector<uint8_t> data;
+        if (!readFile(root + "/" + name, data))
+        {
+            std::cout << "Failed to read " << name << std::endl;
+            return -1;
+        }
+        writer.add(name, std::move(data));
+    }
+    AssetPackStats stats;
+    if (!writer.write(output, options, &stats))
+        return -1;
+    printf("%s: %zu entries (%zu duplicates, %zu compressed), %llu -> %llu bytes\n", output.c_str(), stats.entries,
+           stats.duplicates, stats.compressed, (unsigned long long)stats.rawBytes, (unsigned long long)stats.archiveBytes);
+    return 0;
+}
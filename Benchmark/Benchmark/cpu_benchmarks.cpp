@@ -0,0 +1,309 @@
+//
+//  cpu_benchmarks.cpp
+//  Benchmark
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../../common/benchmark.h"
+#include "../../common/depth_sort.h"
+#include "../../common/gpu_culling.h"
+#include "../../common/mesh_lod.h"
+#include "../../common/occlusion_culling.h"
+#include "../../common/scene_graph.h"
+
+// 数学、网格处理、剔除：不需要 GL 上下文
+
+// Camera demo 里的 10 个立方体
+static const glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+static const int cubeCount = sizeof(cubePositions) / sizeof(cubePositions[0]);
+
+// 单位立方体，36 个顶点，位置 + 纹理坐标
+static std::vector<float> cubeVertices()
+{
+    static const int faces[6][3] = { { 0, 1, 2 }, { 0, 1, 2 }, { 1, 2, 0 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 0, 1 } };
+    static const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+    std::vector<float> vertices;
+    for (int f = 0; f < 6; f++)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            float p[3];
+            p[faces[f][0]] = corners[i][0] - 0.5f;
+            p[faces[f][1]] = corners[i][1] - 0.5f;
+            p[faces[f][2]] = (f & 1) ? 0.5f : -0.5f;
+            vertices.insert(vertices.end(), { p[0], p[1], p[2], corners[i][0], corners[i][1] });
+        }
+    }
+    return vertices;
+}
+
+// 经纬度球面，segments x segments 个四边形，非索引三角形列表，位置 + 纹理坐标
+static std::vector<float> sphereVertices(int segments)
+{
+    std::vector<float> vertices;
+    auto point = [&](int i, int j) {
+        float u = (float)i / segments, v = (float)j / segments;
+        float theta = u * 6.2831853f, phi = v * 3.1415926f;
+        vertices.insert(vertices.end(), { std::cos(theta) * std::sin(phi), std::cos(phi), std::sin(theta) * std::sin(phi), u, v });
+    };
+    for (int j = 0; j < segments; j++)
+    {
+        for (int i = 0; i < segments; i++)
+        {
+            point(i, j); point(i + 1, j); point(i + 1, j + 1);
+            point(i + 1, j + 1); point(i, j + 1); point(i, j);
+        }
+    }
+    return vertices;
+}
+
+// ---- 数学 ----
+
+// 渲染循环里每个立方体的模型矩阵：translate + rotate
+static void cubeModelMatrices(BenchmarkState &state)
+{
+    float time = 1.0f;
+    glm::mat4 models[cubeCount];
+    while (state.keepRunning())
+    {
+        for (int i = 0; i < cubeCount; i++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), cubePositions[i]);
+            models[i] = glm::rotate(model, glm::radians(time * i * 20.0f), glm::vec3(1.0f, 0.3f, 0.5f));
+        }
+        benchmarkDoNotOptimize(models);
+        time += 0.016f;
+    }
+    state.setItemsProcessed(state.iterations() * cubeCount);
+}
+BENCHMARK_NAMED("math/cube_model_matrices", cubeModelMatrices);
+
+static void viewProjection(BenchmarkState &state)
+{
+    glm::vec3 position(0.0f, 0.0f, 3.0f), front(0.0f, 0.0f, -1.0f), up(0.0f, 1.0f, 0.0f);
+    while (state.keepRunning())
+    {
+        glm::mat4 view = glm::lookAt(position, position + front, up);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+        benchmarkDoNotOptimize(projection * view);
+        position.x += 0.001f;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_NAMED("math/view_projection", viewProjection);
+
+static void mat4Multiply(BenchmarkState &state)
+{
+    glm::mat4 a = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 b = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    while (state.keepRunning())
+    {
+        a = a * b;
+        benchmarkDoNotOptimize(a);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_NAMED("math/mat4_multiply", mat4Multiply);
+
+static void mat4Inverse(BenchmarkState &state)
+{
+    glm::mat4 m = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    while (state.keepRunning())
+    {
+        benchmarkDoNotOptimize(m);
+        glm::mat4 inverse = glm::inverse(m);
+        benchmarkDoNotOptimize(inverse);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_NAMED("math/mat4_inverse", mat4Inverse);
+
+// Camera demo 的 mouse_callback：偏移 -> yaw/pitch -> 朝向
+static void cameraMouseUpdate(BenchmarkState &state)
+{
+    float lastX = 400.0f, lastY = 300.0f, yaw = -90.0f, pitch = 0.0f;
+    glm::vec3 cameraFront;
+    float xpos = 400.0f, ypos = 300.0f;
+    while (state.keepRunning())
+    {
+        xpos += 1.5f;
+        ypos += (state.iterations() & 1) ? 0.7f : -0.7f;
+        float xoffset = (xpos - lastX) * 0.1f;
+        float yoffset = (lastY - ypos) * 0.1f;
+        lastX = xpos;
+        lastY = ypos;
+        yaw += xoffset;
+        pitch = std::min(std::max(pitch + yoffset, -89.0f), 89.0f);
+        glm::vec3 front;
+        front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        front.y = sin(glm::radians(pitch));
+        front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        cameraFront = glm::normalize(front);
+        benchmarkDoNotOptimize(cameraFront);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_NAMED("math/camera_mouse_update", cameraMouseUpdate);
+
+// ---- 场景图 ----
+
+// arg 个节点的树(每个节点 4 个子节点)，每帧改 1/16 的节点
+static void sceneGraphUpdate(BenchmarkState &state)
+{
+    SceneGraph scene;
+    int count = (int)state.arg();
+    for (int i = 0; i < count; i++)
+        scene.addNode(i == 0 ? SceneGraph::NO_PARENT : (i - 1) / 4, glm::translate(glm::mat4(1.0f), glm::vec3(i % 7, i % 5, i % 3)));
+    scene.update();
+    uint64_t updated = 0;
+    int frame = 0;
+    while (state.keepRunning())
+    {
+        for (int i = frame % 16; i < count; i += 16)
+            scene.setLocal(i, glm::rotate(scene.local(i), 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)));
+        updated += scene.update();
+        frame++;
+    }
+    state.setItemsProcessed(updated);
+}
+BENCHMARK_NAMED("scene/graph_update", sceneGraphUpdate)->arg(1024)->arg(16384);
+
+// ---- 网格处理 ----
+
+static void meshSimplify(BenchmarkState &state)
+{
+    std::vector<float> vertices = sphereVertices((int)state.arg());
+    int count = (int)vertices.size() / 5;
+    while (state.keepRunning())
+        benchmarkDoNotOptimize(simplifyMesh(vertices.data(), 5, count, 0.1f));
+    state.setItemsProcessed(state.iterations() * count / 3);
+    state.setLabel(std::to_string(count / 3) + " triangles");
+}
+BENCHMARK_NAMED("mesh/simplify", meshSimplify)->arg(64)->arg(256);
+
+static void meshLodChain(BenchmarkState &state)
+{
+    std::vector<float> vertices = sphereVertices((int)state.arg());
+    int count = (int)vertices.size() / 5;
+    while (state.keepRunning())
+        benchmarkDoNotOptimize(buildLodChain(vertices.data(), 5, count));
+    state.setItemsProcessed(state.iterations() * count / 3);
+}
+BENCHMARK_NAMED("mesh/build_lod_chain", meshLodChain)->arg(64)->arg(256);
+
+// 非索引三角形列表 -> 顶点去重 + 索引；去重是线性查找，顶点数的平方增长，参数比别的网格用例小
+static void meshBuildIndexed(BenchmarkState &state)
+{
+    std::vector<float> vertices = sphereVertices((int)state.arg());
+    int count = (int)vertices.size() / 5;
+    std::vector<float> outVertices;
+    std::vector<GLuint> outIndices;
+    while (state.keepRunning())
+    {
+        outVertices.clear();
+        outIndices.clear();
+        buildIndexedMesh(vertices.data(), 5, count, outVertices, outIndices);
+        benchmarkDoNotOptimize(outIndices.data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_NAMED("mesh/build_indexed", meshBuildIndexed)->arg(16)->arg(32);
+
+// ---- 剔除 ----
+
+// arg 个随机分布的物体，每个用包围球做视锥测试
+static void frustumCullSpheres(BenchmarkState &state)
+{
+    int count = (int)state.arg();
+    std::vector<glm::mat4> models(count);
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 position((i * 37 % 200) - 100.0f, (i * 17 % 60) - 30.0f, -(float)(i * 13 % 200));
+        models[i] = glm::translate(glm::mat4(1.0f), position);
+    }
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f) *
+                               glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec4 sphere(0.0f, 0.0f, 0.0f, 0.87f);
+    int visible = 0;
+    while (state.keepRunning())
+    {
+        glm::vec4 planes[6];
+        extractFrustumPlanes(viewProjection, planes);
+        visible = 0;
+        for (int i = 0; i < count; i++)
+            visible += sphereInFrustum(planes, models[i], sphere);
+        benchmarkDoNotOptimize(visible);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+    state.setLabel(std::to_string(visible) + " visible");
+}
+BENCHMARK_NAMED("culling/frustum_spheres", frustumCullSpheres)->arg(1000)->arg(100000);
+
+// 软件遮挡剔除：光栅化几个大的遮挡体，再查询 arg 个包围盒
+static void occlusionCull(BenchmarkState &state)
+{
+    OcclusionCuller culler;
+    std::vector<float> cube = cubeVertices();
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f) *
+                               glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int count = (int)state.arg();
+    int visible = 0;
+    while (state.keepRunning())
+    {
+        culler.beginFrame();
+        for (int i = 0; i < 4; i++)
+        {
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(i * 2.5f - 3.75f, 0.0f, -4.0f)), glm::vec3(2.0f, 3.0f, 0.5f));
+            culler.rasterizeOccluder(cube.data(), 5, 36, viewProjection * model);
+        }
+        culler.endOccluders();
+        visible = 0;
+        for (int i = 0; i < count; i++)
+        {
+            glm::vec3 center((i * 37 % 20) - 10.0f, (i * 17 % 6) - 3.0f, -6.0f - (i * 13 % 30));
+            visible += culler.isVisible(center - glm::vec3(0.5f), center + glm::vec3(0.5f), viewProjection);
+        }
+        benchmarkDoNotOptimize(visible);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+    state.setLabel(std::to_string(visible) + " visible");
+}
+BENCHMARK_NAMED("culling/occlusion", occlusionCull)->arg(1000)->arg(10000);
+
+// arg 个物体按观察深度从近到远排序，每帧深度都在变
+static void depthSortFrontToBack(BenchmarkState &state)
+{
+    int count = (int)state.arg();
+    std::vector<float> depths(count);
+    for (int i = 0; i < count; i++)
+        depths[i] = 0.1f + (float)(i * 7919 % 10007) * 0.01f;
+    DepthSorter sorter;
+    sorter.reserve(count);
+    float offset = 0.0f;
+    while (state.keepRunning())
+    {
+        sorter.clear();
+        for (int i = 0; i < count; i++)
+            sorter.add(i, depths[i] + offset);
+        benchmarkDoNotOptimize(sorter.sortFrontToBack().data());
+        offset += 0.001f;
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_NAMED("culling/depth_sort", depthSortFrontToBack)->arg(1000)->arg(100000);
@@ -0,0 +1,230 @@
+//
+//  gl_benchmarks.cpp
+//  Benchmark
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../../common/benchmark.h"
+
+// 需要 GL 上下文的用例，都标记了 gl()
+// 每次迭代最后 glFinish，测的是 CPU 提交加上驱动(软件渲染时就是光栅化)的完整耗时
+
+// Camera demo 的着色器，texture_mix.glsl 已经展开
+static const char *cameraVertexSource = "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec2 aTexCoord;\n"
+    "out vec2 TexCoord;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+    "   TexCoord = vec2(aTexCoord.x, aTexCoord.y);\n"
+    "}\n";
+static const char *cameraFragmentSource = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "in vec2 TexCoord;\n"
+    "uniform sampler2D texture1;\n"
+    "uniform sampler2D texture2;\n"
+    "void main()\n"
+    "{\n"
+    "  FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.4);\n"
+    "}\n";
+
+// 失败时返回 0
+static GLuint buildProgram(const std::string &vertexSource, const std::string &fragmentSource)
+{
+    const char *sources[2] = { vertexSource.c_str(), fragmentSource.c_str() };
+    GLuint shaders[2] = { glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER) };
+    GLuint program = glCreateProgram();
+    for (int i = 0; i < 2; i++)
+    {
+        glShaderSource(shaders[i], 1, &sources[i], NULL);
+        glCompileShader(shaders[i]);
+        glAttachShader(program, shaders[i]);
+    }
+    glLinkProgram(program);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glDeleteShader(shaders[0]);
+    glDeleteShader(shaders[1]);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// 编译 + 链接；每次在源码末尾加一行不同的注释，绕过驱动的着色器缓存
+static void shaderCompileLink(BenchmarkState &state)
+{
+    uint64_t serial = 0;
+    while (state.keepRunning())
+    {
+        std::string tag = "// " + std::to_string(serial++) + "\n";
+        GLuint program = buildProgram(cameraVertexSource + tag, cameraFragmentSource + tag);
+        if (!program)
+        {
+            state.skipWithError("link failed");
+            return;
+        }
+        glDeleteProgram(program);
+    }
+    state.setItemsProcessed(state.iterations());
+    state.setLabel("uncached");
+}
+BENCHMARK_NAMED("gl/shader_compile_link", shaderCompileLink)->gl();
+
+static GLuint createTexture(int size, bool mipmaps)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    std::vector<uint8_t> pixels((size_t)size * size * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = (uint8_t)(i * 13);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    if (mipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    return texture;
+}
+
+// arg x arg 的 RGBA 上传
+static void textureUpload(BenchmarkState &state)
+{
+    int size = (int)state.arg();
+    GLuint texture = createTexture(size, false);
+    std::vector<uint8_t> pixels((size_t)size * size * 4, 128);
+    glFinish();
+    while (state.keepRunning())
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glFinish();
+    }
+    glDeleteTextures(1, &texture);
+    state.setBytesProcessed(state.iterations() * pixels.size());
+}
+BENCHMARK_NAMED("gl/texture_upload", textureUpload)->arg(512)->arg(2048)->gl();
+
+// TextureCache 每次上传之后的 glGenerateMipmap
+static void generateMipmap(BenchmarkState &state)
+{
+    int size = (int)state.arg();
+    GLuint texture = createTexture(size, false);
+    // 第一次调用时驱动才准备生成 mip 用的着色器等，不计入
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glFinish();
+    while (state.keepRunning())
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+    }
+    glDeleteTextures(1, &texture);
+    state.setBytesProcessed(state.iterations() * size * size * 4);
+}
+BENCHMARK_NAMED("mip/gl_generate_mipmap", generateMipmap)->arg(512)->arg(2048)->gl();
+
+// Camera demo 的一帧：800x600，10 个带两张纹理的立方体
+static void drawCubes(BenchmarkState &state)
+{
+    const int width = 800, height = 600;
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, width, height);
+
+    GLuint program = buildProgram(cameraVertexSource, cameraFragmentSource);
+    GLuint textures[2] = { createTexture(512, true), createTexture(512, true) };
+    for (int i = 0; i < 2; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "texture1"), 0);
+    glUniform1i(glGetUniformLocation(program, "texture2"), 1);
+
+    // 立方体：6 个面，每个面 2 个三角形
+    std::vector<float> vertices;
+    static const int axes[3][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 } };
+    static const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+    for (int f = 0; f < 6; f++)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            float p[3];
+            p[axes[f / 2][0]] = corners[i][0] - 0.5f;
+            p[axes[f / 2][1]] = corners[i][1] - 0.5f;
+            p[axes[f / 2][2]] = (f & 1) ? 0.5f : -0.5f;
+            vertices.insert(vertices.end(), { p[0], p[1], p[2], corners[i][0], corners[i][1] });
+        }
+    }
+    GLuint VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f), glm::vec3( 2.0f,  5.0f, -15.0f), glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f), glm::vec3( 2.4f, -0.4f, -3.5f), glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f), glm::vec3( 1.5f,  2.0f, -2.5f), glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, 100.0f);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    GLint modelLocation = glGetUniformLocation(program, "model");
+    glEnable(GL_DEPTH_TEST);
+
+    float time = 0.0f;
+    // 第一帧有着色器变体的编译等一次性开销，先画一帧不计入
+    for (bool warmup = true; warmup || state.keepRunning(); warmup = false)
+    {
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int i = 0; i < 10; i++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), cubePositions[i]);
+            model = glm::rotate(model, glm::radians(time * i * 20.0f), glm::vec3(1.0f, 0.3f, 0.5f));
+            glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+        glFinish();
+        time += 0.016f;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteTextures(2, textures);
+    glDeleteProgram(program);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(2, renderbuffers);
+    glDeleteFramebuffers(1, &framebuffer);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_NAMED("gl/draw_cubes_frame", drawCubes)->gl();
@@ -0,0 +1,121 @@
+//
+//  image_benchmarks.cpp
+//  Benchmark
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../../common/benchmark.h"
+#include "../../common/image_decoder.h"
+#include "../../common/virtual_texture.h"
+
+// 图片解码、通道转换、CPU 上的 mip 生成
+
+static bool readFile(const std::string &path, std::vector<uint8_t> &data)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? size : 0);
+    size_t read = fread(data.data(), 1, data.size(), file);
+    fclose(file);
+    return read == data.size() && !data.empty();
+}
+
+// 每张图片、每个能解码它的后端注册一个用例，名字是 image/decode/<后端>/<文件名>
+// 字节数按压缩后的文件大小算，和原来的 MB/s 一致
+void registerImageBenchmarks(const std::vector<std::string> &paths)
+{
+    for (const std::string &path : paths)
+    {
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        if (!readFile(path, *data))
+        {
+            printf("Benchmark: cannot read %s\n", path.c_str());
+            continue;
+        }
+        std::string file = path.substr(path.find_last_of('/') + 1);
+        for (const char *backendName : { "jpeg-simd", "stb_image" })
+        {
+            ImageDecoderBackend *backend = imageDecoder.find(backendName);
+            if (!backend->canDecode(data->data(), data->size()))
+                continue;
+            benchmarkRegistry().add(std::string("image/decode/") + backendName + "/" + file, [backend, data](BenchmarkState &state) {
+                DecodedImage image;
+                while (state.keepRunning())
+                {
+                    if (!backend->decode(data->data(), data->size(), 0, image))
+                    {
+                        state.skipWithError("decode failed");
+                        return;
+                    }
+                }
+                state.setBytesProcessed(state.iterations() * data->size());
+                state.setItemsProcessed(state.iterations() * image.width * image.height);
+                state.setLabel(std::to_string(image.width) + "x" + std::to_string(image.height) + "x" + std::to_string(image.channels));
+            });
+        }
+    }
+}
+
+// arg x arg 的 RGB -> RGBA
+static void expandRgba(BenchmarkState &state)
+{
+    int count = (int)(state.arg() * state.arg());
+    std::vector<uint8_t> rgb((size_t)count * 3, 100), rgba((size_t)count * 4);
+    while (state.keepRunning())
+    {
+        expandRgbToRgba(rgb.data(), rgba.data(), count);
+        benchmarkClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * rgba.size());
+}
+BENCHMARK_NAMED("image/expand_rgb_to_rgba", expandRgba)->arg(1024);
+
+static void flipRows(BenchmarkState &state)
+{
+    int size = (int)state.arg();
+    std::vector<uint8_t> pixels((size_t)size * size * 4, 7);
+    while (state.keepRunning())
+    {
+        flipImageRows(pixels.data(), (size_t)size * 4, size);
+        benchmarkClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * pixels.size());
+}
+BENCHMARK_NAMED("image/flip_rows", flipRows)->arg(1024);
+
+// arg x arg 的 RGBA 生成完整的 mip 链(2x2 平均)
+static void cpuMipChain(BenchmarkState &state)
+{
+    int size = (int)state.arg();
+    std::vector<uint8_t> base((size_t)size * size * 4);
+    for (size_t i = 0; i < base.size(); i++)
+        base[i] = (uint8_t)(i * 31);
+    std::vector<uint8_t> levels(base.size() / 2);
+    while (state.keepRunning())
+    {
+        const uint8_t *src = base.data();
+        uint8_t *dst = levels.data();
+        for (int w = size, h = size; w > 1 || h > 1;)
+        {
+            int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+            downsampleRgba(src, w, h, dst, nw, nh);
+            src = dst;
+            dst += (size_t)nw * nh * 4;
+            w = nw;
+            h = nh;
+        }
+        benchmarkClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * base.size());
+}
+BENCHMARK_NAMED("mip/cpu_box_chain", cpuMipChain)->arg(512)->arg(2048);
@@ -0,0 +1,147 @@
+//
+//  main.cpp
+//  Benchmark
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#include <glad/glad.h>
+#if defined(__linux__)
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#else
+    #include <GLFW/glfw3.h>
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../../common/benchmark.h"
+
+// 热点代码的微基准
+// 用例在 cpu_benchmarks.cpp(数学、网格、剔除)、image_benchmarks.cpp(解码、mip)、gl_benchmarks.cpp(需要 GL)
+// 需要 GL 的用例跑在一个不显示的上下文里：
+//   Linux 上用 EGL 的 surfaceless 上下文，默认强制 Mesa 的软件渲染(llvmpipe)，没有 GPU、没有显示器也能跑；
+//   其它平台用一个隐藏的 GLFW 窗口
+// 所有绘制都画到用例自己的 FBO 里
+//
+// 用法：Benchmark [--benchmark_filter=正则] [--benchmark_out=结果.json] [--benchmark_min_time=秒]
+//                 [--benchmark_list_tests] [--image=图片]... [--gl=software|hardware|none]
+//   不给 --image 时用 Camera demo 的三张图片，路径相对仓库根目录
+// Linux 上不用 Xcode 工程，直接编译：
+//   g++ -std=c++17 -O2 -I<glad、glm、stb 的 include 目录> Benchmark/Benchmark/*.cpp <glad>/src/glad.c -lEGL -lpthread -o bench
+
+void registerImageBenchmarks(const std::vector<std::string> &paths);
+
+#if defined(__linux__)
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+
+static bool createContext(bool software)
+{
+    if (software)
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+    // 优先用 Mesa 的 surfaceless 平台，不需要 X11/Wayland
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (eglDisplay == EGL_NO_DISPLAY)
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API))
+        return false;
+    const EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                  EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    // EGL_KHR_no_config_context + EGL_KHR_surfaceless_context：不需要 config 和 surface
+    eglContext = eglCreateContext(eglDisplay, (EGLConfig)0, EGL_NO_CONTEXT, attributes);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+        return false;
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) != 0;
+}
+
+static void destroyContext()
+{
+    if (eglDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (eglContext != EGL_NO_CONTEXT)
+        eglDestroyContext(eglDisplay, eglContext);
+    eglTerminate(eglDisplay);
+}
+#else
+static GLFWwindow *window = NULL;
+
+static bool createContext(bool software)
+{
+    if (!glfwInit())
+        return false;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    #endif
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "Benchmark", NULL, NULL);
+    if (!window)
+        return false;
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+}
+
+static void destroyContext()
+{
+    if (window)
+        glfwDestroyWindow(window);
+    glfwTerminate();
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    BenchmarkOptions options;
+    options.parse(argc, argv);
+
+    std::vector<std::string> images;
+#if defined(__linux__)
+    std::string glMode = "software";
+#else
+    std::string glMode = "hardware";
+#endif
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--image=", 8) == 0)
+            images.push_back(argv[i] + 8);
+        else if (strncmp(argv[i], "--gl=", 5) == 0)
+            glMode = argv[i] + 5;
+        else
+        {
+            printf("usage: Benchmark [--benchmark_filter=regex] [--benchmark_out=results.json] [--benchmark_min_time=seconds]\n"
+                   "                 [--benchmark_list_tests] [--image=path]... [--gl=software|hardware|none]\n");
+            return -1;
+        }
+    }
+    if (images.empty())
+        images = { "Camera/Camera/container.jpg", "Camera/Camera/wall.jpg", "Camera/Camera/awesomeface.png" };
+    registerImageBenchmarks(images);
+
+    if (!options.list && glMode != "none")
+    {
+        options.glAvailable = createContext(glMode == "software");
+        if (options.glAvailable)
+        {
+            options.context.push_back({ "gl_renderer", (const char *)glGetString(GL_RENDERER) });
+            options.context.push_back({ "gl_version", (const char *)glGetString(GL_VERSION) });
+            printf("GL: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+        }
+        else
+            printf("No GL context, GL benchmarks are skipped\n");
+    }
+    options.context.push_back({ "gl_mode", options.glAvailable ? glMode : "none" });
+
+    int result = benchmarkRegistry().run(options);
+    if (options.glAvailable)
+        destroyContext();
+    return result;
+}
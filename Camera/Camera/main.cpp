@@ -14,10 +14,32 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "../../common/occlusion_culling.h"
+#include "../../common/shader_reload.h"
+#include "../../common/profiler.h"
+#include "../../common/gl_intercept.h"
+#include "../../common/gl_capture.h"
+#include "../../common/regression.h"
+#include "../../common/gpu_resources.h"
+#include "../../common/frame_arena.h"
+#include "../../common/scene_graph.h"
+#include "../../common/dynamic_resolution.h"
+#include "../../common/mesh_lod.h"
+#include "../../common/gpu_culling.h"
+#include "../../common/frame_pacing.h"
+#include "../../common/frame_export.h"
+#include "../../common/texture_cache.h"
+#include "../../common/asset_archive.h"
+#include "../../common/multi_view.h"
+#include "../../common/depth_sort.h"
+#include "../../common/overdraw.h"
+#include "../../common/occlusion_query.h"
 
 // 全局变量
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+// 窗口帧缓冲的实际大小，Retina 屏上比窗口大；窗口大小变化时在回调里更新
+int framebufferWidth = 0, framebufferHeight = 0;
 
 // camera 方向
 glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f, 3.0f); // 摄像机位置
@@ -35,6 +57,43 @@ float fov   =  45.0f; // 视角
 float deltaTime = 0.0f; // 当前帧与上一帧的时间差
 float lastFrame = 0.0f; // 上一帧的时间
 
+// 软件遮挡剔除
+bool occlusionCulling = true; // 按 O 键开关
+const unsigned int NUM_OCCLUDERS = 3; // 每帧选离摄像机最近的几个立方体作为遮挡体
+OcclusionCuller occlusionCuller;
+
+// 动态分辨率，按 R 键开关，开启后场景分辨率随 GPU 耗时变化
+bool dynamicResolutionEnabled = false;
+DynamicResolution dynamicResolution;
+
+// 细节层次，屏幕上小于这个像素数的立方体画成替身
+const float IMPOSTOR_PIXELS = 24.0f;
+
+// GPU 驱动的剔除和间接绘制，按 G 键开关，需要 OpenGL 4.3
+bool gpuCulling = false;
+
+// 多视图：V 键开关分屏(主视角 + 俯视)，B 键在摄像机位置采集一次环境贴图
+// 所有视图一次提交画完，每个立方体一次实例化绘制
+// 环境贴图目前没有着色器采样，只用来演示和测量 6 个面一次提交的开销
+bool splitScreen = false;
+bool captureProbe = false;
+const int PROBE_SIZE = 256;
+
+// 不透明的立方体按观察深度从近到远提交，按 F 键开关
+// 深度预渲染：先只画深度，再用 GL_EQUAL 着色，每个像素只着色一次，按 Z 键开关
+bool depthSorting = true;
+bool depthPrepass = false;
+DepthSorter depthSorter;
+
+// 重复着色热力图，按 H 键开关，标题栏显示平均和最大重复次数
+bool overdrawEnabled = false;
+OverdrawView overdraw;
+
+// 硬件遮挡查询：最近的几个立方体先画，其余的先画包围盒查询，再按结果绘制
+// Q 键切换：关闭 -> 条件渲染 -> 用前几帧的结果
+bool hardwareOcclusion = false;
+OcclusionQueries occlusionQueries;
+
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
 void processInput(GLFWwindow *window)
@@ -58,6 +117,9 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
+    dynamicResolution.resize(width, height);
 }
 // 鼠标事件
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
@@ -96,6 +158,54 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     cameraFront = glm::normalize(front);
 }
+// 按键事件，用于切换各种开关，只在按下时触发一次
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+        return;
+    if (key == GLFW_KEY_O)
+        occlusionCulling = !occlusionCulling;
+    if (key == GLFW_KEY_R)
+        dynamicResolutionEnabled = !dynamicResolutionEnabled;
+    if (key == GLFW_KEY_G)
+        gpuCulling = !gpuCulling;
+    if (key == GLFW_KEY_V)
+        splitScreen = !splitScreen;
+    if (key == GLFW_KEY_B)
+        captureProbe = true;
+    if (key == GLFW_KEY_F)
+        depthSorting = !depthSorting;
+    if (key == GLFW_KEY_Z)
+        depthPrepass = !depthPrepass;
+    if (key == GLFW_KEY_H)
+        overdrawEnabled = !overdrawEnabled;
+    if (key == GLFW_KEY_Q)
+    {
+        if (!hardwareOcclusion)
+        {
+            hardwareOcclusion = true;
+            occlusionQueries.mode = OCCLUSION_CONDITIONAL;
+        }
+        else if (occlusionQueries.mode == OCCLUSION_CONDITIONAL)
+            occlusionQueries.mode = OCCLUSION_PREVIOUS_FRAME;
+        else
+            hardwareOcclusion = false;
+    }
+    // P 键切换帧节奏：vsync -> 不限帧 -> 限帧 -> 延迟采样输入
+    if (key == GLFW_KEY_P)
+        framePacer.setMode((FramePacingMode)((framePacer.getMode() + 1) % PACING_MODE_COUNT));
+    // C 键开关 OpenGL 调用计数，关闭时完全没有额外开销
+    if (key == GLFW_KEY_C)
+    {
+        if (glIntercept.installed)
+        {
+            glInterceptUninstall();
+            glfwSetWindowTitle(window, "LearnOpenGL");
+        }
+        else
+            glInterceptInstall();
+    }
+}
 // 滚动事件
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
@@ -106,29 +216,10 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
         fov = 45.0f;
 }
 
-// 顶点着色glsl
-const char *vertexShaderSource = "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "layout (location = 1) in vec2 aTexCoord;\n"
-    "out vec2 TexCoord;\n"
-    "uniform mat4 model;\n"
-    "uniform mat4 view;\n"
-    "uniform mat4 projection;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
-    "   TexCoord = vec2(aTexCoord.x, aTexCoord.y);\n"
-    "}\0";
-// 片元着色
-const char *fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "in vec2 TexCoord;\n"
-    "uniform sampler2D texture1;\n"
-    "uniform sampler2D texture2;\n"
-    "void main()\n"
-    "{\n"
-    "  FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.4);\n"
-    "}\n\0";
+// 着色器文件目录，文件改动后会自动重新编译
+const std::string SHADER_DIR = "/Users/wenqiang/Documents/work/OpenGL/work/Camera/Camera/shaders/";
+// 纹理混合比例，编译期注入着色器，不占用 uniform
+constexpr ShaderConstant MIX_FACTOR = ShaderConstant::Float("MIX_FACTOR", 0.4);
 
 int main()
 {
@@ -141,6 +232,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("Camera");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -157,6 +250,8 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback);
     // 绑定窗口滚动事件
     glfwSetScrollCallback(window, scroll_callback);
+    // 绑定按键事件
+    glfwSetKeyCallback(window, key_callback);
     
     // 通知window 捕获鼠标
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -167,108 +262,142 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 4.3 的函数(GPU 驱动剔除用)，要在安装调用计数和录制之前取到
+    glExtensionsLoad((GLADloadproc)glfwGetProcAddress);
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
+    // 之后由 framebuffer_size_callback 跟着窗口更新
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    // 设置了 GL_CAPTURE 环境变量时录制 OpenGL 调用，用 Replay 工具回放
+    // GL_CAPTURE_FRAMES=起始帧,帧数 指定录制范围，默认从第 60 帧开始录 10 帧
+    if (const char *capturePath = getenv("GL_CAPTURE"))
+    {
+        unsigned int captureStart = 60, captureCount = 10;
+        if (const char *captureFrames = getenv("GL_CAPTURE_FRAMES"))
+            sscanf(captureFrames, "%u,%u", &captureStart, &captureCount);
+        glCaptureInstall(capturePath, captureStart, captureCount, framebufferWidth, framebufferHeight);
+    }
+    // 设置了 GL_COUNTERS 环境变量时一开始就统计每帧的 OpenGL 调用
+    if (getenv("GL_COUNTERS"))
+        glInterceptInstall();
+    
     // 开启深度测试，遮挡z值较小的内容
     glEnable(GL_DEPTH_TEST);
     
-    // 创建一个顶点着色器
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL); // 加载顶点着色器代码
-    glCompileShader(vertexShader); // 编译着色器
-    // 检查着色器编译是否成功
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    // GPU 计时查询
+    GpuProfiler gpuProfiler;
+    
+    // 帧节奏，FRAME_PACING=vsync|uncapped|limiter:帧率|late-latch:帧率，默认 vsync
+    // 回归测试模式下不限帧，帧耗时才有意义
+    FramePacingMode pacingMode = PACING_VSYNC;
+    double pacingFps = 60.0;
+    if (const char *pacing = getenv("FRAME_PACING"))
     {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        if (!parseFramePacing(pacing, pacingMode, pacingFps))
+            std::cout << "Unknown FRAME_PACING " << pacing << std::endl;
     }
-    
-    // 创建一个片元着色器
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL); // 加载片元着色器代码
-    glCompileShader(fragmentShader);// 编译着色器
-    // 检查着色器编译是否成功
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    // 导出帧，FRAME_EXPORT=目录[:png|raw|y4m]，FRAME_EXPORT_FRAMES=帧数 导出这么多帧后退出
+    // 读回和编码都是异步的，离线批量导出时不限帧
+    FrameExporter frameExporter;
+    unsigned int exportFrames = 0;
+    if (const char *exportSpec = getenv("FRAME_EXPORT"))
     {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        std::string exportDir = exportSpec;
+        FrameExportFormat exportFormat = EXPORT_PNG;
+        size_t colon = exportDir.rfind(':');
+        if (colon != std::string::npos && parseFrameExportFormat(exportDir.substr(colon + 1), exportFormat))
+            exportDir = exportDir.substr(0, colon);
+        frameExporter.start(exportDir, exportFormat, framebufferWidth, framebufferHeight);
+        if (const char *count = getenv("FRAME_EXPORT_FRAMES"))
+            exportFrames = (unsigned int)atoi(count);
     }
+    if (regression.active || frameExporter.isActive())
+        pacingMode = PACING_UNCAPPED;
+    framePacer.init(pacingMode, pacingFps);
     
+    // 动态分辨率的离屏目标，设置了 DYNAMIC_RESOLUTION=预算毫秒数 时一开始就开启
+    dynamicResolution.init(framebufferWidth, framebufferHeight);
+    if (const char *budget = getenv("DYNAMIC_RESOLUTION"))
+    {
+        dynamicResolutionEnabled = true;
+        if (atof(budget) > 0.0)
+            dynamicResolution.budgetMs = (float)atof(budget);
+    }
+    // 重复着色热力图，设置了 OVERDRAW 时一开始就开启
+    overdraw.init();
+    if (getenv("OVERDRAW"))
+        overdrawEnabled = true;
+    // 硬件遮挡查询，OCCLUSION_QUERY=conditional|previous-frame 时一开始就开启
+    occlusionQueries.init();
+    if (const char *queryMode = getenv("OCCLUSION_QUERY"))
+    {
+        if (parseOcclusionQueryMode(queryMode, occlusionQueries.mode))
+            hardwareOcclusion = true;
+        else
+            std::cout << "Unknown OCCLUSION_QUERY " << queryMode << std::endl;
+    }
     
-    //关联着色器
-    unsigned int shaderProgram = glCreateProgram(); // 创建一个着色器程序，着色器程序对象是多个着色器合并之后的版本
-    glAttachShader(shaderProgram, vertexShader); // 挂载顶点着色器
-    glAttachShader(shaderProgram, fragmentShader); // 挂载片元着色器
-    glLinkProgram(shaderProgram); // 关联到opengl程序对象
+    // VAO、缓冲、纹理都放在资源池里，用句柄访问
+    GpuResources resources;
     
-    // 检查关联状态
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);  // 挂载后删除顶点着色器
-    glDeleteShader(fragmentShader);// 挂载后删除片元着色器
+    // 从文件加载着色器，编译在后台进行，文件修改后自动热重载
+    ShaderReloader *shaders = new ShaderReloader(window);
+    int cameraShader = shaders->load(SHADER_DIR + "camera.vs", SHADER_DIR + "camera.fs", constantDefines({ MIX_FACTOR }));
+    unsigned int shaderProgram = 0;
+    // 远处立方体的替身着色器
+    int impostorShader = shaders->load(SHADER_DIR + "impostor.vs", SHADER_DIR + "impostor.fs");
+    unsigned int impostorProgram = 0;
+    // 深度预渲染用同一个顶点着色器，片元着色器为空；设置了 DEPTH_PREPASS 时一开始就开启
+    int depthShader = shaders->load(SHADER_DIR + "camera.vs", SHADER_DIR + "depth_only.fs", constantDefines({ MIX_FACTOR }));
+    unsigned int depthProgram = 0;
+    if (getenv("DEPTH_PREPASS"))
+        depthPrepass = true;
 
-    
-    // 加载纹理图片
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("/Users/wenqiang/Documents/work/OpenGL/work/Camera/Camera/container.jpg", &width, &height, &nrChannels, 0);
+    // 设置了 ASSET_ARCHIVE 时图片从归档里取(AssetPacker 打包 Camera 目录)，找不到的再从本机路径加载
+    // 归档要比纹理缓存活得久，缓存降级后重新加载时还会读映射的内存
+    AssetArchive assets;
+    if (const char *archivePath = getenv("ASSET_ARCHIVE"))
+    {
+        if (!assets.open(archivePath))
+            std::cout << "Failed to open asset archive " << archivePath << std::endl;
+    }
+    // 纹理经过缓存加载，内容相同的图片只上传一次，没有引用的纹理按显存预算降级或删除
+    TextureCache textureCache(resources, textureBudgetFromEnv());
+    // 图片本身已经压缩过，打包时不会再压缩，直接用映射内存里的数据
+    auto acquireImage = [&](const std::string &name, const std::string &path, bool flip) {
+        AssetSpan span = assets.isOpen() ? assets.span(name) : AssetSpan();
+        return span.data ? textureCache.acquireMemory(name, span.data, span.size, flip) : textureCache.acquire(path, flip);
+    };
+    TextureHandle texture = acquireImage("container.jpg", "/Users/wenqiang/Documents/work/OpenGL/work/Camera/Camera/container.jpg", false);
     // 加载失败处理
-    if (!data)
+    if (!texture.valid())
     {
         std::cout << "Failed to load texture1" << std::endl;
     }
-    // 创建一个纹理
-    unsigned int texture;
-    glGenTextures(1, &texture);
     // 绑定纹理
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, resources.get(texture));
     // 定义纹理水平垂直防线的渲染方式，拉伸、重复、翻转
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT); // 纹理环绕方式，S方向repeat
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT); // 纹理环绕方式，T方向repeat
     // 有时纹理不能完整覆盖模型，可以设置纹理缩小、放大时的过滤选项， GL_NEAREST 中心点采样，GL_LINEAR 临近采样
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // 加载纹理图片数据data
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
-    glGenerateMipmap(GL_TEXTURE_2D);
-    // 释放图片资源
-    stbi_image_free(data);
     
-    // 加载第二个纹理图片
-    stbi_set_flip_vertically_on_load(true);  // 翻转第二张纹理
-    data= stbi_load("/Users/wenqiang/Documents/work/OpenGL/work/Camera/Camera/awesomeface.png",  &width, &height, &nrChannels, 0);
+    // 加载第二个纹理图片，翻转
+    TextureHandle texture_sec = acquireImage("awesomeface.png", "/Users/wenqiang/Documents/work/OpenGL/work/Camera/Camera/awesomeface.png", true);
     // 加载失败处理
-    if (!data)
+    if (!texture_sec.valid())
     {
         std::cout << "Failed to load texture2" << std::endl;
     }
-    // 创建第二个纹理
-    unsigned int texture_sec;
-    glGenTextures(1, &texture_sec);
     // 绑定纹理
-    glBindTexture(GL_TEXTURE_2D, texture_sec);
+    glBindTexture(GL_TEXTURE_2D, resources.get(texture_sec));
     // 定义纹理水平垂直防线的渲染方式，拉伸、重复、翻转
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT); // 纹理环绕方式，S方向repeat
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT); // 纹理环绕方式，T方向repeat
     // 有时纹理不能完整覆盖模型，可以设置纹理缩小、放大时的过滤选项， GL_NEAREST 中心点采样，GL_LINEAR 临近采样
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // 加载纹理图片数据data
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
-    glGenerateMipmap(GL_TEXTURE_2D);
-    // 释放图片资源
-    stbi_image_free(data);
-    
-    // 应用着色器程序使纹理生效
-    glUseProgram(shaderProgram);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texture2"), 1);
     
     // 3D立方体顶点
     float vertices[] = {
@@ -329,17 +458,36 @@ int main()
       glm::vec3( 1.5f,  0.2f, -1.5f),
       glm::vec3(-1.3f,  1.0f, -1.5f)
     };
+    const unsigned int cubeCount = sizeof(cubePositions) / sizeof(cubePositions[0]);
+    
+    // 场景图：立方体都挂在根节点下，局部变换改变时才重新计算世界矩阵
+    SceneGraph scene;
+    int sceneRoot = scene.addNode(SceneGraph::NO_PARENT);
+    int cubeNodes[cubeCount];
+    for (unsigned int i = 0; i < cubeCount; i++)
+        cubeNodes[i] = scene.addNode(sceneRoot, glm::translate(glm::mat4(1.0f), cubePositions[i]));
     
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO); // 创建一个顶点数组对象VAO
-    glGenBuffers(1, &VBO); // 创建一个顶点缓冲对象VBO
+    // LOD 链：各级网格连在一起放进同一个 VBO，绘制时按级别取不同的范围
+    LodChain cubeLod = buildLodChain(vertices, 5, 36);
+    // 每一级的切换阈值是下一级的两倍，最粗的一级小于 IMPOSTOR_PIXELS 时换成替身
+    LodSelector lodSelector;
+    for (size_t level = 0; level < cubeLod.levels.size(); level++)
+        lodSelector.minPixels.push_back(IMPOSTOR_PIXELS * (float)(1 << (cubeLod.levels.size() - 1 - level)));
+    int cubeLevels[cubeCount];
+    for (unsigned int i = 0; i < cubeCount; i++)
+        cubeLevels[i] = -1;
+    Impostor impostor;
+    impostor.init();
+    
+    VertexArrayHandle VAO = resources.createVertexArray(); // 创建一个顶点数组对象VAO
+    BufferHandle VBO = resources.createBuffer(); // 创建一个顶点缓冲对象VBO
     
     // 绑定顶点数组对象
-    glBindVertexArray(VAO);
+    glBindVertexArray(resources.get(VAO));
     // 绑定顶点缓冲对象
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, resources.get(VBO));
     // 将顶点数组复制到缓冲对象中
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, cubeLod.vertices.size() * sizeof(float), cubeLod.vertices.data(), GL_STATIC_DRAW);
     
     // 描述顶点结构：
     // 第一个参数：起始位置
@@ -356,74 +504,521 @@ int main()
     // 启用着色器颜色属性， 对应着色器的 location = 1
     glEnableVertexAttribArray(1);
     
+    // 间接绘制需要索引，LOD0 的顶点按原顺序编号，放进同一个 VAO
+    BufferHandle EBO = resources.createBuffer();
+    std::vector<GLuint> cubeIndices(cubeLod.levels[0].count);
+    for (int i = 0; i < cubeLod.levels[0].count; i++)
+        cubeIndices[i] = cubeLod.levels[0].first + i;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources.get(EBO));
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, cubeIndices.size() * sizeof(GLuint), cubeIndices.data(), GL_STATIC_DRAW);
+    
+    // GPU 剔除：立方体的模型矩阵和包围球放进 SSBO，物体编号属性在 location = 2
+    // 设置了 GPU_CULLING 环境变量时一开始就开启
+    GpuCuller gpuCuller;
+    gpuCuller.init(resources.get(VAO), (GLsizei)cubeIndices.size(), cubeLod.center, cubeLod.radius, 2);
+    for (unsigned int i = 0; i < cubeCount; i++)
+        gpuCuller.addObject(scene.world(cubeNodes[i]));
+    int indirectShader = -1;
+    unsigned int indirectProgram = 0;
+    if (gpuCuller.gpuDriven())
+        indirectShader = shaders->load(SHADER_DIR + "camera_indirect.vs", SHADER_DIR + "camera.fs", constantDefines({ MIX_FACTOR }));
+    if (getenv("GPU_CULLING"))
+        gpuCulling = true;
+    
+    // 多视图程序：顶点着色器能写 gl_Layer 时不需要几何着色器
+    // ARB 和 AMD 的扩展名不同，着色器按宏启用驱动实际支持的那个
+    const char *vertexLayerExtension = multiViewVertexLayerExtension();
+    bool vertexLayer = vertexLayerExtension != NULL;
+    std::string multiViewDefines = constantDefines({ MIX_FACTOR, ShaderConstant::Int("MULTI_VIEW_MAX", MULTI_VIEW_MAX) });
+    if (vertexLayer)
+    {
+        multiViewDefines += "#define VERTEX_LAYER\n";
+        multiViewDefines += strcmp(vertexLayerExtension, "GL_AMD_vertex_shader_layer") == 0 ? "#define VERTEX_LAYER_AMD\n" : "#define VERTEX_LAYER_ARB\n";
+    }
+    int multiViewShader = shaders->load(SHADER_DIR + "camera_multiview.vs", SHADER_DIR + "camera.fs", multiViewDefines,
+                                        vertexLayer ? "" : SHADER_DIR + "camera_multiview.gs");
+    unsigned int multiViewProgram = 0;
+    // 分屏的两个视图各占场景目标的一半(使用时按当前大小调整)，环境贴图 6 个面
+    MultiViewTarget splitTarget;
+    splitTarget.init(std::max(1, framebufferWidth / 2), framebufferHeight, 2);
+    MultiViewTarget probe;
+    probe.initCubemap(PROBE_SIZE);
+    // 所有立方体画到 views 的每个视图里，不做剔除和 LOD
+    auto drawMultiView = [&](const MultiView &views) {
+        glUseProgram(multiViewProgram);
+        views.apply(multiViewProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, resources.get(texture));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, resources.get(texture_sec));
+        glBindVertexArray(resources.get(VAO));
+        int modelLoc = glGetUniformLocation(multiViewProgram, "model");
+        for (unsigned int i = 0; i < cubeCount; i++)
+        {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(scene.world(cubeNodes[i])));
+            views.drawArrays(GL_TRIANGLES, cubeLod.levels[0].first, cubeLod.levels[0].count);
+        }
+    };
+    
     // 填充模式绘制
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     
     // 循环渲染，glfwWindowShouldClose获取窗口是否关闭
     while (!glfwWindowShouldClose(window))
     {
-        float currentFrame = static_cast<float>(glfwGetTime());
+        PROFILE_ZONE("Frame");
+        // 按帧节奏等待，延迟采样模式下尽量晚处理输入
+        framePacer.beginFrame();
+        // 上一帧的临时数据全部作废
+        frameArenaNextFrame();
+        float currentFrame = static_cast<float>(regressionTime());
         
-        //记录帧间距
-        deltaTime = currentFrame - lastFrame;
+        //记录帧间距，回归测试按固定的 1/60 秒走，否则用帧节奏给出的平稳间隔
+        deltaTime = regression.active ? currentFrame - lastFrame : static_cast<float>(framePacer.frameInterval());
         lastFrame = currentFrame;
         
-        // 输入检测
-        processInput(window);
+        // 输入检测，事件处理紧挨着输入采样，输入到交换的延迟从这里算起
+        {
+            PROFILE_ZONE("Input");
+            glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
+            processInput(window);
+            framePacer.inputSampled();
+        }
+
+        // 检查着色器编译/热重载，程序替换后重新设置纹理单元
+        if (shaders->update())
+        {
+            shaderProgram = shaders->program(cameraShader);
+            glUseProgram(shaderProgram);
+            glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
+            glUniform1i(glGetUniformLocation(shaderProgram, "texture2"), 1);
+            depthProgram = shaders->program(depthShader);
+            impostorProgram = shaders->program(impostorShader);
+            glUseProgram(impostorProgram);
+            glUniform1i(glGetUniformLocation(impostorProgram, "impostorTexture"), 0);
+            if (indirectShader >= 0)
+            {
+                indirectProgram = shaders->program(indirectShader);
+                glUseProgram(indirectProgram);
+                glUniform1i(glGetUniformLocation(indirectProgram, "texture1"), 0);
+                glUniform1i(glGetUniformLocation(indirectProgram, "texture2"), 1);
+            }
+            multiViewProgram = shaders->program(multiViewShader);
+            if (multiViewProgram)
+            {
+                glUseProgram(multiViewProgram);
+                glUniform1i(glGetUniformLocation(multiViewProgram, "texture1"), 0);
+                glUniform1i(glGetUniformLocation(multiViewProgram, "texture2"), 1);
+            }
+            // 立方体着色器变了，替身重新渲染：正交投影正好框住包围球，从正面看
+            // 画完恢复到当前的窗口大小(窗口可能已经改过大小)
+            if (shaderProgram)
+            {
+                impostor.bake([&]() {
+                    float r = cubeLod.radius;
+                    glm::mat4 bakeView = glm::lookAt(cubeLod.center + glm::vec3(0.0f, 0.0f, 2.0f * r), cubeLod.center, glm::vec3(0.0f, 1.0f, 0.0f));
+                    glm::mat4 bakeProjection = glm::ortho(-r, r, -r, r, 0.0f, 4.0f * r);
+                    glm::mat4 bakeModel = glm::mat4(1.0f);
+                    glUseProgram(shaderProgram);
+                    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &bakeModel[0][0]);
+                    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &bakeView[0][0]);
+                    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &bakeProjection[0][0]);
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, resources.get(texture));
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, resources.get(texture_sec));
+                    glBindVertexArray(resources.get(VAO));
+                    glDrawArrays(GL_TRIANGLES, cubeLod.levels[0].first, cubeLod.levels[0].count);
+                }, regressionDefaultFramebuffer(), framebufferWidth, framebufferHeight);
+            }
+        }
 
         // 渲染
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f); // 设置清空屏幕所用的颜色
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // 用上面设置的颜色清空屏幕， 同时清空深度缓存
         
-        // 绑定纹理
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture_sec);
+        // 着色器还在后台编译时这一帧只清屏，帧末尾的统计、录制、资源回收照常进行
+        bool sceneDrawn = shaderProgram != 0;
+        if (sceneDrawn)
+        {
+            // GPU 计时从这里开始
+            int sceneZone = gpuProfiler.beginZone("Scene");
+            // 动态分辨率开启时场景画到缩放后的离屏目标
+            if (dynamicResolutionEnabled)
+                dynamicResolution.begin();
+            // 热力图模式下场景画到它的离屏目标，模板缓冲统计每个像素着色了几次
+            if (overdrawEnabled)
+                overdraw.begin();
+        
+            // 绑定纹理
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, resources.get(texture));
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, resources.get(texture_sec));
     
-        // 使用挂载了着色器的程序对象
-        glUseProgram(shaderProgram);
+            // 使用挂载了着色器的程序对象
+            glUseProgram(shaderProgram);
         
-        // 创建模型矩阵
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp); // 创建一个观察矩阵，模拟摄像机
-        glm::mat4 projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f); //定义一个投影矩阵
-        // 查找uniform变量地址
-        int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, &projection[0][0]);
+            // 创建模型矩阵
+            glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp); // 创建一个观察矩阵，模拟摄像机
+            glm::mat4 projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f); //定义一个投影矩阵
+            // 查找uniform变量地址
+            int viewLoc = glGetUniformLocation(shaderProgram, "view");
+            int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
+            glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
+            glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, &projection[0][0]);
         
-        //绑定顶点数组
-        glBindVertexArray(VAO);
+            //绑定顶点数组
+            glBindVertexArray(resources.get(VAO));
         
-        // 循环创建多个立方体
-        for(unsigned int i = 0; i < 10; i++)
+            // 更新旋转的立方体，不转的(第一个)保持不变，不会被重新计算
+            for(unsigned int i = 0; i < cubeCount; i++)
+            {
+              float speed = i * 20.0f;
+              if (speed == 0.0f)
+                continue;
+              glm::mat4 model = glm::mat4(1.0f);
+              model = glm::translate(model, cubePositions[i]);
+              float angle = (float)currentFrame * speed;
+              model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+              scene.setLocal(cubeNodes[i], model);
+            }
+            // 只重新计算改过的节点的世界矩阵
+            {
+              PROFILE_ZONE("SceneUpdate");
+              scene.update();
+            }
+            // 变了的世界矩阵同步给 GPU 剔除，下次 draw 时只上传这些
+            for (unsigned int i = 0; i < cubeCount; i++)
+            {
+              if (scene.worldChanged(cubeNodes[i]))
+                gpuCuller.setTransform(i, scene.world(cubeNodes[i]));
+            }
+        
+            // 当前的场景目标，动态分辨率开启时是它的离屏目标
+            GLint sceneFramebuffer = 0;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &sceneFramebuffer);
+            int sceneWidth = dynamicResolutionEnabled ? dynamicResolution.getRenderWidth() : framebufferWidth;
+            int sceneHeight = dynamicResolutionEnabled ? dynamicResolution.getRenderHeight() : framebufferHeight;
+        
+            // 环境贴图：6 个面一次提交，原来要把整个场景画 6 遍
+            if (captureProbe && multiViewProgram)
+            {
+              PROFILE_ZONE("ProbeCapture");
+              int probeZone = gpuProfiler.beginZone("ProbeCapture");
+              MultiView probeViews;
+              probeViews.setCubemap(cameraPos, 0.1f, 100.0f);
+              probe.begin();
+              drawMultiView(probeViews);
+              probe.end(sceneFramebuffer, sceneWidth, sceneHeight);
+              gpuProfiler.endZone(probeZone);
+              captureProbe = false;
+            }
+        
+            // 分屏：左边主视角，右边从上方俯视摄像机，两个视图一次提交，画完按层拼到场景目标上
+            bool multiViewFrame = splitScreen && multiViewProgram != 0;
+            if (multiViewFrame)
+            {
+              PROFILE_ZONE("SplitScreen");
+              // 每个视图占场景目标的一半，窗口大小或渲染分辨率变了就重建
+              splitTarget.resize(std::max(1, sceneWidth / 2), sceneHeight);
+              float halfAspect = (float)splitTarget.getWidth() / (float)splitTarget.getHeight();
+              glm::mat4 halfProjection = glm::perspective(glm::radians(fov), halfAspect, 0.1f, 100.0f);
+              glm::mat4 topView = glm::lookAt(cameraPos + glm::vec3(0.0f, 12.0f, 0.0f), cameraPos, glm::vec3(0.0f, 0.0f, -1.0f));
+              MultiView splitViews;
+              splitViews.add(halfProjection * view);
+              splitViews.add(halfProjection * topView);
+              splitTarget.begin();
+              drawMultiView(splitViews);
+              splitTarget.end(sceneFramebuffer, sceneWidth, sceneHeight);
+              splitTarget.blitLayer(0, sceneFramebuffer, 0, 0, sceneWidth / 2, sceneHeight);
+              splitTarget.blitLayer(1, sceneFramebuffer, sceneWidth / 2, 0, sceneWidth - sceneWidth / 2, sceneHeight);
+              glUseProgram(shaderProgram);
+            }
+        
+            // GPU 驱动：一次计算着色器调度剔除，一次间接绘制，CPU 开销和立方体数量无关
+            // 这条路径不做软件遮挡剔除和 LOD，立方体都用 LOD0
+            bool gpuDrivenFrame = !multiViewFrame && gpuCulling && gpuCuller.gpuDriven() && indirectProgram != 0;
+            if (gpuDrivenFrame)
+            {
+              PROFILE_ZONE("GpuDrivenDraw");
+              glUseProgram(indirectProgram);
+              glUniformMatrix4fv(glGetUniformLocation(indirectProgram, "view"), 1, GL_FALSE, &view[0][0]);
+              glUniformMatrix4fv(glGetUniformLocation(indirectProgram, "projection"), 1, GL_FALSE, &projection[0][0]);
+              gpuCuller.draw(projection * view, indirectProgram, -1);
+            }
+        
+            // 每帧的临时数据都从帧分配器分配，不访问堆
+
+            // 软件遮挡剔除：先把最近的几个立方体画进CPU深度缓冲，其余立方体用包围盒去查询
+            FrameVector<uint8_t> isOccluder(cubeCount, 0);
+            if (occlusionCulling && !gpuDrivenFrame && !multiViewFrame)
+            {
+              PROFILE_ZONE("OcclusionCulling");
+              glm::mat4 viewProjection = projection * view;
+              occlusionCuller.beginFrame();
+              for (unsigned int n = 0; n < NUM_OCCLUDERS; n++)
+              {
+                int nearest = -1;
+                float nearestDistance = 0.0f;
+                for (unsigned int i = 0; i < cubeCount; i++)
+                {
+                  float distance = glm::length(glm::vec3(scene.world(cubeNodes[i])[3]) - cameraPos);
+                  if (!isOccluder[i] && (nearest < 0 || distance < nearestDistance))
+                  {
+                    nearest = i;
+                    nearestDistance = distance;
+                  }
+                }
+                isOccluder[nearest] = true;
+                occlusionCuller.rasterizeOccluder(vertices, 5, 36, viewProjection * scene.world(cubeNodes[nearest]));
+              }
+              occlusionCuller.endOccluders();
+            }
+        
+            // 绘制列表，被遮挡的立方体不放进去
+            FrameVector<unsigned int> drawList;
+            drawList.reserve(cubeCount);
+            if (!gpuDrivenFrame && !multiViewFrame)
+            {
+              for(unsigned int i = 0; i < cubeCount; i++)
+              {
+                if (occlusionCulling && !isOccluder[i] &&
+                    !occlusionCuller.isVisible(glm::vec3(-0.5f), glm::vec3(0.5f), projection * view * scene.world(cubeNodes[i])))
+                  continue;
+                drawList.push_back(i);
+              }
+            }
+        
+            // 按在场景目标上的大小选 LOD 级别(跟着窗口和动态分辨率变)，太小的放进替身列表，其余的按观察深度排序
+            FrameVector<unsigned int> impostorList;
+            FrameVector<unsigned int> opaqueList;
+            opaqueList.reserve(drawList.size());
+            depthSorter.clear();
+            for(unsigned int i : drawList)
+            {
+              glm::vec3 center = glm::vec3(scene.world(cubeNodes[i]) * glm::vec4(cubeLod.center, 1.0f));
+              float pixels = projectedSize(cubeLod.radius, glm::length(center - cameraPos), glm::radians(fov), (float)sceneHeight);
+              cubeLevels[i] = lodSelector.select(cubeLevels[i], pixels);
+              if (cubeLevels[i] == lodSelector.impostorLevel() && impostor.isBaked() && impostorProgram)
+              {
+                impostorList.push_back(i);
+                continue;
+              }
+              opaqueList.push_back(i);
+              // 观察空间里摄像机看向 -z
+              depthSorter.add(i, -(view * glm::vec4(center, 1.0f)).z);
+            }
+            if (depthSorting)
+            {
+              PROFILE_ZONE("DepthSort");
+              const std::vector<uint32_t> &sorted = depthSorter.sortFrontToBack();
+              opaqueList.assign(sorted.begin(), sorted.end());
+            }
+            else if (hardwareOcclusion)
+            {
+              // 不排序时也要拿最近的几个当遮挡体：挪到列表前面，其余的保持原来的顺序
+              const std::vector<uint32_t> &nearest = depthSorter.nearest(NUM_OCCLUDERS);
+              for (size_t n = 0; n < nearest.size(); n++)
+              {
+                auto found = std::find(opaqueList.begin() + n, opaqueList.end(), nearest[n]);
+                std::rotate(opaqueList.begin() + n, found, found + 1);
+              }
+            }
+            // 硬件遮挡查询：列表前面最近的几个当遮挡体直接画，后面的画完包围盒查询再按结果画
+            size_t occluderCount = hardwareOcclusion ? std::min<size_t>(NUM_OCCLUDERS, opaqueList.size()) : opaqueList.size();
+            if (hardwareOcclusion)
+              occlusionQueries.beginFrame();
+            auto drawOpaque = [&](int modelLoc, size_t first, size_t last, bool conditional) {
+              for(size_t n = first; n < last; n++)
+              {
+                unsigned int i = opaqueList[n];
+                if (conditional && !occlusionQueries.beginObject(i))
+                  continue;
+                const LodLevel &level = cubeLod.levels[std::min(cubeLevels[i], (int)cubeLod.levels.size() - 1)];
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(scene.world(cubeNodes[i])));
+      
+                glDrawArrays(GL_TRIANGLES, level.first, level.count);
+                if (conditional)
+                  occlusionQueries.endObject();
+              }
+            };
+            // 包围盒查询会换掉程序和 VAO，之后重新绑定
+            auto issueOcclusionQueries = [&](unsigned int program) {
+              PROFILE_ZONE("OcclusionQueries");
+              occlusionQueries.beginQueries();
+              for(size_t n = occluderCount; n < opaqueList.size(); n++)
+                occlusionQueries.query(opaqueList[n], projection * view * scene.world(cubeNodes[opaqueList[n]]));
+              occlusionQueries.endQueries();
+              glUseProgram(program);
+              glBindVertexArray(resources.get(VAO));
+            };
+            bool queryFrame = hardwareOcclusion && occluderCount < opaqueList.size();
+            // 深度预渲染：第一遍只写深度，第二遍只有最近的片元通过 GL_EQUAL，贵的片元着色器每个像素只跑一次
+            bool prepassFrame = depthPrepass && depthProgram != 0 && !opaqueList.empty();
+            if (prepassFrame)
+            {
+              PROFILE_ZONE("DepthPrepass");
+              depthPrepassBegin();
+              glUseProgram(depthProgram);
+              glUniformMatrix4fv(glGetUniformLocation(depthProgram, "view"), 1, GL_FALSE, &view[0][0]);
+              glUniformMatrix4fv(glGetUniformLocation(depthProgram, "projection"), 1, GL_FALSE, &projection[0][0]);
+              int depthModelLoc = glGetUniformLocation(depthProgram, "model");
+              // 包围盒只对着遮挡体的深度查询：被查询的立方体自己的深度和包围盒完全重合，先写进去就会拿自己挡自己
+              drawOpaque(depthModelLoc, 0, occluderCount, false);
+              if (queryFrame)
+                issueOcclusionQueries(depthProgram);
+              drawOpaque(depthModelLoc, occluderCount, opaqueList.size(), queryFrame);
+              depthPrepassShade();
+              glUseProgram(shaderProgram);
+            }
+            {
+              PROFILE_ZONE("Draw");
+              int modelLoc = glGetUniformLocation(shaderProgram, "model");
+              drawOpaque(modelLoc, 0, occluderCount, false);
+              if (queryFrame && !prepassFrame)
+                issueOcclusionQueries(shaderProgram);
+              drawOpaque(modelLoc, occluderCount, opaqueList.size(), queryFrame);
+            }
+            if (prepassFrame)
+              depthPrepassEnd();
+            // 替身一起画，每个只有两个三角形
+            if (!impostorList.empty())
+            {
+              PROFILE_ZONE("Impostors");
+              glUseProgram(impostorProgram);
+              glActiveTexture(GL_TEXTURE0);
+              glBindTexture(GL_TEXTURE_2D, impostor.getTexture());
+              glUniformMatrix4fv(glGetUniformLocation(impostorProgram, "view"), 1, GL_FALSE, &view[0][0]);
+              glUniformMatrix4fv(glGetUniformLocation(impostorProgram, "projection"), 1, GL_FALSE, &projection[0][0]);
+              glUniform1f(glGetUniformLocation(impostorProgram, "halfSize"), cubeLod.radius);
+              int centerLoc = glGetUniformLocation(impostorProgram, "center");
+              for(unsigned int i : impostorList)
+              {
+                glm::vec3 center = glm::vec3(scene.world(cubeNodes[i]) * glm::vec4(cubeLod.center, 1.0f));
+                glUniform3fv(centerLoc, 1, &center[0]);
+                impostor.drawQuad();
+              }
+            }
+        
+            // 不使用索引缓冲EBO,可以直接绘制顶点
+            // glDrawArrays(GL_TRIANGLES, 0, 36);
+            // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
+            // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            // 用热力图代替场景画面
+            if (overdrawEnabled)
+                overdraw.end();
+            // 离屏目标拉伸到窗口
+            if (dynamicResolutionEnabled)
+                dynamicResolution.end(regressionDefaultFramebuffer());
+            gpuProfiler.endZone(sceneZone);
+        }
+        // 读回几帧之前的 GPU 计时
+        gpuProfiler.endFrame();
+        // 删除 GPU 已经用完的资源
+        resources.endFrame();
+        // 每帧的 OpenGL 调用计数，每隔一段时间显示在标题栏上
+        if (glIntercept.installed)
         {
-          glm::mat4 model = glm::mat4(1.0f);
-          model = glm::translate(model, cubePositions[i]);
-          float angle = (float)currentFrame * i * 20.0;
-          model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-          int modelLoc = glGetUniformLocation(shaderProgram, "model");
-          glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    
-          glDrawArrays(GL_TRIANGLES, 0, 36);
+            static unsigned int counterFrames = 0;
+            const GLFrameCounters &counters = glInterceptEndFrame();
+            if (counterFrames++ % 30 == 0)
+            {
+                FrameArenaStats arenaStats = frameArenaStats();
+                char title[320];
+                snprintf(title, sizeof(title), "LearnOpenGL | draws %llu  dispatch %llu  tris %llu  state %llu  buffer %lluB  texture %lluB  uniformLoc %llu  arena %zuB/%zuB",
+                         (unsigned long long)counters.drawCalls, (unsigned long long)counters.dispatches, (unsigned long long)counters.triangles,
+                         (unsigned long long)counters.stateChanges, (unsigned long long)counters.bufferBytes,
+                         (unsigned long long)counters.textureBytes, (unsigned long long)counters.uniformLocationQueries,
+                         arenaStats.used, arenaStats.highWater);
+                glfwSetWindowTitle(window, title);
+            }
         }
-        
-        // 不使用索引缓冲EBO,可以直接绘制顶点
-        // glDrawArrays(GL_TRIANGLES, 0, 36);
-        // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
-        // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        // 热力图模式下标题栏显示重复着色的统计，最大值饱和时显示为 N+
+        else if (overdrawEnabled)
+        {
+            static unsigned int overdrawFrames = 0;
+            if (overdrawFrames++ % 30 == 0)
+            {
+                char title[160];
+                snprintf(title, sizeof(title), "LearnOpenGL | overdraw avg %.2f (covered pixels %.2f)  max %d%s",
+                         overdraw.getAverage(), overdraw.getCoveredAverage(), overdraw.getMax(), overdraw.isMaxSaturated() ? "+" : "");
+                glfwSetWindowTitle(window, title);
+            }
+        }
+        // 没有调用计数时标题栏显示帧节奏和输入延迟
+        else
+        {
+            static unsigned int pacingFrames = 0;
+            if (pacingFrames++ % 30 == 0)
+            {
+                FramePacingStats pacingStats = framePacer.stats();
+                char title[160];
+                snprintf(title, sizeof(title), "LearnOpenGL | %s  interval %.2f±%.2fms  latency %.2fms (p99 %.2fms)",
+                         framePacingModeName(framePacer.getMode()), pacingStats.intervalMs, pacingStats.intervalJitterMs,
+                         pacingStats.latencyMs, pacingStats.latencyP99Ms);
+                glfwSetWindowTitle(window, title);
+            }
+        }
+        // 录制范围结束后自动写文件
+        glCaptureEndFrame();
+        // 读回这一帧，几帧之后由后台线程编码写文件
+        if (frameExporter.isActive())
+        {
+            frameExporter.capture(regressionDefaultFramebuffer());
+            if (exportFrames && frameExporter.getStats().captured >= exportFrames)
+                glfwSetWindowShouldClose(window, true);
+        }
+        // 回归测试跑完固定帧数后退出，只清屏的帧不计数，固定步长的时钟和截图的帧号不受编译快慢影响
+        if (regressionEndFrame(sceneDrawn))
+            glfwSetWindowShouldClose(window, true);
     
-        glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
-        glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
+        PROFILE_ZONE("SwapBuffers");
+        framePacer.present(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
     }
-    // 删除顶点数组
-    glDeleteVertexArrays(1, &VAO);
-    // 删除缓冲数组
-    glDeleteBuffers(1, &VBO);
+    // 设置了 PROFILE_TRACE 环境变量时导出 trace，用 chrome://tracing 或 ui.perfetto.dev 打开
+    if (const char *tracePath = getenv("PROFILE_TRACE"))
+        Profiler::instance().writeChromeTrace(tracePath);
+    // 帧分配器的峰值，用来调整初始块大小
+    FrameArenaStats arenaStats = frameArenaStats();
+    std::cout << "Frame arena high water " << arenaStats.highWater << " bytes, capacity " << arenaStats.capacity
+              << " bytes, " << arenaStats.heapAllocations << " heap allocations" << std::endl;
+    // 帧节奏统计
+    FramePacingStats pacingStats = framePacer.stats();
+    std::cout << "Frame pacing " << framePacingModeName(framePacer.getMode()) << ": interval " << pacingStats.intervalMs
+              << " ms (jitter " << pacingStats.intervalJitterMs << " ms), input latency " << pacingStats.latencyMs
+              << " ms (p99 " << pacingStats.latencyP99Ms << " ms)" << std::endl;
+    framePacer.release();
+    // 等导出的帧全部写完
+    frameExporter.finish();
+    gpuProfiler.release();
+    dynamicResolution.release();
+    overdraw.release();
+    // 硬件遮挡查询统计
+    OcclusionQueryStats queryStats = occlusionQueries.getStats();
+    std::cout << "Occlusion queries " << queryStats.queries << " issued, " << queryStats.occluded << " occluded, "
+              << queryStats.skipped << " skipped near plane, pool " << queryStats.poolSize << std::endl;
+    occlusionQueries.release();
+    impostor.release();
+    gpuCuller.release();
+    splitTarget.release();
+    probe.release();
+    // 删除顶点数组、缓冲和纹理
+    resources.destroy(VAO);
+    resources.destroy(VBO);
+    resources.destroy(EBO);
+    TextureCacheStats textureStats = textureCache.getStats();
+    std::cout << "Texture cache " << textureStats.textures << " textures, " << textureStats.residentBytes << " bytes (peak "
+              << textureStats.peakBytes << "), " << textureStats.hits << " hits, " << textureStats.dedupes << " dedupes, "
+              << textureStats.mipDrops << " mip drops, " << textureStats.evictions << " evictions" << std::endl;
+    textureCache.release(texture);
+    textureCache.release(texture_sec);
+    textureCache.clear();
+    resources.release();
     // 删除程序对象
-    glDeleteProgram(shaderProgram);
+    delete shaders;
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }
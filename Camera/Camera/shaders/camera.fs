@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+#include "texture_mix.glsl"
+void main()
+{
+  FragColor = mixTextures(TexCoord);
+}
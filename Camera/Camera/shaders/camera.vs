@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+out vec2 TexCoord;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+// 深度预渲染和着色两遍的深度要逐位相同，GL_EQUAL 才能通过
+invariant gl_Position;
+void main()
+{
+   gl_Position = projection * view * model * vec4(aPos, 1.0);
+   TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+}
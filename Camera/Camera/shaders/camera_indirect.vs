@@ -0,0 +1,19 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in uint aObjectId;
+// GPU 剔除的物体数据，模型矩阵按物体编号读取
+struct GpuCullObject
+{
+   mat4 model;
+   vec4 sphere;
+};
+layout (std430, binding = 0) readonly buffer Objects { GpuCullObject objects[]; };
+out vec2 TexCoord;
+uniform mat4 view;
+uniform mat4 projection;
+void main()
+{
+   gl_Position = projection * view * objects[aObjectId].model * vec4(aPos, 1.0);
+   TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+// 只转发三角形，按顶点着色器选的视图写 gl_Layer
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+in vec2 vTexCoord[];
+flat in int vLayer[];
+out vec2 TexCoord;
+void main()
+{
+   for (int i = 0; i < 3; i++)
+   {
+      gl_Layer = vLayer[i];
+      gl_Position = gl_in[i].gl_Position;
+      TexCoord = vTexCoord[i];
+      EmitVertex();
+   }
+   EndPrimitive();
+}
@@ -0,0 +1,35 @@
+#version 330 core
+// 多视图：每个视图一个实例，VERTEX_LAYER 由 C++ 端在驱动支持时注入，这时不需要几何着色器
+// 驱动给的是哪个扩展就启用哪个，VERTEX_LAYER_ARB / VERTEX_LAYER_AMD 同样由 C++ 端注入
+#ifdef VERTEX_LAYER_ARB
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#ifdef VERTEX_LAYER_AMD
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+#ifndef MULTI_VIEW_MAX
+#define MULTI_VIEW_MAX 6
+#endif
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+#ifdef VERTEX_LAYER
+out vec2 TexCoord;
+#else
+out vec2 vTexCoord;
+flat out int vLayer;
+#endif
+uniform mat4 model;
+uniform mat4 viewProjections[MULTI_VIEW_MAX];
+uniform int viewCount;
+void main()
+{
+   int view = gl_InstanceID % viewCount;
+   gl_Position = viewProjections[view] * model * vec4(aPos, 1.0);
+#ifdef VERTEX_LAYER
+   gl_Layer = view;
+   TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+#else
+   vTexCoord = vec2(aTexCoord.x, aTexCoord.y);
+   vLayer = view;
+#endif
+}
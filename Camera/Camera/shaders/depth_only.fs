@@ -0,0 +1,5 @@
+#version 330 core
+// 深度预渲染：只写深度，不输出颜色
+void main()
+{
+}
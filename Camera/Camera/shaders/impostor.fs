@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+uniform sampler2D impostorTexture;
+void main()
+{
+  vec4 color = texture(impostorTexture, TexCoord);
+  // 替身纹理里物体以外的部分是透明的
+  if (color.a < 0.5)
+    discard;
+  FragColor = vec4(color.rgb, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+out vec2 TexCoord;
+uniform vec3 center;
+uniform float halfSize;
+uniform mat4 view;
+uniform mat4 projection;
+void main()
+{
+   // 在观察空间里展开四边形，始终朝向摄像机
+   vec4 viewPos = view * vec4(center, 1.0);
+   viewPos.xy += aCorner * halfSize;
+   gl_Position = projection * viewPos;
+   TexCoord = aCorner * 0.5 + 0.5;
+}
@@ -0,0 +1,10 @@
+// 两张纹理按比例混合，MIX_FACTOR 由 C++ 端以 #define 注入
+#ifndef MIX_FACTOR
+#define MIX_FACTOR 0.4
+#endif
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+vec4 mixTextures(vec2 uv)
+{
+  return mix(texture(texture1, uv), texture(texture2, uv), MIX_FACTOR);
+}
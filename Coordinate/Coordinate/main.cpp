@@ -14,6 +14,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "../../common/regression.h"
+#include "../../common/gpu_culling.h"
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
 void processInput(GLFWwindow *window)
@@ -56,6 +58,21 @@ const char *fragmentShaderSource = "#version 330 core\n"
     "{\n"
     "  FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.4);\n"
     "}\n\0";
+// GPU 驱动路径的顶点着色，模型矩阵按物体编号从 SSBO 读取
+const char *indirectVertexShaderSource = "#version 430 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec2 aTexCoord;\n"
+    "layout (location = 2) in uint aObjectId;\n"
+    "struct GpuCullObject { mat4 model; vec4 sphere; };\n"
+    "layout (std430, binding = 0) readonly buffer Objects { GpuCullObject objects[]; };\n"
+    "out vec2 TexCoord;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = projection * view * objects[aObjectId].model * vec4(aPos, 1.0);\n"
+    "   TexCoord = vec2(aTexCoord.x, aTexCoord.y);\n"
+    "}\0";
 
 int main()
 {
@@ -68,6 +85,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("Coordinate");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -87,6 +106,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
     // 开启深度测试，遮挡z值较小的内容
     glEnable(GL_DEPTH_TEST);
     
@@ -130,7 +151,6 @@ int main()
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
     glDeleteShader(vertexShader);  // 挂载后删除顶点着色器
-    glDeleteShader(fragmentShader);// 挂载后删除片元着色器
 
     
     // 加载纹理图片
@@ -250,16 +270,25 @@ int main()
       glm::vec3(-1.3f,  1.0f, -1.5f)
     };
     
-    unsigned int VBO, VAO;
+    // 去掉重复顶点改成索引绘制，间接绘制用的是 DrawElementsIndirectCommand
+    std::vector<float> indexedVertices;
+    std::vector<GLuint> indices;
+    buildIndexedMesh(vertices, 5, 36, indexedVertices, indices);
+    
+    unsigned int VBO, VAO, EBO;
     glGenVertexArrays(1, &VAO); // 创建一个顶点数组对象VAO
     glGenBuffers(1, &VBO); // 创建一个顶点缓冲对象VBO
+    glGenBuffers(1, &EBO); // 创建一个索引缓冲对象EBO
     
     // 绑定顶点数组对象
     glBindVertexArray(VAO);
     // 绑定顶点缓冲对象
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     // 将顶点数组复制到缓冲对象中
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, indexedVertices.size() * sizeof(float), indexedVertices.data(), GL_STATIC_DRAW);
+    // 索引缓冲记录在 VAO 里
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
     
     // 描述顶点结构：
     // 第一个参数：起始位置
@@ -279,6 +308,41 @@ int main()
     // 填充模式绘制
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     
+    // 剔除和提交交给 GpuCuller：支持 OpenGL 4.3 时由计算着色器剔除并间接绘制，否则 CPU 剔除
+    GpuCuller culler;
+    culler.init(VAO, (GLsizei)indices.size(), glm::vec3(0.0f), glm::length(glm::vec3(0.5f)), 2);
+    for(unsigned int i = 0; i < 10; i++)
+        culler.addObject(glm::translate(glm::mat4(1.0f), cubePositions[i]));
+    // GPU 路径的渲染程序，片元着色和普通路径共用
+    unsigned int indirectProgram = 0;
+    if (culler.gpuDriven())
+    {
+        unsigned int indirectShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(indirectShader, 1, &indirectVertexShaderSource, NULL);
+        glCompileShader(indirectShader);
+        glGetShaderiv(indirectShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(indirectShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        indirectProgram = glCreateProgram();
+        glAttachShader(indirectProgram, indirectShader);
+        glAttachShader(indirectProgram, fragmentShader);
+        glLinkProgram(indirectProgram);
+        glGetProgramiv(indirectProgram, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(indirectProgram, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(indirectShader);
+        glUseProgram(indirectProgram);
+        glUniform1i(glGetUniformLocation(indirectProgram, "texture1"), 0);
+        glUniform1i(glGetUniformLocation(indirectProgram, "texture2"), 1);
+    }
+    glDeleteShader(fragmentShader);// 挂载后删除片元着色器
+    unsigned int drawProgram = culler.gpuDriven() ? indirectProgram : shaderProgram;
+    
     // 循环渲染，glfwWindowShouldClose获取窗口是否关闭
     while (!glfwWindowShouldClose(window))
     {
@@ -296,7 +360,7 @@ int main()
         glBindTexture(GL_TEXTURE_2D, texture_sec);
     
         // 使用挂载了着色器的程序对象
-        glUseProgram(shaderProgram);
+        glUseProgram(drawProgram);
     
         // 创建一个模型矩阵
         glm::mat4 view = glm::mat4(1.0f); // 创建一个观察矩阵，模拟摄像机
@@ -304,33 +368,33 @@ int main()
         view  = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f)); // 将矩阵向我们要进行移动场景的反方向移动
         projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         // 查找uniform变量地址
-        int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
+        int modelLoc = glGetUniformLocation(drawProgram, "model");
+        int viewLoc = glGetUniformLocation(drawProgram, "view");
+        int projectionLoc = glGetUniformLocation(drawProgram, "projection");
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
         glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, &projection[0][0]);
         
-        //绑定顶点数组
-        glBindVertexArray(VAO);
-        
-        // 循环创建多个立方体
-        float time = glfwGetTime();
-        for(unsigned int i = 0; i < 10; i++)
+        // 更新多个立方体的模型矩阵，不转的(第一个)不用更新
+        float time = regressionTime();
+        for(unsigned int i = 1; i < 10; i++)
         {
           glm::mat4 model = glm::mat4(1.0f);
           model = glm::translate(model, cubePositions[i]);
           float angle = (float)time * i * 20.0;
           model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-          glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            
-          glDrawArrays(GL_TRIANGLES, 0, 36);
+          culler.setTransform(i, model);
         }
+        // 剔除并绘制，GPU 路径只有一次调度和一次间接绘制
+        culler.draw(projection * view, drawProgram, modelLoc);
         
         // 不使用索引缓冲EBO,可以直接绘制顶点
 //        glDrawArrays(GL_TRIANGLES, 0, 36);
         // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
         // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     
+        // 回归测试跑完固定帧数后退出
+        if (regressionEndFrame())
+            glfwSetWindowShouldClose(window, true);
         glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
         glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
     }
@@ -338,9 +402,14 @@ int main()
     glDeleteVertexArrays(1, &VAO);
     // 删除缓冲数组
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    culler.release();
     // 删除程序对象
     glDeleteProgram(shaderProgram);
+    if (indirectProgram)
+        glDeleteProgram(indirectProgram);
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }
@@ -0,0 +1,805 @@
+//
+//  main.cpp
+//  Replay
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../common/gl_capture.h"
+
+// 回放 gl_capture.h 录制的文件
+// 在隐藏窗口里执行一次初始化部分，然后循环回放录制的帧，每帧结束 glFinish，统计每帧的耗时
+// 没有应用逻辑，测到的是驱动开销和 GPU 耗时，可以在不同机器/驱动之间对比
+//
+// 用法：Replay capture.glcap [循环次数]
+// 录制的帧会被反复执行，录制范围内删除的对象在第二轮之后会失效，录制时应避开这类帧
+
+// 录制时的对象名 -> 回放时的对象名
+typedef std::unordered_map<GLuint, GLuint> NameMap;
+
+struct ReplayState
+{
+    NameMap vertexArrays, buffers, textures, framebuffers, renderbuffers, shaders, programs, queries;
+    std::unordered_map<uint64_t, GLsync> syncs; // 录制时的指针值 -> 回放时的同步对象
+    GLuint packBuffer = 0;                      // 回放时绑定的 GL_PIXEL_PACK_BUFFER，没有时读到 readback
+    std::vector<uint8_t> readback;
+    bool unknownOp = false;
+    // (录制时的程序, 录制时的 uniform 位置) -> 回放时的 uniform 位置
+    std::unordered_map<uint64_t, GLint> locations;
+    GLuint currentProgram = 0; // 录制时的名字
+};
+
+// 顺序读取一条记录的参数，和 gl_capture.h 的写入顺序一致
+struct RecordReader
+{
+    const uint8_t *data;
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+    const uint8_t *bytes(size_t size)
+    {
+        const uint8_t *p = data;
+        data += size;
+        return p;
+    }
+    std::string string()
+    {
+        uint32_t length = get<uint32_t>();
+        return std::string((const char *)bytes(length), length);
+    }
+};
+
+// 一条记录在文件中的位置
+struct Record
+{
+    uint16_t op;
+    const uint8_t *payload;
+};
+
+GLuint mapName(const NameMap &map, GLuint name)
+{
+    if (name == 0)
+        return 0;
+    auto it = map.find(name);
+    return it != map.end() ? it->second : 0;
+}
+
+GLint mapLocation(const ReplayState &state, GLint location)
+{
+    if (location < 0)
+        return location;
+    auto it = state.locations.find((uint64_t)state.currentProgram << 32 | (uint32_t)location);
+    return it != state.locations.end() ? it->second : -1;
+}
+
+// 生成对象，记录新旧名字的对应
+void genNames(RecordReader &in, NameMap &map, void (APIENTRY *gen)(GLsizei, GLuint *))
+{
+    GLsizei n = in.get<int32_t>();
+    std::vector<GLuint> names(n);
+    gen(n, names.data());
+    for (GLsizei i = 0; i < n; i++)
+        map[in.get<GLuint>()] = names[i];
+}
+
+void deleteNames(RecordReader &in, NameMap &map, void (APIENTRY *del)(GLsizei, const GLuint *))
+{
+    GLsizei n = in.get<int32_t>();
+    std::vector<GLuint> names(n);
+    for (GLsizei i = 0; i < n; i++)
+    {
+        GLuint recorded = in.get<GLuint>();
+        names[i] = mapName(map, recorded);
+        map.erase(recorded);
+    }
+    del(n, names.data());
+}
+
+void execute(const Record &record, ReplayState &state)
+{
+    RecordReader in = { record.payload };
+    switch (record.op)
+    {
+        case GLCAP_GEN_VERTEX_ARRAYS: genNames(in, state.vertexArrays, glad_glGenVertexArrays); break;
+        case GLCAP_GEN_BUFFERS: genNames(in, state.buffers, glad_glGenBuffers); break;
+        case GLCAP_GEN_TEXTURES: genNames(in, state.textures, glad_glGenTextures); break;
+        case GLCAP_GEN_FRAMEBUFFERS: genNames(in, state.framebuffers, glad_glGenFramebuffers); break;
+        case GLCAP_GEN_RENDERBUFFERS: genNames(in, state.renderbuffers, glad_glGenRenderbuffers); break;
+        case GLCAP_DELETE_VERTEX_ARRAYS: deleteNames(in, state.vertexArrays, glad_glDeleteVertexArrays); break;
+        case GLCAP_DELETE_BUFFERS: deleteNames(in, state.buffers, glad_glDeleteBuffers); break;
+        case GLCAP_DELETE_TEXTURES: deleteNames(in, state.textures, glad_glDeleteTextures); break;
+        case GLCAP_DELETE_FRAMEBUFFERS: deleteNames(in, state.framebuffers, glad_glDeleteFramebuffers); break;
+        case GLCAP_DELETE_RENDERBUFFERS: deleteNames(in, state.renderbuffers, glad_glDeleteRenderbuffers); break;
+
+        case GLCAP_CREATE_SHADER:
+        {
+            GLenum type = in.get<GLenum>();
+            state.shaders[in.get<GLuint>()] = glCreateShader(type);
+            break;
+        }
+        case GLCAP_SHADER_SOURCE:
+        {
+            GLuint shader = mapName(state.shaders, in.get<GLuint>());
+            GLsizei count = in.get<int32_t>();
+            std::vector<std::string> strings(count);
+            std::vector<const GLchar *> pointers(count);
+            for (GLsizei i = 0; i < count; i++)
+            {
+                strings[i] = in.string();
+                pointers[i] = strings[i].c_str();
+            }
+            glShaderSource(shader, count, pointers.data(), NULL);
+            break;
+        }
+        case GLCAP_COMPILE_SHADER: glCompileShader(mapName(state.shaders, in.get<GLuint>())); break;
+        case GLCAP_DELETE_SHADER:
+        {
+            GLuint recorded = in.get<GLuint>();
+            glDeleteShader(mapName(state.shaders, recorded));
+            state.shaders.erase(recorded);
+            break;
+        }
+        case GLCAP_CREATE_PROGRAM: state.programs[in.get<GLuint>()] = glCreateProgram(); break;
+        case GLCAP_ATTACH_SHADER:
+        {
+            GLuint program = mapName(state.programs, in.get<GLuint>());
+            glAttachShader(program, mapName(state.shaders, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_LINK_PROGRAM:
+        {
+            GLuint program = mapName(state.programs, in.get<GLuint>());
+            glLinkProgram(program);
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                char infoLog[512];
+                glGetProgramInfoLog(program, 512, NULL, infoLog);
+                std::cout << "ERROR::REPLAY::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            }
+            break;
+        }
+        case GLCAP_DELETE_PROGRAM:
+        {
+            GLuint recorded = in.get<GLuint>();
+            glDeleteProgram(mapName(state.programs, recorded));
+            state.programs.erase(recorded);
+            break;
+        }
+        case GLCAP_USE_PROGRAM:
+            state.currentProgram = in.get<GLuint>();
+            glUseProgram(mapName(state.programs, state.currentProgram));
+            break;
+        case GLCAP_GET_UNIFORM_LOCATION:
+        {
+            GLuint program = in.get<GLuint>();
+            std::string name = in.string();
+            GLint recorded = in.get<GLint>();
+            if (recorded >= 0)
+                state.locations[(uint64_t)program << 32 | (uint32_t)recorded] =
+                    glGetUniformLocation(mapName(state.programs, program), name.c_str());
+            break;
+        }
+        case GLCAP_UNIFORM_1I:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            glUniform1i(location, in.get<GLint>());
+            break;
+        }
+        case GLCAP_UNIFORM_1F:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            glUniform1f(location, in.get<GLfloat>());
+            break;
+        }
+        case GLCAP_UNIFORM_2F:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            GLfloat x = in.get<GLfloat>(), y = in.get<GLfloat>();
+            glUniform2f(location, x, y);
+            break;
+        }
+        case GLCAP_UNIFORM_3F:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            GLfloat x = in.get<GLfloat>(), y = in.get<GLfloat>(), z = in.get<GLfloat>();
+            glUniform3f(location, x, y, z);
+            break;
+        }
+        case GLCAP_UNIFORM_4F:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            GLfloat x = in.get<GLfloat>(), y = in.get<GLfloat>(), z = in.get<GLfloat>(), w = in.get<GLfloat>();
+            glUniform4f(location, x, y, z, w);
+            break;
+        }
+        case GLCAP_UNIFORM_3FV:
+        case GLCAP_UNIFORM_4FV:
+        case GLCAP_UNIFORM_MATRIX_4FV:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            GLsizei count = in.get<int32_t>();
+            GLboolean transpose = in.get<uint8_t>();
+            int floats = record.op == GLCAP_UNIFORM_3FV ? 3 : record.op == GLCAP_UNIFORM_4FV ? 4 : 16;
+            // 负载不保证 4 字节对齐，先复制出来
+            std::vector<GLfloat> value(floats * count);
+            memcpy(value.data(), in.bytes(sizeof(GLfloat) * value.size()), sizeof(GLfloat) * value.size());
+            if (record.op == GLCAP_UNIFORM_3FV)
+                glUniform3fv(location, count, value.data());
+            else if (record.op == GLCAP_UNIFORM_4FV)
+                glUniform4fv(location, count, value.data());
+            else
+                glUniformMatrix4fv(location, count, transpose, value.data());
+            break;
+        }
+
+        case GLCAP_BIND_VERTEX_ARRAY: glBindVertexArray(mapName(state.vertexArrays, in.get<GLuint>())); break;
+        case GLCAP_BIND_BUFFER:
+        {
+            GLenum target = in.get<GLenum>();
+            GLuint buffer = mapName(state.buffers, in.get<GLuint>());
+            if (target == GL_PIXEL_PACK_BUFFER)
+                state.packBuffer = buffer;
+            glBindBuffer(target, buffer);
+            break;
+        }
+        case GLCAP_BUFFER_DATA:
+        {
+            GLenum target = in.get<GLenum>();
+            int64_t size = in.get<int64_t>();
+            GLenum usage = in.get<GLenum>();
+            bool hasData = in.get<uint8_t>() != 0;
+            glBufferData(target, size, hasData ? in.bytes(size) : NULL, usage);
+            break;
+        }
+        case GLCAP_BUFFER_SUB_DATA:
+        {
+            GLenum target = in.get<GLenum>();
+            int64_t offset = in.get<int64_t>();
+            int64_t size = in.get<int64_t>();
+            glBufferSubData(target, offset, size, in.bytes(size));
+            break;
+        }
+        case GLCAP_VERTEX_ATTRIB_POINTER:
+        {
+            GLuint index = in.get<GLuint>();
+            GLint size = in.get<GLint>();
+            GLenum type = in.get<GLenum>();
+            GLboolean normalized = in.get<GLboolean>();
+            GLsizei stride = in.get<GLsizei>();
+            uint64_t offset = in.get<uint64_t>();
+            glVertexAttribPointer(index, size, type, normalized, stride, (const void *)(uintptr_t)offset);
+            break;
+        }
+        case GLCAP_ENABLE_VERTEX_ATTRIB_ARRAY: glEnableVertexAttribArray(in.get<GLuint>()); break;
+        case GLCAP_DISABLE_VERTEX_ATTRIB_ARRAY: glDisableVertexAttribArray(in.get<GLuint>()); break;
+        case GLCAP_VERTEX_ATTRIB_DIVISOR:
+        {
+            GLuint index = in.get<GLuint>();
+            glVertexAttribDivisor(index, in.get<GLuint>());
+            break;
+        }
+
+        case GLCAP_ACTIVE_TEXTURE: glActiveTexture(in.get<GLenum>()); break;
+        case GLCAP_BIND_TEXTURE:
+        {
+            GLenum target = in.get<GLenum>();
+            glBindTexture(target, mapName(state.textures, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_TEX_PARAMETER_I:
+        {
+            GLenum target = in.get<GLenum>();
+            GLenum pname = in.get<GLenum>();
+            glTexParameteri(target, pname, in.get<GLint>());
+            break;
+        }
+        case GLCAP_TEX_IMAGE_2D:
+        {
+            GLenum target = in.get<GLenum>();
+            GLint level = in.get<GLint>(), internalFormat = in.get<GLint>();
+            GLsizei width = in.get<GLsizei>(), height = in.get<GLsizei>();
+            GLint border = in.get<GLint>();
+            GLenum format = in.get<GLenum>(), type = in.get<GLenum>();
+            uint64_t size = in.get<uint64_t>();
+            glTexImage2D(target, level, internalFormat, width, height, border, format, type, size ? in.bytes(size) : NULL);
+            break;
+        }
+        case GLCAP_TEX_SUB_IMAGE_2D:
+        {
+            GLenum target = in.get<GLenum>();
+            GLint level = in.get<GLint>(), x = in.get<GLint>(), y = in.get<GLint>();
+            GLsizei width = in.get<GLsizei>(), height = in.get<GLsizei>();
+            GLenum format = in.get<GLenum>(), type = in.get<GLenum>();
+            uint64_t size = in.get<uint64_t>();
+            glTexSubImage2D(target, level, x, y, width, height, format, type, in.bytes(size));
+            break;
+        }
+        case GLCAP_GENERATE_MIPMAP: glGenerateMipmap(in.get<GLenum>()); break;
+        case GLCAP_PIXEL_STORE_I:
+        {
+            GLenum pname = in.get<GLenum>();
+            glPixelStorei(pname, in.get<GLint>());
+            break;
+        }
+
+        case GLCAP_BIND_FRAMEBUFFER:
+        {
+            GLenum target = in.get<GLenum>();
+            glBindFramebuffer(target, mapName(state.framebuffers, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_FRAMEBUFFER_TEXTURE_2D:
+        {
+            GLenum target = in.get<GLenum>(), attachment = in.get<GLenum>(), textureTarget = in.get<GLenum>();
+            GLuint texture = mapName(state.textures, in.get<GLuint>());
+            glFramebufferTexture2D(target, attachment, textureTarget, texture, in.get<GLint>());
+            break;
+        }
+        case GLCAP_BIND_RENDERBUFFER:
+        {
+            GLenum target = in.get<GLenum>();
+            glBindRenderbuffer(target, mapName(state.renderbuffers, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_RENDERBUFFER_STORAGE:
+        {
+            GLenum target = in.get<GLenum>(), format = in.get<GLenum>();
+            GLsizei width = in.get<GLsizei>();
+            glRenderbufferStorage(target, format, width, in.get<GLsizei>());
+            break;
+        }
+        case GLCAP_FRAMEBUFFER_RENDERBUFFER:
+        {
+            GLenum target = in.get<GLenum>(), attachment = in.get<GLenum>(), renderbufferTarget = in.get<GLenum>();
+            glFramebufferRenderbuffer(target, attachment, renderbufferTarget, mapName(state.renderbuffers, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_BLIT_FRAMEBUFFER:
+        {
+            GLint v[8];
+            for (GLint &value : v)
+                value = in.get<GLint>();
+            GLbitfield mask = in.get<GLbitfield>();
+            glBlitFramebuffer(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], mask, in.get<GLenum>());
+            break;
+        }
+
+        case GLCAP_ENABLE: glEnable(in.get<GLenum>()); break;
+        case GLCAP_DISABLE: glDisable(in.get<GLenum>()); break;
+        case GLCAP_BLEND_FUNC:
+        {
+            GLenum s = in.get<GLenum>();
+            glBlendFunc(s, in.get<GLenum>());
+            break;
+        }
+        case GLCAP_DEPTH_FUNC: glDepthFunc(in.get<GLenum>()); break;
+        case GLCAP_DEPTH_MASK: glDepthMask(in.get<GLboolean>()); break;
+        case GLCAP_COLOR_MASK:
+        {
+            GLboolean r = in.get<GLboolean>(), g = in.get<GLboolean>(), b = in.get<GLboolean>(), a = in.get<GLboolean>();
+            glColorMask(r, g, b, a);
+            break;
+        }
+        case GLCAP_CULL_FACE: glCullFace(in.get<GLenum>()); break;
+        case GLCAP_POLYGON_MODE:
+        {
+            GLenum face = in.get<GLenum>();
+            glPolygonMode(face, in.get<GLenum>());
+            break;
+        }
+        case GLCAP_VIEWPORT:
+        {
+            GLint x = in.get<GLint>(), y = in.get<GLint>();
+            GLsizei width = in.get<GLsizei>(), height = in.get<GLsizei>();
+            glViewport(x, y, width, height);
+            break;
+        }
+        case GLCAP_CLEAR_COLOR:
+        {
+            GLfloat r = in.get<GLfloat>(), g = in.get<GLfloat>(), b = in.get<GLfloat>(), a = in.get<GLfloat>();
+            glClearColor(r, g, b, a);
+            break;
+        }
+        case GLCAP_CLEAR: glClear(in.get<GLbitfield>()); break;
+        case GLCAP_DRAW_ARRAYS:
+        {
+            GLenum mode = in.get<GLenum>();
+            GLint first = in.get<GLint>();
+            glDrawArrays(mode, first, in.get<GLsizei>());
+            break;
+        }
+        case GLCAP_DRAW_ELEMENTS:
+        {
+            GLenum mode = in.get<GLenum>();
+            GLsizei count = in.get<GLsizei>();
+            GLenum type = in.get<GLenum>();
+            glDrawElements(mode, count, type, (const void *)(uintptr_t)in.get<uint64_t>());
+            break;
+        }
+        case GLCAP_DRAW_ARRAYS_INSTANCED:
+        {
+            GLenum mode = in.get<GLenum>();
+            GLint first = in.get<GLint>();
+            GLsizei count = in.get<GLsizei>();
+            glDrawArraysInstanced(mode, first, count, in.get<GLsizei>());
+            break;
+        }
+        case GLCAP_DRAW_ELEMENTS_INSTANCED:
+        {
+            GLenum mode = in.get<GLenum>();
+            GLsizei count = in.get<GLsizei>();
+            GLenum type = in.get<GLenum>();
+            uint64_t offset = in.get<uint64_t>();
+            glDrawElementsInstanced(mode, count, type, (const void *)(uintptr_t)offset, in.get<GLsizei>());
+            break;
+        }
+
+        case GLCAP_UNIFORM_1UI:
+        {
+            GLint location = mapLocation(state, in.get<GLint>());
+            glUniform1ui(location, in.get<GLuint>());
+            break;
+        }
+        case GLCAP_BIND_BUFFER_BASE:
+        {
+            GLenum target = in.get<GLenum>();
+            GLuint index = in.get<GLuint>();
+            glBindBufferBase(target, index, mapName(state.buffers, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_VERTEX_ATTRIB_I_POINTER:
+        {
+            GLuint index = in.get<GLuint>();
+            GLint size = in.get<GLint>();
+            GLenum type = in.get<GLenum>();
+            GLsizei stride = in.get<GLsizei>();
+            uint64_t offset = in.get<uint64_t>();
+            glVertexAttribIPointer(index, size, type, stride, (const void *)(uintptr_t)offset);
+            break;
+        }
+        case GLCAP_DISPATCH_COMPUTE:
+        {
+            GLuint x = in.get<GLuint>();
+            GLuint y = in.get<GLuint>();
+            glDispatchCompute(x, y, in.get<GLuint>());
+            break;
+        }
+        case GLCAP_MEMORY_BARRIER: glMemoryBarrier(in.get<GLbitfield>()); break;
+        case GLCAP_MULTI_DRAW_ELEMENTS_INDIRECT:
+        {
+            GLenum mode = in.get<GLenum>();
+            GLenum type = in.get<GLenum>();
+            uint64_t offset = in.get<uint64_t>();
+            GLsizei count = in.get<GLsizei>();
+            glMultiDrawElementsIndirect(mode, type, (const void *)(uintptr_t)offset, count, in.get<GLsizei>());
+            break;
+        }
+
+        case GLCAP_TEX_IMAGE_3D:
+        {
+            GLenum target = in.get<GLenum>();
+            GLint level = in.get<GLint>();
+            GLint internalFormat = in.get<GLint>();
+            GLsizei width = in.get<GLsizei>();
+            GLsizei height = in.get<GLsizei>();
+            GLsizei depth = in.get<GLsizei>();
+            GLint border = in.get<GLint>();
+            GLenum format = in.get<GLenum>();
+            GLenum type = in.get<GLenum>();
+            uint64_t size = in.get<uint64_t>();
+            glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, size ? in.bytes(size) : NULL);
+            break;
+        }
+        case GLCAP_FRAMEBUFFER_TEXTURE:
+        {
+            GLenum target = in.get<GLenum>();
+            GLenum attachment = in.get<GLenum>();
+            GLuint texture = mapName(state.textures, in.get<GLuint>());
+            glFramebufferTexture(target, attachment, texture, in.get<GLint>());
+            break;
+        }
+        case GLCAP_FRAMEBUFFER_TEXTURE_LAYER:
+        {
+            GLenum target = in.get<GLenum>();
+            GLenum attachment = in.get<GLenum>();
+            GLuint texture = mapName(state.textures, in.get<GLuint>());
+            GLint level = in.get<GLint>();
+            glFramebufferTextureLayer(target, attachment, texture, level, in.get<GLint>());
+            break;
+        }
+
+        case GLCAP_CLEAR_STENCIL: glClearStencil(in.get<GLint>()); break;
+        case GLCAP_STENCIL_FUNC:
+        {
+            GLenum func = in.get<GLenum>();
+            GLint ref = in.get<GLint>();
+            glStencilFunc(func, ref, in.get<GLuint>());
+            break;
+        }
+        case GLCAP_STENCIL_OP:
+        {
+            GLenum stencilFail = in.get<GLenum>();
+            GLenum depthFail = in.get<GLenum>();
+            glStencilOp(stencilFail, depthFail, in.get<GLenum>());
+            break;
+        }
+        case GLCAP_STENCIL_MASK: glStencilMask(in.get<GLuint>()); break;
+
+        case GLCAP_GEN_QUERIES: genNames(in, state.queries, glad_glGenQueries); break;
+        case GLCAP_DELETE_QUERIES: deleteNames(in, state.queries, glad_glDeleteQueries); break;
+        // 回放自己用 GL_TIME_ELAPSED 量每帧的 GPU 耗时，同类查询不能嵌套，录制里的跳过
+        case GLCAP_BEGIN_QUERY:
+        {
+            GLenum target = in.get<GLenum>();
+            if (target != GL_TIME_ELAPSED)
+                glBeginQuery(target, mapName(state.queries, in.get<GLuint>()));
+            break;
+        }
+        case GLCAP_END_QUERY:
+        {
+            GLenum target = in.get<GLenum>();
+            if (target != GL_TIME_ELAPSED)
+                glEndQuery(target);
+            break;
+        }
+        case GLCAP_QUERY_COUNTER:
+        {
+            GLuint query = mapName(state.queries, in.get<GLuint>());
+            glQueryCounter(query, in.get<GLenum>());
+            break;
+        }
+        case GLCAP_BEGIN_CONDITIONAL_RENDER:
+        {
+            GLuint query = mapName(state.queries, in.get<GLuint>());
+            glBeginConditionalRender(query, in.get<GLenum>());
+            break;
+        }
+        case GLCAP_END_CONDITIONAL_RENDER: glEndConditionalRender(); break;
+
+        case GLCAP_READ_BUFFER: glReadBuffer(in.get<GLenum>()); break;
+        case GLCAP_READ_PIXELS:
+        {
+            GLint x = in.get<GLint>();
+            GLint y = in.get<GLint>();
+            GLsizei width = in.get<GLsizei>();
+            GLsizei height = in.get<GLsizei>();
+            GLenum format = in.get<GLenum>();
+            GLenum type = in.get<GLenum>();
+            uint64_t offset = in.get<uint64_t>();
+            // 录制时读到内存的，回放时读到临时内存(按每个像素最多 16 字节分配)
+            if (state.packBuffer)
+                glReadPixels(x, y, width, height, format, type, (void *)(uintptr_t)offset);
+            else
+            {
+                state.readback.resize((size_t)width * height * 16);
+                glReadPixels(x, y, width, height, format, type, state.readback.data());
+            }
+            break;
+        }
+        case GLCAP_MAP_BUFFER_RANGE:
+        {
+            GLenum target = in.get<GLenum>();
+            int64_t offset = in.get<int64_t>();
+            int64_t length = in.get<int64_t>();
+            glMapBufferRange(target, offset, length, in.get<GLbitfield>());
+            break;
+        }
+        case GLCAP_UNMAP_BUFFER: glUnmapBuffer(in.get<GLenum>()); break;
+        case GLCAP_FENCE_SYNC:
+        {
+            GLenum condition = in.get<GLenum>();
+            GLbitfield flags = in.get<GLbitfield>();
+            state.syncs[in.get<uint64_t>()] = glFenceSync(condition, flags);
+            break;
+        }
+        case GLCAP_CLIENT_WAIT_SYNC:
+        {
+            auto it = state.syncs.find(in.get<uint64_t>());
+            GLbitfield flags = in.get<GLbitfield>();
+            uint64_t timeout = in.get<uint64_t>();
+            if (it != state.syncs.end())
+                glClientWaitSync(it->second, flags, timeout);
+            break;
+        }
+        case GLCAP_DELETE_SYNC:
+        {
+            auto it = state.syncs.find(in.get<uint64_t>());
+            if (it != state.syncs.end())
+            {
+                glDeleteSync(it->second);
+                state.syncs.erase(it);
+            }
+            break;
+        }
+        case GLCAP_FLUSH: glFlush(); break;
+        case GLCAP_FINISH: glFinish(); break;
+        default:
+            // 比这个回放工具新的录制文件，提示一次
+            if (!state.unknownOp)
+                std::cout << "WARNING::REPLAY::UNKNOWN_OP " << record.op << ", replay may be incomplete" << std::endl;
+            state.unknownOp = true;
+            break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: Replay capture.glcap [loops]" << std::endl;
+        return -1;
+    }
+    int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 100;
+
+    // 整个文件读进内存，回放时不再有文件 IO
+    FILE *file = fopen(argv[1], "rb");
+    if (!file)
+    {
+        std::cout << "Failed to open " << argv[1] << std::endl;
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    std::vector<uint8_t> contents(fileSize > 0 ? fileSize : 0);
+    size_t readSize = fread(contents.data(), 1, contents.size(), file);
+    fclose(file);
+
+    GLCaptureHeader header;
+    if (readSize < sizeof(header) || memcmp(contents.data(), header.magic, sizeof(header.magic)) != 0)
+    {
+        std::cout << "Not a capture file: " << argv[1] << std::endl;
+        return -1;
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+
+    // 切分记录：第一个帧结束标记之前是初始化部分，之后每个标记结束一帧
+    std::vector<Record> prologue;
+    std::vector<std::vector<Record>> frames;
+    std::vector<Record> *current = &prologue;
+    size_t offset = sizeof(header);
+    while (offset + 6 <= readSize)
+    {
+        uint16_t op;
+        uint32_t size;
+        memcpy(&op, &contents[offset], 2);
+        memcpy(&size, &contents[offset + 2], 4);
+        if (offset + 6 + size > readSize)
+            break;
+        if (op == GLCAP_FRAME_END)
+        {
+            frames.emplace_back();
+            current = &frames.back();
+        }
+        else
+            current->push_back({ op, &contents[offset + 6] });
+        offset += 6 + size;
+    }
+    // 最后一个标记之后没有记录
+    if (!frames.empty() && frames.back().empty())
+        frames.pop_back();
+    if (frames.empty())
+    {
+        std::cout << "Capture contains no frames" << std::endl;
+        return -1;
+    }
+
+    // 录制里有 GPU 驱动剔除的调用时需要 4.3 的上下文
+    auto uses43 = [](const std::vector<Record> &records) {
+        for (const Record &record : records)
+            if (record.op == GLCAP_DISPATCH_COMPUTE || record.op == GLCAP_MULTI_DRAW_ELEMENTS_INDIRECT)
+                return true;
+        return false;
+    };
+    bool needs43 = uses43(prologue);
+    for (const std::vector<Record> &records : frames)
+        needs43 = needs43 || uses43(records);
+
+    // 隐藏窗口，大小和录制时的帧缓冲一样
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, needs43 ? 4 : 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GL_FALSE);
+    #endif
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow *window = glfwCreateWindow(header.width ? header.width : 800, header.height ? header.height : 600, "Replay", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    // 不等垂直同步，测的是真实耗时
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glExtensionsLoad((GLADloadproc)glfwGetProcAddress);
+    if (needs43 && !glExtensionsCompute())
+    {
+        std::cout << "Capture uses OpenGL 4.3 compute/indirect draws, not available here" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    ReplayState state;
+    for (const Record &record : prologue)
+        execute(record, state);
+    glFinish();
+
+    // 每帧 CPU 提交耗时、到 glFinish 返回的总耗时、GPU 耗时
+    size_t frameCount = frames.size();
+    std::vector<double> submitMs(frameCount, 0.0), totalMs(frameCount, 0.0), gpuMs(frameCount, 0.0);
+    std::vector<double> totalMin(frameCount, 1e30), totalMax(frameCount, 0.0);
+    GLuint query;
+    glGenQueries(1, &query);
+    for (int loop = 0; loop < loops; loop++)
+    {
+        for (size_t f = 0; f < frameCount; f++)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            for (const Record &record : frames[f])
+                execute(record, state);
+            glEndQuery(GL_TIME_ELAPSED);
+            auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            auto finished = std::chrono::steady_clock::now();
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+            double total = std::chrono::duration<double, std::milli>(finished - begin).count();
+            submitMs[f] += std::chrono::duration<double, std::milli>(submitted - begin).count();
+            totalMs[f] += total;
+            gpuMs[f] += elapsed / 1e6;
+            totalMin[f] = std::min(totalMin[f], total);
+            totalMax[f] = std::max(totalMax[f], total);
+            glfwSwapBuffers(window);
+        }
+        glfwPollEvents();
+    }
+    glDeleteQueries(1, &query);
+
+    printf("%s: %zu frames, %d loops, %ux%u\n", argv[1], frameCount, loops, header.width, header.height);
+    printf("frame  calls   submit(ms)  gpu(ms)  total(ms)  min(ms)  max(ms)\n");
+    double sumTotal = 0.0, sumSubmit = 0.0, sumGpu = 0.0;
+    for (size_t f = 0; f < frameCount; f++)
+    {
+        printf("%5zu  %5zu  %10.3f  %7.3f  %9.3f  %7.3f  %7.3f\n", f, frames[f].size(),
+               submitMs[f] / loops, gpuMs[f] / loops, totalMs[f] / loops, totalMin[f], totalMax[f]);
+        sumSubmit += submitMs[f];
+        sumGpu += gpuMs[f];
+        sumTotal += totalMs[f];
+    }
+    double samples = (double)frameCount * loops;
+    printf("average  submit %.3f ms  gpu %.3f ms  total %.3f ms\n", sumSubmit / samples, sumGpu / samples, sumTotal / samples);
+
+    glfwTerminate();
+    return 0;
+}
@@ -9,6 +9,8 @@
 #include <GLFW/glfw3.h>
 #include "stb_image.h"
 #include <iostream>
+#include "../../common/regression.h"
+#include "../../common/image_decoder.h"
 
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
@@ -65,6 +67,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("Texture");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -84,6 +88,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
     
     // 创建一个顶点着色器
     unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -128,11 +134,13 @@ int main()
     glDeleteShader(fragmentShader);// 挂载后删除片元着色器
 
     
-    // 加载纹理图片
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("/Users/wenqiang/Documents/work/OpenGL/work/Texture/Texture/container.jpg", &width, &height, &nrChannels, 0);
+    // 加载纹理图片，翻转、通道数都是这次解码的选项，GL 格式由解码结果给出
+    ImageDecodeOptions options;
+    options.rowAlignment = 4;  // 和 GL_UNPACK_ALIGNMENT 的默认值一致
+    DecodedImage image;
     // 加载失败处理
-    if (!data)
+    bool loaded1 = imageDecoder.decodeFile("/Users/wenqiang/Documents/work/OpenGL/work/Texture/Texture/container.jpg", options, image);
+    if (!loaded1)
     {
         std::cout << "Failed to load texture1" << std::endl;
     }
@@ -147,18 +155,20 @@ int main()
     // 有时纹理不能完整覆盖模型，可以设置纹理缩小、放大时的过滤选项， GL_NEAREST 中心点采样，GL_LINEAR 临近采样
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // 加载纹理图片数据data
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
-    glGenerateMipmap(GL_TEXTURE_2D);
-    // 释放图片资源
-    stbi_image_free(data);
+    // 加载纹理图片数据data，解码失败时不上传，纹理保持为空
+    if (loaded1)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, image.layout.glInternalFormat(), image.width, image.height, 0, image.layout.glFormat(), GL_UNSIGNED_BYTE, image.pixels.data());
+        // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
     
     // 加载第二个纹理图片
-    stbi_set_flip_vertically_on_load(true);  // 翻转第二张纹理
-    data= stbi_load("/Users/wenqiang/Documents/work/OpenGL/work/Texture/Texture/awesomeface.png",  &width, &height, &nrChannels, 0);
+    options.flipVertically = true;  // 翻转第二张纹理，只影响这一次解码
+    options.channels = 4;
     // 加载失败处理
-    if (!data)
+    bool loaded2 = imageDecoder.decodeFile("/Users/wenqiang/Documents/work/OpenGL/work/Texture/Texture/awesomeface.png", options, image);
+    if (!loaded2)
     {
         std::cout << "Failed to load texture2" << std::endl;
     }
@@ -173,12 +183,13 @@ int main()
     // 有时纹理不能完整覆盖模型，可以设置纹理缩小、放大时的过滤选项， GL_NEAREST 中心点采样，GL_LINEAR 临近采样
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // 加载纹理图片数据data
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
-    glGenerateMipmap(GL_TEXTURE_2D);
-    // 释放图片资源
-    stbi_image_free(data);
+    // 加载纹理图片数据data，解码失败时不上传，纹理保持为空
+    if (loaded2)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, image.layout.glInternalFormat(), image.width, image.height, 0, image.layout.glFormat(), GL_UNSIGNED_BYTE, image.pixels.data());
+        // 为当前绑定的纹理自动生成所有需要的多级渐远纹理
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
     
     // 应用着色器程序使纹理生效
     glUseProgram(shaderProgram);
@@ -278,6 +289,9 @@ int main()
         // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     
+        // 回归测试跑完固定帧数后退出
+        if (regressionEndFrame())
+            glfwSetWindowShouldClose(window, true);
         glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
         glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
     }
@@ -289,6 +303,7 @@ int main()
     // 删除程序对象
     glDeleteProgram(shaderProgram);
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }
@@ -14,6 +14,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "../../common/regression.h"
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
 void processInput(GLFWwindow *window)
@@ -70,6 +71,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("Transformation");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -89,6 +92,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
     
     // 创建一个顶点着色器
     unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -277,7 +282,7 @@ int main()
         glm::mat4 transform = glm::mat4(1.0f); // 声明一个单位矩阵
         transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, 0.0f)); // 将元素移动到中心
         // 根据渲染时间，sin函数的定义，其返回值的范围是 [-1, 1], 计算为 0 - 1 范围内的一个值
-        float time = float(glfwGetTime());
+        float time = float(regressionTime());
         float scale = (sin(time) / 2.0f) + 0.5f;
         transform = glm::rotate(transform, time, glm::vec3(0.0f, 1.0f, 1.0f)); // 绕Y、Z轴旋转,
         transform = glm::scale(transform, glm::vec3(scale, scale, scale)); // 三个轴的缩放
@@ -301,6 +306,9 @@ int main()
         // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     
+        // 回归测试跑完固定帧数后退出
+        if (regressionEndFrame())
+            glfwSetWindowShouldClose(window, true);
         glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
         glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
     }
@@ -312,6 +320,7 @@ int main()
     // 删除程序对象
     glDeleteProgram(shaderProgram);
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }
@@ -0,0 +1,276 @@
+//
+//  main.cpp
+//  VirtualTexture
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "stb_image.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../../common/virtual_texture.h"
+
+// 虚拟纹理查看器
+// 离线切片：VirtualTexture --build 图片 输出.vtex [瓦片大小]
+// 查看：    VirtualTexture 文件.vtex [物理页每边页数]
+// 滚轮缩放，WASD 平移，T 切换平面倾斜(同时看到多个级别)
+
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// 视图状态
+float zoom = 2.5f;             // 摄像机到平面的距离
+glm::vec2 pan(0.0f);
+bool tilted = false;
+
+const char *vertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "layout (location = 1) in vec2 aTexCoord;\n"
+    "out vec2 TexCoord;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = projection * view * model * vec4(aPos, 0.0, 1.0);\n"
+    "   TexCoord = aTexCoord;\n"
+    "}\0";
+// 片元着色器在 #version 和 main 之间拼上 virtualTextureShaderSource
+const char *sampleFragmentMain = "out vec4 FragColor;\n"
+    "in vec2 TexCoord;\n"
+    "void main()\n"
+    "{\n"
+    "  FragColor = sampleVirtualTexture(TexCoord);\n"
+    "}\n";
+const char *feedbackFragmentMain = "out vec4 FragColor;\n"
+    "in vec2 TexCoord;\n"
+    "void main()\n"
+    "{\n"
+    "  FragColor = virtualTextureFeedback(TexCoord);\n"
+    "}\n";
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    float speed = 0.01f * zoom;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        pan.y += speed;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        pan.y -= speed;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        pan.x -= speed;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        pan.x += speed;
+}
+
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+        tilted = !tilted;
+}
+
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
+{
+    zoom = std::min(std::max(zoom * (yoffset > 0 ? 0.9f : 1.1f), 0.001f), 10.0f);
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+GLuint compileProgram(const char *vertexSource, const std::string &fragmentSource)
+{
+    int success;
+    char infoLog[512];
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    const char *source = fragmentSource.c_str();
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &source, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// 离线切片，解码后的整张图只在这里出现一次
+int buildTiles(const char *input, const char *output, int tileSize)
+{
+    int width, height, channels;
+    unsigned char *data = stbi_load(input, &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "Failed to load " << input << std::endl;
+        return -1;
+    }
+    bool ok = buildVirtualTextureFile(data, width, height, output, tileSize);
+    stbi_image_free(data);
+    if (ok)
+        printf("%s: %dx%d, tile %d\n", output, width, height, tileSize);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && strcmp(argv[1], "--build") == 0)
+        return buildTiles(argv[2], argv[3], argc > 4 ? std::max(16, atoi(argv[4])) : 128);
+    if (argc < 2)
+    {
+        std::cout << "usage: VirtualTexture --build image output.vtex [tileSize]\n"
+                     "       VirtualTexture image.vtex [pagesPerSide]" << std::endl;
+        return -1;
+    }
+    int pagesPerSide = argc > 2 ? std::min(std::max(2, atoi(argv[2])), 64) : 16;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    #endif
+    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "VirtualTexture", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    VirtualTexture vt;
+    if (!vt.open(argv[1], pagesPerSide))
+    {
+        glfwTerminate();
+        return -1;
+    }
+    std::string header = "#version 330 core\n";
+    GLuint sampleProgram = compileProgram(vertexShaderSource, header + virtualTextureShaderSource + sampleFragmentMain);
+    GLuint feedbackProgram = compileProgram(vertexShaderSource, header + virtualTextureShaderSource + feedbackFragmentMain);
+
+    // 平面保持图片的宽高比，纹理坐标 v 向下，和图片的行顺序一致
+    float aspect = (float)vt.width() / vt.height();
+    float vertices[] = {
+        -aspect, -1.0f, 0.0f, 1.0f,
+         aspect, -1.0f, 1.0f, 1.0f,
+         aspect,  1.0f, 1.0f, 0.0f,
+         aspect,  1.0f, 1.0f, 0.0f,
+        -aspect,  1.0f, 0.0f, 0.0f,
+        -aspect, -1.0f, 0.0f, 1.0f,
+    };
+    GLuint VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    double lastTitle = 0.0;
+    while (!glfwWindowShouldClose(window))
+    {
+        processInput(window);
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == 0 || height == 0)
+        {
+            glfwPollEvents();
+            continue;
+        }
+
+        glm::mat4 model = glm::mat4(1.0f);
+        if (tilted)
+            model = glm::rotate(model, glm::radians(-70.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        glm::mat4 view = glm::lookAt(glm::vec3(pan, zoom), glm::vec3(pan, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.0005f, 100.0f);
+        auto drawPlane = [&](GLuint program) {
+            glUseProgram(program);
+            vt.bind(program, 0, 1);
+            glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        };
+
+        // 反馈：低分辨率画一遍，记录需要的瓦片
+        vt.beginFeedback(width, height);
+        drawPlane(feedbackProgram);
+        vt.endFeedback(0, width, height);
+        // 处理之前的反馈，上传加载好的瓦片
+        vt.update();
+
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPlane(sampleProgram);
+
+        if (glfwGetTime() - lastTitle > 0.5)
+        {
+            lastTitle = glfwGetTime();
+            VirtualTextureStats stats = vt.getStats();
+            char title[160];
+            snprintf(title, sizeof(title), "VirtualTexture %dx%d  pages %d/%d  pending %d  uploads %llu  evictions %llu  %.1f MB",
+                     vt.width(), vt.height(), stats.residentPages, stats.physicalPages, stats.pendingTiles,
+                     (unsigned long long)stats.uploads, (unsigned long long)stats.evictions, stats.gpuBytes / 1048576.0);
+            glfwSetWindowTitle(window, title);
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    vt.release();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteProgram(sampleProgram);
+    glDeleteProgram(feedbackProgram);
+    glfwTerminate();
+    return 0;
+}
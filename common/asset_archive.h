@@ -0,0 +1,412 @@
+//
+//  asset_archive.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef asset_archive_h
+#define asset_archive_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if HAVE_LZ4
+    #include <lz4.h>
+#endif
+#if HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+// 资源归档
+// 所有资源打成一个文件，运行时 mmap 一次，按名字查找，返回指向映射内存的 span，没有逐个文件的 open/stat：
+//   - 文件头 + 目录(TOC) + 名字表 + 数据
+//   - 目录按名字哈希(FNV-1a)排序，二分查找；哈希相同时再比较名字
+//   - 每个条目的数据按对齐要求放置，大文件按页对齐
+//   - 可选压缩：定义 HAVE_LZ4 / HAVE_ZSTD 并链接对应的库后(AssetPacker 的工程里已经打开，用 Homebrew 的 lz4、zstd；Camera 只用 span() 读不压缩的条目，不需要)，打包时可以按条目压缩，压缩后没有明显变小的条目保持原样；
+//     压缩的条目读取时解压到调用者的缓冲，没有压缩的条目零拷贝
+//   - 打包时按内容哈希去重，内容相同的条目共用一份数据
+//
+// 用法：
+//   AssetArchive archive;
+//   archive.open("assets.pak");
+//   AssetSpan span;
+//   std::vector<uint8_t> scratch;          // 只有压缩的条目会用到
+//   if (archive.get("container.jpg", span, scratch)) ... span.data, span.size
+//
+// 打包见 AssetPacker 工程，或者直接用 AssetArchiveWriter
+
+enum AssetCompression : uint32_t
+{
+    ASSET_STORED = 0,
+    ASSET_LZ4 = 1,
+    ASSET_ZSTD = 2
+};
+
+struct AssetArchiveHeader
+{
+    char magic[8];         // "PAK00001"
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t namesOffset;  // 名字表紧跟在目录后面
+    uint64_t namesSize;
+};
+
+// 目录的一项，文件里按 nameHash 排序
+struct AssetArchiveEntry
+{
+    uint64_t nameHash;
+    uint64_t offset;       // 数据在文件里的位置
+    uint64_t size;         // 文件里的大小(压缩后)
+    uint64_t rawSize;      // 解压后的大小
+    uint64_t contentHash;  // 解压后内容的哈希
+    uint32_t nameOffset;   // 在名字表里的位置
+    uint32_t nameLength;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+struct AssetSpan
+{
+    const uint8_t *data = NULL;
+    size_t size = 0;
+};
+
+inline uint64_t assetHash(const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline const char *assetCompressionName(uint32_t compression)
+{
+    static const char *names[] = { "stored", "lz4", "zstd" };
+    return compression <= ASSET_ZSTD ? names[compression] : "unknown";
+}
+
+class AssetArchive
+{
+public:
+    ~AssetArchive() { close(); }
+
+    bool open(const std::string &path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AssetArchiveHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // 映射建立后文件描述符就不需要了
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        base = (const uint8_t *)mapped;
+        mappedSize = info.st_size;
+
+        const AssetArchiveHeader *header = (const AssetArchiveHeader *)base;
+        size_t tocEnd = sizeof(AssetArchiveHeader) + (size_t)header->entryCount * sizeof(AssetArchiveEntry);
+        if (memcmp(header->magic, "PAK00001", 8) != 0 || tocEnd > mappedSize || header->namesOffset < tocEnd ||
+            header->namesOffset + header->namesSize > mappedSize)
+        {
+            printf("AssetArchive: %s is not a valid archive\n", path.c_str());
+            close();
+            return false;
+        }
+        entries = (const AssetArchiveEntry *)(base + sizeof(AssetArchiveHeader));
+        entryCount = header->entryCount;
+        names = (const char *)(base + header->namesOffset);
+        for (uint32_t i = 0; i < entryCount; i++)
+        {
+            const AssetArchiveEntry &entry = entries[i];
+            if (entry.offset + entry.size > mappedSize || (uint64_t)entry.nameOffset + entry.nameLength > header->namesSize)
+            {
+                printf("AssetArchive: %s has a corrupt entry\n", path.c_str());
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (base)
+            munmap((void *)base, mappedSize);
+        base = NULL;
+        mappedSize = 0;
+        entries = NULL;
+        entryCount = 0;
+    }
+
+    bool isOpen() const { return base != NULL; }
+    uint32_t size() const { return entryCount; }
+    const AssetArchiveEntry &entry(uint32_t index) const { return entries[index]; }
+    std::string name(const AssetArchiveEntry &entry) const { return std::string(names + entry.nameOffset, entry.nameLength); }
+
+    // 按名字查找，没有时返回 NULL
+    const AssetArchiveEntry *find(const std::string &name) const
+    {
+        uint64_t hash = assetHash(name.data(), name.size());
+        const AssetArchiveEntry *end = entries + entryCount;
+        const AssetArchiveEntry *it = std::lower_bound(entries, end, hash,
+            [](const AssetArchiveEntry &entry, uint64_t value) { return entry.nameHash < value; });
+        for (; it != end && it->nameHash == hash; ++it)
+        {
+            if (it->nameLength == name.size() && memcmp(names + it->nameOffset, name.data(), name.size()) == 0)
+                return it;
+        }
+        return NULL;
+    }
+
+    // 没有压缩的条目返回映射内存里的一段，零拷贝；压缩的条目返回空
+    AssetSpan span(const std::string &name) const
+    {
+        AssetSpan result;
+        const AssetArchiveEntry *entry = find(name);
+        if (entry && entry->compression == ASSET_STORED)
+        {
+            result.data = base + entry->offset;
+            result.size = entry->size;
+        }
+        return result;
+    }
+
+    // 取条目内容：没有压缩时 span 指向映射内存，压缩时解压到 scratch，span 指向 scratch
+    bool get(const std::string &name, AssetSpan &result, std::vector<uint8_t> &scratch) const
+    {
+        const AssetArchiveEntry *entry = find(name);
+        if (!entry)
+            return false;
+        const uint8_t *data = base + entry->offset;
+        if (entry->compression == ASSET_STORED)
+        {
+            result.data = data;
+            result.size = entry->size;
+            return true;
+        }
+        scratch.resize(entry->rawSize);
+        bool ok = false;
+#if HAVE_LZ4
+        if (entry->compression == ASSET_LZ4)
+            ok = LZ4_decompress_safe((const char *)data, (char *)scratch.data(), (int)entry->size, (int)entry->rawSize) == (int)entry->rawSize;
+#endif
+#if HAVE_ZSTD
+        if (entry->compression == ASSET_ZSTD)
+            ok = ZSTD_decompress(scratch.data(), scratch.size(), data, entry->size) == entry->rawSize;
+#endif
+        if (!ok)
+        {
+            printf("AssetArchive: cannot decompress %s (%s)\n", name.c_str(), assetCompressionName(entry->compression));
+            return false;
+        }
+        result.data = scratch.data();
+        result.size = scratch.size();
+        return true;
+    }
+
+private:
+    const uint8_t *base = NULL;
+    size_t mappedSize = 0;
+    const AssetArchiveEntry *entries = NULL;
+    uint32_t entryCount = 0;
+    const char *names = NULL;
+};
+
+struct AssetPackOptions
+{
+    AssetCompression compression = ASSET_STORED;
+    uint32_t alignment = 16;             // 普通条目的对齐
+    uint32_t pageAlignment = 4096;       // 大条目按页对齐
+    uint64_t pageAlignThreshold = 64 << 10;
+};
+
+struct AssetPackStats
+{
+    size_t entries = 0;
+    size_t duplicates = 0;      // 去重后共用数据的条目
+    size_t compressed = 0;      // 实际压缩的条目
+    uint64_t rawBytes = 0;      // 所有条目原始大小之和
+    uint64_t archiveBytes = 0;
+};
+
+// 打包：先 add 所有条目，再 write
+class AssetArchiveWriter
+{
+public:
+    void add(const std::string &name, std::vector<uint8_t> data)
+    {
+        items.push_back({ name, std::move(data) });
+    }
+
+    bool write(const std::string &path, const AssetPackOptions &options, AssetPackStats *stats = NULL)
+    {
+        AssetPackStats result;
+        // 名字哈希排序，同一个名字只保留最后加入的
+        std::unordered_map<std::string, size_t> byName;
+        for (size_t i = 0; i < items.size(); i++)
+            byName[items[i].name] = i;
+        std::vector<size_t> order;
+        for (auto &item : byName)
+            order.push_back(item.second);
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            uint64_t ha = assetHash(items[a].name.data(), items[a].name.size());
+            uint64_t hb = assetHash(items[b].name.data(), items[b].name.size());
+            return ha != hb ? ha < hb : items[a].name < items[b].name;
+        });
+
+        AssetArchiveHeader header = {};
+        memcpy(header.magic, "PAK00001", 8);
+        header.entryCount = (uint32_t)order.size();
+        header.namesOffset = sizeof(AssetArchiveHeader) + order.size() * sizeof(AssetArchiveEntry);
+        std::string nameTable;
+        std::vector<AssetArchiveEntry> toc(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Item &item = items[order[i]];
+            AssetArchiveEntry &entry = toc[i];
+            entry = {};
+            entry.nameHash = assetHash(item.name.data(), item.name.size());
+            entry.nameOffset = (uint32_t)nameTable.size();
+            entry.nameLength = (uint32_t)item.name.size();
+            entry.rawSize = item.data.size();
+            entry.contentHash = assetHash(item.data.data(), item.data.size());
+            nameTable += item.name;
+        }
+        header.namesSize = nameTable.size();
+
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            printf("AssetArchive: cannot write %s\n", path.c_str());
+            return false;
+        }
+        uint64_t offset = header.namesOffset + header.namesSize;
+        std::vector<uint8_t> blob;
+        std::vector<std::vector<uint8_t>> blobs;   // 按写入顺序的数据
+        std::vector<uint64_t> blobOffsets;
+        // 内容哈希 -> 已经写过的条目，哈希相同时比较内容确认
+        std::unordered_map<uint64_t, std::vector<size_t>> written;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Item &item = items[order[i]];
+            AssetArchiveEntry &entry = toc[i];
+            result.entries++;
+            result.rawBytes += item.data.size();
+
+            bool duplicate = false;
+            for (size_t other : written[entry.contentHash])
+            {
+                if (items[order[other]].data == item.data)
+                {
+                    entry.offset = toc[other].offset;
+                    entry.size = toc[other].size;
+                    entry.compression = toc[other].compression;
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate)
+            {
+                result.duplicates++;
+                continue;
+            }
+            written[entry.contentHash].push_back(i);
+
+            entry.compression = compress(item.data, options.compression, blob) ? options.compression : ASSET_STORED;
+            if (entry.compression == ASSET_STORED)
+                blob = item.data;
+            else
+                result.compressed++;
+            entry.size = blob.size();
+            uint64_t alignment = entry.compression == ASSET_STORED && entry.size >= options.pageAlignThreshold
+                                     ? options.pageAlignment : options.alignment;
+            offset = (offset + alignment - 1) / alignment * alignment;
+            entry.offset = offset;
+            offset += entry.size;
+            blobOffsets.push_back(entry.offset);
+            blobs.push_back(blob);
+        }
+
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(toc.data(), sizeof(AssetArchiveEntry), toc.size(), file);
+        fwrite(nameTable.data(), 1, nameTable.size(), file);
+        uint64_t position = header.namesOffset + header.namesSize;
+        static const uint8_t zeros[4096] = {};
+        for (size_t i = 0; i < blobs.size(); i++)
+        {
+            // 对齐填充
+            while (position < blobOffsets[i])
+            {
+                size_t padding = (size_t)std::min<uint64_t>(sizeof(zeros), blobOffsets[i] - position);
+                fwrite(zeros, 1, padding, file);
+                position += padding;
+            }
+            fwrite(blobs[i].data(), 1, blobs[i].size(), file);
+            position += blobs[i].size();
+        }
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        result.archiveBytes = position;
+        if (stats)
+            *stats = result;
+        return ok;
+    }
+
+private:
+    struct Item
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Item> items;
+
+    // 压缩后至少小 1/8 才使用压缩结果
+    static bool compress(const std::vector<uint8_t> &data, AssetCompression compression, std::vector<uint8_t> &out)
+    {
+        // 两个库都没有时不会用到
+        (void)compression;
+        size_t size = 0;
+#if HAVE_LZ4
+        if (compression == ASSET_LZ4)
+        {
+            out.resize(LZ4_compressBound((int)data.size()));
+            size = LZ4_compress_default((const char *)data.data(), (char *)out.data(), (int)data.size(), (int)out.size());
+        }
+#endif
+#if HAVE_ZSTD
+        if (compression == ASSET_ZSTD)
+        {
+            out.resize(ZSTD_compressBound(data.size()));
+            size = ZSTD_compress(out.data(), out.size(), data.data(), data.size(), 19);
+            if (ZSTD_isError(size))
+                size = 0;
+        }
+#endif
+        if (size == 0 || size > data.size() - data.size() / 8)
+            return false;
+        out.resize(size);
+        return true;
+    }
+};
+
+#endif /* asset_archive_h */
@@ -0,0 +1,430 @@
+//
+//  benchmark.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef benchmark_h
+#define benchmark_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 微基准
+// 接口照着 Google Benchmark 的样子做了一个最小的版本，不引入外部依赖：
+//   - 用例注册成 名字 + 函数，可以带若干个参数(arg)，每个参数单独跑一次，名字后面加 /参数
+//   - 先用少量迭代估计耗时，再把迭代次数放大到至少跑满 minTime 秒，报告每次迭代的墙钟时间和线程 CPU 时间
+//   - 用例可以设置处理的字节数、条目数，报告 bytes_per_second、items_per_second
+//   - 需要 GL 上下文的用例标记 gl()，没有上下文时跳过
+//   - 结果打印成表格，也可以按 Google Benchmark 的 JSON 格式写到文件，方便用现成的工具比较两次结果
+//
+// 用法：
+//   void BM_Multiply(BenchmarkState &state)
+//   {
+//       glm::mat4 a(1.0f), b(2.0f);
+//       while (state.keepRunning())
+//           benchmarkDoNotOptimize(a = a * b);
+//       state.setItemsProcessed(state.iterations());
+//   }
+//   BENCHMARK(BM_Multiply);                          // 名字是 "BM_Multiply"
+//   BENCHMARK_NAMED("math/multiply", BM_Multiply)->arg(16)->arg(256);
+//
+//   BenchmarkOptions options;
+//   options.parse(argc, argv);                      // --benchmark_filter=正则 --benchmark_out=结果.json ...
+//   return benchmarkRegistry().run(options);
+
+// 防止编译器把结果优化掉
+template <typename T>
+inline void benchmarkDoNotOptimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+// 让编译器认为 value 被读过也被改过，循环里不变的输入不会被提到循环外面
+template <typename T>
+inline void benchmarkDoNotOptimize(T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    static volatile void *sink;
+    sink = &value;
+#endif
+}
+
+// 让编译器认为内存都被读写过
+inline void benchmarkClobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+inline double benchmarkCpuSeconds()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+class BenchmarkState
+{
+public:
+    BenchmarkState(uint64_t maxIterations, int64_t argument) : maxIterations(maxIterations), argument(argument) {}
+
+    // 每次迭代调用一次，第一次调用时开始计时，达到次数后停止计时并返回 false
+    bool keepRunning()
+    {
+        if (count == 0 && !started)
+        {
+            started = true;
+            resumeTiming();
+        }
+        if (count < maxIterations)
+        {
+            count++;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    // 准备数据等不想计入的部分放在 pause/resume 之间
+    void pauseTiming()
+    {
+        if (!running)
+            return;
+        realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+        cpuSeconds += benchmarkCpuSeconds() - cpuStart;
+        running = false;
+    }
+    void resumeTiming()
+    {
+        if (running)
+            return;
+        realStart = std::chrono::steady_clock::now();
+        cpuStart = benchmarkCpuSeconds();
+        running = true;
+    }
+
+    // 用例内部自己计时的情况(比如 GPU 的时间)，用这个覆盖墙钟时间
+    void setIterationTime(double seconds) { manualSeconds += seconds; manualTime = true; }
+
+    int64_t arg() const { return argument; }
+    uint64_t iterations() const { return count; }
+    void setBytesProcessed(uint64_t bytes) { bytesProcessed = bytes; }
+    void setItemsProcessed(uint64_t items) { itemsProcessed = items; }
+    void setLabel(const std::string &text) { label = text; }
+    void skipWithError(const std::string &message)
+    {
+        error = message;
+        count = maxIterations;
+    }
+
+    double elapsedReal() const { return manualTime ? manualSeconds : realSeconds; }
+    double elapsedCpu() const { return cpuSeconds; }
+
+    uint64_t bytesProcessed = 0;
+    uint64_t itemsProcessed = 0;
+    std::string label;
+    std::string error;
+
+private:
+    uint64_t maxIterations;
+    int64_t argument;
+    uint64_t count = 0;
+    bool started = false, running = false, manualTime = false;
+    std::chrono::steady_clock::time_point realStart;
+    double cpuStart = 0.0, realSeconds = 0.0, cpuSeconds = 0.0, manualSeconds = 0.0;
+};
+
+typedef std::function<void(BenchmarkState &)> BenchmarkFunction;
+
+struct BenchmarkCase
+{
+    std::string name;
+    BenchmarkFunction function;
+    std::vector<int64_t> args;
+    bool needsGL = false;
+    uint64_t fixedIterations = 0;
+
+    BenchmarkCase *arg(int64_t value) { args.push_back(value); return this; }
+    BenchmarkCase *gl() { needsGL = true; return this; }
+    // 很慢或者有副作用的用例固定迭代次数，不做估计
+    BenchmarkCase *iterations(uint64_t count) { fixedIterations = count; return this; }
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double realNs = 0.0, cpuNs = 0.0;    // 每次迭代
+    double bytesPerSecond = 0.0, itemsPerSecond = 0.0;
+    std::string label, error;
+};
+
+struct BenchmarkOptions
+{
+    std::string filter = ".";
+    std::string outPath;                 // 为空时不写 JSON
+    double minTime = 0.5;                // 秒
+    bool list = false;
+    bool glAvailable = false;
+    std::vector<std::pair<std::string, std::string>> context;  // 额外写进 JSON context 的信息
+
+    // 认识的参数被消耗掉，剩下的留给调用者
+    void parse(int &argc, char **argv)
+    {
+        int kept = 1;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string value;
+            if (match(argv[i], "--benchmark_filter=", value))
+                filter = value;
+            else if (match(argv[i], "--benchmark_out=", value))
+                outPath = value;
+            else if (match(argv[i], "--benchmark_min_time=", value))
+                minTime = std::max(0.0, atof(value.c_str()));
+            else if (strcmp(argv[i], "--benchmark_list_tests") == 0)
+                list = true;
+            else
+                argv[kept++] = argv[i];
+        }
+        argc = kept;
+    }
+
+private:
+    static bool match(const char *argument, const char *prefix, std::string &value)
+    {
+        size_t length = strlen(prefix);
+        if (strncmp(argument, prefix, length) != 0)
+            return false;
+        value = argument + length;
+        return true;
+    }
+};
+
+class BenchmarkRegistry
+{
+public:
+    BenchmarkCase *add(const std::string &name, BenchmarkFunction function)
+    {
+        cases.emplace_back(new BenchmarkCase());
+        cases.back()->name = name;
+        cases.back()->function = function;
+        return cases.back().get();
+    }
+
+    int run(const BenchmarkOptions &options)
+    {
+        std::regex filter(options.filter);
+        std::vector<BenchmarkResult> results;
+        if (!options.list)
+            printf("%-44s %14s %14s %12s  %s\n", "Benchmark", "Time", "CPU", "Iterations", "UserCounters");
+        for (auto &entry : cases)
+        {
+            std::vector<int64_t> args = entry->args.empty() ? std::vector<int64_t>{ -1 } : entry->args;
+            for (int64_t argument : args)
+            {
+                std::string name = argument < 0 ? entry->name : entry->name + "/" + std::to_string(argument);
+                if (!std::regex_search(name, filter))
+                    continue;
+                if (options.list)
+                {
+                    printf("%s\n", name.c_str());
+                    continue;
+                }
+                BenchmarkResult result;
+                result.name = name;
+                if (entry->needsGL && !options.glAvailable)
+                    result.error = "no GL context";
+                else
+                    measure(*entry, argument, options.minTime, result);
+                print(result);
+                results.push_back(result);
+            }
+        }
+        if (!options.outPath.empty() && !writeJson(options, results))
+            return 1;
+        return 0;
+    }
+
+private:
+    static void measure(BenchmarkCase &entry, int64_t argument, double minTime, BenchmarkResult &result)
+    {
+        uint64_t iterations = entry.fixedIterations ? entry.fixedIterations : 1;
+        while (true)
+        {
+            BenchmarkState state(iterations, argument);
+            entry.function(state);
+            if (!state.error.empty())
+            {
+                result.error = state.error;
+                return;
+            }
+            double seconds = state.elapsedReal();
+            // 跑够时间，或者已经很多次了，就用这一轮的结果
+            if (entry.fixedIterations || seconds >= minTime || iterations >= 1000000000ull)
+            {
+                result.iterations = state.iterations();
+                result.realNs = seconds * 1e9 / std::max<uint64_t>(1, state.iterations());
+                result.cpuNs = state.elapsedCpu() * 1e9 / std::max<uint64_t>(1, state.iterations());
+                if (seconds > 0.0)
+                {
+                    result.bytesPerSecond = state.bytesProcessed / seconds;
+                    result.itemsPerSecond = state.itemsProcessed / seconds;
+                }
+                result.label = state.label;
+                return;
+            }
+            // 按这一轮的耗时估计需要的次数，多留一点余量；太快的一轮最多放大 10 倍
+            double scale = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+            if (seconds < minTime / 10.0)
+                scale = std::min(scale, 10.0);
+            iterations = std::max(iterations + 1, (uint64_t)(iterations * scale));
+            iterations = std::min<uint64_t>(iterations, 1000000000ull);
+        }
+    }
+
+    static std::string formatTime(double ns)
+    {
+        char text[32];
+        if (ns < 1e4)
+            snprintf(text, sizeof(text), "%.1f ns", ns);
+        else if (ns < 1e7)
+            snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+        else
+            snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+        return text;
+    }
+
+    static std::string formatRate(double value, const char *unit)
+    {
+        static const char *prefixes[] = { "", "k", "M", "G", "T" };
+        int p = 0;
+        while (value >= 1000.0 && p < 4)
+        {
+            value /= 1000.0;
+            p++;
+        }
+        char text[32];
+        snprintf(text, sizeof(text), "%.3g%s%s", value, prefixes[p], unit);
+        return text;
+    }
+
+    static void print(const BenchmarkResult &result)
+    {
+        if (!result.error.empty())
+        {
+            printf("%-44s SKIPPED: %s\n", result.name.c_str(), result.error.c_str());
+            return;
+        }
+        std::string counters;
+        if (result.bytesPerSecond > 0.0)
+            counters += " bytes_per_second=" + formatRate(result.bytesPerSecond, "B/s");
+        if (result.itemsPerSecond > 0.0)
+            counters += " items_per_second=" + formatRate(result.itemsPerSecond, "/s");
+        if (!result.label.empty())
+            counters += " " + result.label;
+        printf("%-44s %14s %14s %12llu %s\n", result.name.c_str(), formatTime(result.realNs).c_str(),
+               formatTime(result.cpuNs).c_str(), (unsigned long long)result.iterations, counters.c_str());
+    }
+
+    static std::string escape(const std::string &text)
+    {
+        std::string out;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            if ((unsigned char)c < 0x20)
+                continue;
+            out += c;
+        }
+        return out;
+    }
+
+    // 字段名和 Google Benchmark 的 --benchmark_out_format=json 一致
+    static bool writeJson(const BenchmarkOptions &options, const std::vector<BenchmarkResult> &results)
+    {
+        FILE *file = fopen(options.outPath.c_str(), "w");
+        if (!file)
+        {
+            printf("Benchmark: cannot write %s\n", options.outPath.c_str());
+            return false;
+        }
+        char date[64];
+        time_t now = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+        fprintf(file, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"num_cpus\": %u,\n", date, std::thread::hardware_concurrency());
+#ifdef NDEBUG
+        fprintf(file, "    \"library_build_type\": \"release\"");
+#else
+        fprintf(file, "    \"library_build_type\": \"debug\"");
+#endif
+        for (auto &item : options.context)
+            fprintf(file, ",\n    \"%s\": \"%s\"", escape(item.first).c_str(), escape(item.second).c_str());
+        fprintf(file, "\n  },\n  \"benchmarks\": [");
+        bool first = true;
+        for (const BenchmarkResult &result : results)
+        {
+            fprintf(file, "%s\n    {\n      \"name\": \"%s\",\n      \"run_name\": \"%s\",\n      \"run_type\": \"iteration\",\n",
+                    first ? "" : ",", escape(result.name).c_str(), escape(result.name).c_str());
+            first = false;
+            if (!result.error.empty())
+            {
+                fprintf(file, "      \"error_occurred\": true,\n      \"error_message\": \"%s\"\n    }", escape(result.error).c_str());
+                continue;
+            }
+            fprintf(file, "      \"iterations\": %llu,\n      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n      \"time_unit\": \"ns\"",
+                    (unsigned long long)result.iterations, result.realNs, result.cpuNs);
+            if (result.bytesPerSecond > 0.0)
+                fprintf(file, ",\n      \"bytes_per_second\": %.1f", result.bytesPerSecond);
+            if (result.itemsPerSecond > 0.0)
+                fprintf(file, ",\n      \"items_per_second\": %.1f", result.itemsPerSecond);
+            if (!result.label.empty())
+                fprintf(file, ",\n      \"label\": \"%s\"", escape(result.label).c_str());
+            fprintf(file, "\n    }");
+        }
+        fprintf(file, "\n  ]\n}\n");
+        fclose(file);
+        return true;
+    }
+
+    std::vector<std::unique_ptr<BenchmarkCase>> cases;
+};
+
+inline BenchmarkRegistry &benchmarkRegistry()
+{
+    static BenchmarkRegistry registry;
+    return registry;
+}
+
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_(a, b)
+#define BENCHMARK_NAMED(name, function) \
+    static BenchmarkCase *BENCHMARK_CONCAT(benchmarkCase, __LINE__) = benchmarkRegistry().add(name, function)
+#define BENCHMARK(function) BENCHMARK_NAMED(#function, function)
+
+#endif /* benchmark_h */
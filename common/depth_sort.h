@@ -0,0 +1,158 @@
+//
+//  depth_sort.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef depth_sort_h
+#define depth_sort_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 按观察深度排序和深度预渲染，减少不透明物体的重复着色(overdraw)
+//   - 不透明物体从近到远提交，远处被挡住的片元在深度测试时就被丢掉，不跑片元着色器
+//   - 深度预渲染：先只写深度画一遍(片元着色器为空)，再用 GL_EQUAL 深度测试正常着色，
+//     每个像素只着色一次；顶点多算一遍，适合片元着色器很贵的场景
+//     两遍的 gl_Position 必须逐位相同，顶点着色器要声明 invariant gl_Position
+//
+// 用法：
+//   depthSorter.clear();
+//   for (物体) depthSorter.add(编号, 观察空间深度);
+//   for (uint32_t item : depthSorter.sortFrontToBack()) ...
+//   depthSorter.nearest(3);  // 只要最近的几个时不用整体排序
+//
+//   depthPrepassBegin();  画深度  depthPrepassShade();  正常画  depthPrepassEnd();
+
+// float 转成按无符号整数比较时顺序不变的 key：正数翻转符号位，负数全部取反
+inline uint32_t depthSortKey(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// 按深度排序的物体列表，基数排序(LSD，每趟 8 位)，O(n)
+// 排序 key 放在 64 位的高 32 位，物体编号在低 32 位，只排高 32 位；缓冲区在多帧之间复用，稳定后不再分配
+class DepthSorter
+{
+public:
+    void clear() { entries.clear(); }
+
+    void reserve(size_t count)
+    {
+        entries.reserve(count);
+        scratch.reserve(count);
+        items.reserve(count);
+    }
+
+    // depth 是观察空间里到摄像机的距离，越小越近
+    void add(uint32_t item, float depth)
+    {
+        entries.push_back(((uint64_t)depthSortKey(depth) << 32) | item);
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // 从近到远，不透明物体用
+    const std::vector<uint32_t> &sortFrontToBack() { return sort(false); }
+    // 从远到近，半透明物体用
+    const std::vector<uint32_t> &sortBackToFront() { return sort(true); }
+
+    // 只取最近的 count 个，从近到远；部分选择 O(n)，不需要整体排序时用(比如选遮挡体)
+    const std::vector<uint32_t> &nearest(size_t count)
+    {
+        count = std::min(count, entries.size());
+        scratch.assign(entries.begin(), entries.end());
+        std::nth_element(scratch.begin(), scratch.begin() + count, scratch.end());
+        std::sort(scratch.begin(), scratch.begin() + count);
+        items.resize(count);
+        for (size_t i = 0; i < count; i++)
+            items[i] = (uint32_t)scratch[i];
+        return items;
+    }
+
+private:
+    std::vector<uint64_t> entries;
+    std::vector<uint64_t> scratch;
+    std::vector<uint32_t> items;
+
+    const std::vector<uint32_t> &sort(bool descending)
+    {
+        size_t count = entries.size();
+        items.resize(count);
+        if (count == 0)
+            return items;
+        scratch.resize(count);
+        // 4 个字节的直方图一次统计完
+        uint32_t histograms[4][256];
+        memset(histograms, 0, sizeof(histograms));
+        for (uint64_t entry : entries)
+        {
+            uint32_t key = (uint32_t)(entry >> 32);
+            if (descending)
+                key = ~key;
+            for (int pass = 0; pass < 4; pass++)
+                histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+
+        uint64_t *source = entries.data();
+        uint64_t *target = scratch.data();
+        for (int pass = 0; pass < 4; pass++)
+        {
+            uint32_t *histogram = histograms[pass];
+            // 所有 key 这个字节都相同，这一趟不改变顺序，跳过
+            uint32_t first = (uint32_t)((source[0] >> (32 + pass * 8)) & 0xFF);
+            if (histogram[descending ? 255 - first : first] == count)
+                continue;
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < 256; bucket++)
+            {
+                uint32_t n = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += n;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t key = (uint32_t)(source[i] >> 32);
+                if (descending)
+                    key = ~key;
+                target[histogram[(key >> (pass * 8)) & 0xFF]++] = source[i];
+            }
+            std::swap(source, target);
+        }
+
+        for (size_t i = 0; i < count; i++)
+            items[i] = (uint32_t)source[i];
+        return items;
+    }
+};
+
+// 深度预渲染第一遍：只写深度，不写颜色
+inline void depthPrepassBegin()
+{
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+// 第二遍：深度已经是最终结果，只有深度相等的片元(每个像素最近的那个)才着色，不再写深度
+inline void depthPrepassShade()
+{
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_EQUAL);
+}
+
+// 恢复默认的深度状态
+inline void depthPrepassEnd()
+{
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+#endif /* depth_sort_h */
@@ -0,0 +1,176 @@
+//
+//  dynamic_resolution.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef dynamic_resolution_h
+#define dynamic_resolution_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+// 动态分辨率
+// 场景先画到离屏目标，再拉伸到窗口；根据 GPU 耗时和预算调整离屏分辨率：
+//   - 超出预算时按像素数和耗时成正比估算，直接降到预算内
+//   - 低于预算一定比例时每帧小步提高，避免来回抖动
+// 离屏目标按窗口大小(最大比例)分配，调整比例只改视口，不重新分配显存
+// GPU 耗时用 GL_TIME_ELAPSED 查询，几帧之后结果可用时才读，不会让 CPU 等 GPU
+//
+// 用法：
+//   dynamicResolution.init(framebufferWidth, framebufferHeight);
+//   dynamicResolution.begin();      // 绑定离屏目标、设置视口并清屏，之后绘制场景
+//   dynamicResolution.end(0);       // 拉伸到目标帧缓冲(0 是窗口)
+class DynamicResolution
+{
+public:
+    static const int QUERY_LATENCY = 4;
+    float budgetMs = 1000.0f / 60.0f * 0.9f; // GPU 耗时预算，留一点余量
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float increaseStep = 0.02f;   // 每帧最多提高的比例
+    float increaseHeadroom = 0.85f; // 耗时低于预算的这个比例才提高
+
+    // 创建离屏目标，需要在 OpenGL 上下文创建之后调用
+    void init(int width, int height)
+    {
+        glGenQueries(QUERY_LATENCY, queries);
+        resize(width, height);
+    }
+
+    // 窗口帧缓冲大小变化时调用
+    void resize(int width, int height)
+    {
+        if (width <= 0 || height <= 0)
+            return;
+        releaseTargets();
+        windowWidth = width;
+        windowHeight = height;
+        targetWidth = (int)std::ceil(width * maxScale);
+        targetHeight = (int)std::ceil(height * maxScale);
+
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, targetWidth, targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, targetWidth, targetHeight);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    }
+
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        releaseTargets();
+        glDeleteQueries(QUERY_LATENCY, queries);
+    }
+
+    // 开始画场景：绑定离屏目标，视口是当前比例下的大小
+    void begin()
+    {
+        readResults();
+        renderWidth = std::max(1, (int)(windowWidth * scale));
+        renderHeight = std::max(1, (int)(windowHeight * scale));
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, renderWidth, renderHeight);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        GLuint query = queries[frame % QUERY_LATENCY];
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pending[frame % QUERY_LATENCY] = true;
+        queryScale[frame % QUERY_LATENCY] = scale;
+    }
+
+    // 场景画完：拉伸到目标帧缓冲，恢复窗口大小的视口
+    void end(GLuint targetFramebuffer)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        frame++;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+        glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT,
+                          renderWidth == windowWidth && renderHeight == windowHeight ? GL_NEAREST : GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+        glViewport(0, 0, windowWidth, windowHeight);
+    }
+
+    float getScale() const { return scale; }
+    float getGpuMilliseconds() const { return gpuMs; }
+    int getRenderWidth() const { return renderWidth; }
+    int getRenderHeight() const { return renderHeight; }
+
+private:
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    GLuint depthBuffer = 0;
+    GLuint queries[QUERY_LATENCY] = {};
+    bool pending[QUERY_LATENCY] = {};
+    float queryScale[QUERY_LATENCY] = {}; // 查询那一帧用的比例
+    unsigned int frame = 0;
+    int windowWidth = 0, windowHeight = 0;
+    int targetWidth = 0, targetHeight = 0;
+    int renderWidth = 0, renderHeight = 0;
+    float scale = 1.0f;
+    float gpuMs = 0.0f;
+
+    void releaseTargets()
+    {
+        if (framebuffer)
+            glDeleteFramebuffers(1, &framebuffer);
+        if (colorTexture)
+            glDeleteTextures(1, &colorTexture);
+        if (depthBuffer)
+            glDeleteRenderbuffers(1, &depthBuffer);
+        framebuffer = colorTexture = depthBuffer = 0;
+    }
+
+    // 读取已经完成的查询，按最新的耗时调整比例
+    void readResults()
+    {
+        // 从最早的一帧开始读；当前帧要复用的那个查询没完成也只能等
+        for (int age = QUERY_LATENCY; age >= 1; age--)
+        {
+            unsigned int index = (frame + QUERY_LATENCY - age) % QUERY_LATENCY;
+            if (!pending[index])
+                continue;
+            GLint available = age == QUERY_LATENCY;
+            if (!available)
+                glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+            pending[index] = false;
+            adjust(elapsed / 1e6f, queryScale[index]);
+        }
+    }
+
+    void adjust(float ms, float measuredScale)
+    {
+        // 平滑一下，单帧的波动不直接影响分辨率
+        gpuMs = gpuMs == 0.0f ? ms : gpuMs * 0.8f + ms * 0.2f;
+        if (ms > budgetMs)
+        {
+            // 耗时大致和像素数成正比，像素数和比例的平方成正比
+            // 以测量那一帧的比例为准，之前已经降过的不再重复降
+            scale = std::min(scale, measuredScale * std::sqrt(budgetMs / ms));
+        }
+        else if (gpuMs < budgetMs * increaseHeadroom)
+            scale += increaseStep;
+        scale = std::min(maxScale, std::max(minScale, scale));
+    }
+};
+
+#endif /* dynamic_resolution_h */
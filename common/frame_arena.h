@@ -0,0 +1,212 @@
+//
+//  frame_arena.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef frame_arena_h
+#define frame_arena_h
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// 每帧的线性分配器
+// 每个线程一个 arena，分配只是移动指针，帧结束时整体回退，不逐个释放
+// 容量不够时追加一块内存，下一帧开始时合并成一整块，稳定后每帧不再访问堆
+// 配合 FrameAllocator 可以给 STL 容器使用，容器和其中的数据只在当前帧有效
+// 容器扩容时旧的内存不会回收，能预估大小时先 reserve
+//
+// 用法：
+//   frameArenaNextFrame();                          // 主线程每帧开始时调用
+//   FrameVector<glm::mat4> models;                  // 从当前线程的 arena 分配
+//   models.reserve(cubeCount);
+//   FrameArenaStats stats = frameArenaStats();      // 所有线程的用量和峰值
+
+struct FrameArenaStats
+{
+    size_t used = 0;      // 当前帧已用字节
+    size_t highWater = 0; // 单帧用量的峰值
+    size_t capacity = 0;  // 已经向堆申请的字节
+    size_t heapAllocations = 0; // 向堆申请的次数，稳定后不再增加
+};
+
+// 所有线程共享的帧号，arena 发现帧号变了就回退
+inline std::atomic<uint64_t> frameArenaEpoch(0);
+
+class FrameArena
+{
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    FrameArena() { addBlock(DEFAULT_BLOCK_SIZE); }
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment)
+    {
+        uint64_t epoch = frameArenaEpoch.load(std::memory_order_acquire);
+        if (epoch != frame)
+        {
+            reset();
+            frame = epoch;
+        }
+        while (true)
+        {
+            Block &block = blocks[current];
+            uintptr_t base = (uintptr_t)block.data.get();
+            uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            size_t end = aligned - base + size;
+            if (end <= block.size)
+            {
+                used += end - offset;
+                offset = end;
+                return (void *)aligned;
+            }
+            // 当前块放不下，换下一块，没有就向堆申请一块足够大的
+            current++;
+            offset = 0;
+            if (current >= blocks.size())
+                addBlock(std::max(DEFAULT_BLOCK_SIZE, size + alignment));
+        }
+    }
+
+    // 回退到第一块的开头，上一帧分配的内存全部失效
+    void reset()
+    {
+        if (used > highWater)
+            highWater = used;
+        // 上一帧用了多块，合并成一整块，以后一块就够用
+        if (blocks.size() > 1)
+        {
+            size_t total = 0;
+            for (const Block &block : blocks)
+                total += block.size;
+            blocks.clear();
+            capacity = 0;
+            addBlock(total);
+        }
+        current = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    FrameArenaStats stats() const
+    {
+        FrameArenaStats stats;
+        stats.used = used;
+        stats.highWater = used > highWater ? used : highWater;
+        stats.capacity = capacity;
+        stats.heapAllocations = heapAllocations;
+        return stats;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t used = 0;
+    size_t highWater = 0;
+    size_t capacity = 0;
+    size_t heapAllocations = 0;
+    uint64_t frame = 0;
+
+    void addBlock(size_t size)
+    {
+        blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+        capacity += size;
+        heapAllocations++;
+    }
+};
+
+// 所有线程的 arena，统计用
+struct FrameArenaRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<FrameArena>> arenas;
+};
+
+inline FrameArenaRegistry &frameArenaRegistry()
+{
+    static FrameArenaRegistry registry;
+    return registry;
+}
+
+// 当前线程的 arena，第一次调用时创建；线程退出后 arena 仍然保留在注册表里
+inline FrameArena &frameArena()
+{
+    thread_local FrameArena *arena = NULL;
+    if (!arena)
+    {
+        FrameArenaRegistry &registry = frameArenaRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.arenas.emplace_back(new FrameArena());
+        arena = registry.arenas.back().get();
+    }
+    return *arena;
+}
+
+// 开始新的一帧，各线程的 arena 在下一次分配时回退
+inline void frameArenaNextFrame()
+{
+    frameArenaEpoch.fetch_add(1, std::memory_order_release);
+}
+
+// 所有线程加起来的用量，峰值是各线程峰值之和；其它线程正在分配时读到的是近似值
+inline FrameArenaStats frameArenaStats()
+{
+    FrameArenaStats total;
+    FrameArenaRegistry &registry = frameArenaRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto &arena : registry.arenas)
+    {
+        FrameArenaStats stats = arena->stats();
+        total.used += stats.used;
+        total.highWater += stats.highWater;
+        total.capacity += stats.capacity;
+        total.heapAllocations += stats.heapAllocations;
+    }
+    return total;
+}
+
+// STL 分配器，构造时绑定当前线程的 arena，释放什么都不做
+template <typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FrameAllocator() : arena(&frameArena()) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U> &other) const { return arena != other.arena; }
+
+    FrameArena *arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif /* frame_arena_h */
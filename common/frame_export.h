@@ -0,0 +1,475 @@
+//
+//  frame_export.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef frame_export_h
+#define frame_export_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 帧导出
+// 读回不阻塞渲染循环：glReadPixels 读进一组轮换的 PBO，插入 fence，几帧之后 fence 完成再映射拷出，
+// 拷出的帧交给线程池编码写文件，编码和写文件都不在渲染线程上
+//   - RAW：每帧一个 .rgba 文件，按行从上到下的 RGBA8
+//   - PNG：每帧一个 .png 文件，deflate 用不压缩的存储块，编码只是拷贝和校验和，不依赖 zlib
+//   - Y4M：所有帧写进一个 .y4m 文件(YUV 4:2:0，BT.601)，转换并行，写入按帧号顺序
+// 待编码的帧超过上限时渲染线程等待编码，内存占用有上限；帧缓冲从池里复用，稳定后不再分配
+//
+// 用法：
+//   FrameExporter exporter;
+//   exporter.start("out", EXPORT_PNG, width, height);
+//   exporter.capture(framebuffer);   // 每帧画完、swap 之前
+//   exporter.finish();               // 等所有帧写完
+
+enum FrameExportFormat
+{
+    EXPORT_RAW,
+    EXPORT_PNG,
+    EXPORT_Y4M
+};
+
+inline bool parseFrameExportFormat(const std::string &text, FrameExportFormat &format)
+{
+    if (text == "raw")
+        format = EXPORT_RAW;
+    else if (text == "png")
+        format = EXPORT_PNG;
+    else if (text == "y4m")
+        format = EXPORT_Y4M;
+    else
+        return false;
+    return true;
+}
+
+// PNG 的 CRC32
+inline uint32_t frameExportCrc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool initialized = [] {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)initialized;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// 编码 PNG，rgba 按行从上到下；zlib 流只用存储块
+inline void encodePNG(const uint8_t *rgba, int width, int height, std::vector<uint8_t> &out)
+{
+    auto put32 = [&out](uint32_t value) {
+        out.push_back((uint8_t)(value >> 24));
+        out.push_back((uint8_t)(value >> 16));
+        out.push_back((uint8_t)(value >> 8));
+        out.push_back((uint8_t)value);
+    };
+    auto chunk = [&](const char *type, const std::vector<uint8_t> &data) {
+        put32((uint32_t)data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        put32(frameExportCrc32(out.data() + start, out.size() - start));
+    };
+
+    out.clear();
+    const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.insert(out.end(), signature, signature + 8);
+
+    std::vector<uint8_t> header(13);
+    for (int i = 0; i < 4; i++)
+    {
+        header[i] = (uint8_t)(width >> (24 - i * 8));
+        header[4 + i] = (uint8_t)(height >> (24 - i * 8));
+    }
+    header[8] = 8; // 位深
+    header[9] = 6; // RGBA
+    chunk("IHDR", header);
+
+    // 每行前面一个过滤类型字节(0，不过滤)
+    size_t rowBytes = (size_t)width * 4;
+    size_t rawSize = (rowBytes + 1) * height;
+    const size_t BLOCK = 65535;
+    std::vector<uint8_t> idat;
+    idat.reserve(rawSize + rawSize / BLOCK * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    uint32_t adlerA = 1, adlerB = 0;
+    size_t remaining = rawSize;
+    int row = 0;
+    size_t rowOffset = 0; // 当前行已经写出的字节，0 表示还没写过滤字节
+    while (remaining > 0)
+    {
+        size_t blockSize = std::min(remaining, BLOCK);
+        remaining -= blockSize;
+        idat.push_back(remaining == 0 ? 1 : 0);
+        idat.push_back((uint8_t)blockSize);
+        idat.push_back((uint8_t)(blockSize >> 8));
+        idat.push_back((uint8_t)~blockSize);
+        idat.push_back((uint8_t)(~blockSize >> 8));
+        while (blockSize > 0)
+        {
+            if (rowOffset == 0)
+            {
+                idat.push_back(0);
+                adlerB = (adlerB + adlerA) % 65521;
+                rowOffset = 1;
+                blockSize--;
+                continue;
+            }
+            size_t count = std::min(blockSize, rowBytes + 1 - rowOffset);
+            const uint8_t *src = rgba + row * rowBytes + (rowOffset - 1);
+            for (size_t i = 0; i < count; i++)
+            {
+                adlerA = (adlerA + src[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+            idat.insert(idat.end(), src, src + count);
+            rowOffset += count;
+            blockSize -= count;
+            if (rowOffset == rowBytes + 1)
+            {
+                row++;
+                rowOffset = 0;
+            }
+        }
+    }
+    uint32_t adler = adlerB << 16 | adlerA;
+    for (int i = 3; i >= 0; i--)
+        idat.push_back((uint8_t)(adler >> (i * 8)));
+    chunk("IDAT", idat);
+    chunk("IEND", std::vector<uint8_t>());
+}
+
+// RGBA 转 YUV 4:2:0(BT.601，有限范围)，宽高按 2 向下取整
+inline void convertToI420(const uint8_t *rgba, int width, int height, std::vector<uint8_t> &out)
+{
+    int w = width & ~1, h = height & ~1;
+    out.resize((size_t)w * h * 3 / 2);
+    uint8_t *yPlane = out.data();
+    uint8_t *uPlane = yPlane + (size_t)w * h;
+    uint8_t *vPlane = uPlane + (size_t)w * h / 4;
+    for (int y = 0; y < h; y++)
+    {
+        const uint8_t *src = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < w; x++)
+        {
+            int r = src[x * 4], g = src[x * 4 + 1], b = src[x * 4 + 2];
+            yPlane[(size_t)y * w + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (int y = 0; y < h; y += 2)
+    {
+        for (int x = 0; x < w; x += 2)
+        {
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < 2; dy++)
+            {
+                const uint8_t *p = rgba + ((size_t)(y + dy) * width + x) * 4;
+                r += p[0] + p[4];
+                g += p[1] + p[5];
+                b += p[2] + p[6];
+            }
+            r /= 4, g /= 4, b /= 4;
+            size_t index = (size_t)(y / 2) * (w / 2) + x / 2;
+            uPlane[index] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[index] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+struct FrameExportStats
+{
+    uint64_t captured = 0; // 发起读回的帧
+    uint64_t written = 0;  // 已经写完的帧
+    uint64_t readbackStalls = 0; // PBO 全部在用、渲染线程等 GPU 的次数
+    uint64_t encoderStalls = 0;  // 待编码帧太多、渲染线程等编码的次数
+};
+
+class FrameExporter
+{
+public:
+    static const int PBO_COUNT = 4;
+
+    // directory 是输出目录(需要已经存在)，threads 为 0 时按 CPU 核数
+    bool start(const std::string &directory, FrameExportFormat exportFormat, int frameWidth, int frameHeight, unsigned int threads = 0)
+    {
+        dir = directory;
+        format = exportFormat;
+        width = frameWidth;
+        height = frameHeight;
+        frameBytes = (size_t)width * height * 4;
+        if (format == EXPORT_Y4M)
+        {
+            std::string path = dir + "/frames.y4m";
+            y4m = fopen(path.c_str(), "wb");
+            if (!y4m)
+            {
+                printf("FrameExporter: cannot open %s\n", path.c_str());
+                return false;
+            }
+            fprintf(y4m, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C420jpeg\n", width & ~1, height & ~1);
+        }
+
+        glGenBuffers(PBO_COUNT, pbos);
+        for (GLuint pbo : pbos)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        maxQueued = threads * 2;
+        running = true;
+        for (unsigned int i = 0; i < threads; i++)
+            workers.emplace_back(&FrameExporter::workerLoop, this);
+        active = true;
+        return true;
+    }
+
+    bool isActive() const { return active; }
+
+    // 发起这一帧的读回，framebuffer 为 0 时读窗口的后缓冲
+    void capture(GLuint framebuffer)
+    {
+        if (!active)
+            return;
+        collect(false);
+        // PBO 都在等 GPU，只能等最早的一个
+        if (inFlight.size() == PBO_COUNT)
+        {
+            stats.readbackStalls++;
+            collect(true);
+        }
+
+        GLint previousRead = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        GLuint pbo = pbos[nextPbo];
+        nextPbo = (nextPbo + 1) % PBO_COUNT;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+        inFlight.push_back({ pbo, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameIndex++ });
+        stats.captured++;
+    }
+
+    // 等所有帧读回并写完，关闭输出；需要在 OpenGL 上下文销毁前调用
+    void finish()
+    {
+        if (!active)
+            return;
+        while (!inFlight.empty())
+            collect(true);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            running = false;
+        }
+        workAvailable.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+        workers.clear();
+        glDeleteBuffers(PBO_COUNT, pbos);
+        if (y4m)
+        {
+            fclose(y4m);
+            y4m = NULL;
+        }
+        active = false;
+        printf("FrameExporter: %llu frames written to %s (%llu readback stalls, %llu encoder stalls)\n",
+               (unsigned long long)stats.written, dir.c_str(),
+               (unsigned long long)stats.readbackStalls, (unsigned long long)stats.encoderStalls);
+    }
+
+    FrameExportStats getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    struct InFlight
+    {
+        GLuint pbo;
+        GLsync fence;
+        uint64_t frame;
+    };
+    struct Job
+    {
+        uint64_t frame;
+        std::vector<uint8_t> pixels;
+    };
+
+    std::string dir;
+    FrameExportFormat format = EXPORT_PNG;
+    int width = 0, height = 0;
+    size_t frameBytes = 0;
+    bool active = false;
+    GLuint pbos[PBO_COUNT] = {};
+    int nextPbo = 0;
+    std::deque<InFlight> inFlight;
+    uint64_t frameIndex = 0;
+    FILE *y4m = NULL;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::deque<Job> jobs;
+    std::vector<std::vector<uint8_t>> pool;   // 复用的帧缓冲
+    std::mutex orderedMutex;
+    std::map<uint64_t, std::vector<uint8_t>> ordered; // Y4M 等待按顺序写入的帧
+    uint64_t nextOrdered = 0;
+    size_t maxQueued = 0;
+    size_t busy = 0;
+    bool running = false;
+    std::vector<std::thread> workers;
+    FrameExportStats stats;
+
+    // 映射完成的 PBO，拷出后交给线程池；wait 为 true 时等最早的一个
+    void collect(bool wait)
+    {
+        while (!inFlight.empty())
+        {
+            InFlight &front = inFlight.front();
+            GLenum result = glClientWaitSync(front.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(front.fence);
+
+            Job job;
+            job.frame = front.frame;
+            {
+                // 编码跟不上时等一等，不让待编码的帧无限堆积
+                std::unique_lock<std::mutex> lock(mutex);
+                if (jobs.size() + busy >= maxQueued)
+                {
+                    stats.encoderStalls++;
+                    workDone.wait(lock, [this] { return jobs.size() + busy < maxQueued; });
+                }
+                if (!pool.empty())
+                {
+                    job.pixels.swap(pool.back());
+                    pool.pop_back();
+                }
+            }
+            job.pixels.resize(frameBytes);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, front.pbo);
+            if (const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT))
+            {
+                memcpy(job.pixels.data(), mapped, frameBytes);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            inFlight.pop_front();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            workAvailable.notify_one();
+            wait = false;
+        }
+    }
+
+    void workerLoop()
+    {
+        std::vector<uint8_t> flipped, encoded;
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this] { return !jobs.empty() || !running; });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                busy++;
+            }
+
+            // OpenGL 的行从下往上，翻转成从上往下
+            size_t rowBytes = (size_t)width * 4;
+            flipped.resize(frameBytes);
+            for (int y = 0; y < height; y++)
+                memcpy(flipped.data() + y * rowBytes, job.pixels.data() + (height - 1 - y) * rowBytes, rowBytes);
+
+            char name[64];
+            if (format == EXPORT_RAW)
+            {
+                snprintf(name, sizeof(name), "/frame_%06llu.rgba", (unsigned long long)job.frame);
+                writeFile(dir + name, flipped);
+            }
+            else if (format == EXPORT_PNG)
+            {
+                encodePNG(flipped.data(), width, height, encoded);
+                snprintf(name, sizeof(name), "/frame_%06llu.png", (unsigned long long)job.frame);
+                writeFile(dir + name, encoded);
+            }
+            else
+                convertToI420(flipped.data(), width, height, encoded);
+
+            uint64_t written = 1;
+            if (format == EXPORT_Y4M)
+            {
+                // 按帧号顺序写，前面的帧还没转换完就先放着
+                std::lock_guard<std::mutex> lock(orderedMutex);
+                ordered[job.frame].swap(encoded);
+                written = 0;
+                while (!ordered.empty() && ordered.begin()->first == nextOrdered)
+                {
+                    std::vector<uint8_t> &frame = ordered.begin()->second;
+                    fputs("FRAME\n", y4m);
+                    fwrite(frame.data(), 1, frame.size(), y4m);
+                    ordered.erase(ordered.begin());
+                    nextOrdered++;
+                    written++;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.written += written;
+            pool.push_back(std::move(job.pixels));
+            busy--;
+            workDone.notify_all();
+        }
+    }
+
+    static void writeFile(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            printf("FrameExporter: cannot write %s\n", path.c_str());
+            return;
+        }
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+    }
+};
+
+#endif /* frame_export_h */
@@ -0,0 +1,307 @@
+//
+//  frame_pacing.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef frame_pacing_h
+#define frame_pacing_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+// 帧节奏控制和输入延迟测量
+// 几种节奏：
+//   - VSYNC：交换间隔 1，由驱动按刷新率节流
+//   - UNCAPPED：交换间隔 0，能跑多快跑多快
+//   - LIMITER：交换间隔 0，画完之后等到目标时刻再交换；先 sleep，离目标 2ms 以内改成空转，sleep 的误差不影响节奏
+//   - LATE_LATCH：等待挪到采样输入之前，按最近几帧的渲染耗时推算，尽量晚采样输入，画完马上交换
+// 延迟 = 采样输入到这一帧在 GPU 上执行完(交换之后插入的 GL_TIMESTAMP)的时间，
+// GPU 时间戳换算成 CPU 时间，用 fence 判断结果可用，不会让 CPU 等 GPU
+//
+// 用法：
+//   framePacer.init(PACING_LIMITER, 120.0);   // 上下文创建之后
+//   framePacer.beginFrame();                  // 循环开头，按节奏等待
+//   glfwPollEvents(); processInput(window);
+//   framePacer.inputSampled();                // 输入采样完成
+//   ...                                       // 渲染
+//   framePacer.present(window);               // 代替 glfwSwapBuffers
+
+enum FramePacingMode
+{
+    PACING_VSYNC,
+    PACING_UNCAPPED,
+    PACING_LIMITER,
+    PACING_LATE_LATCH,
+    PACING_MODE_COUNT
+};
+
+inline const char *framePacingModeName(FramePacingMode mode)
+{
+    static const char *names[] = { "vsync", "uncapped", "limiter", "late-latch" };
+    return mode < PACING_MODE_COUNT ? names[mode] : "unknown";
+}
+
+// 从字符串解析节奏，格式是 vsync、uncapped、limiter:帧率、late-latch:帧率
+inline bool parseFramePacing(const char *text, FramePacingMode &mode, double &fps)
+{
+    for (int i = 0; i < PACING_MODE_COUNT; i++)
+    {
+        const char *name = framePacingModeName((FramePacingMode)i);
+        size_t length = strlen(name);
+        if (strncmp(text, name, length) == 0 && (text[length] == '\0' || text[length] == ':'))
+        {
+            mode = (FramePacingMode)i;
+            if (text[length] == ':' && atof(text + length + 1) > 0.0)
+                fps = atof(text + length + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct FramePacingStats
+{
+    double intervalMs = 0.0;       // 平均帧间隔
+    double intervalJitterMs = 0.0; // 帧间隔的标准差
+    double latencyMs = 0.0;        // 平均输入延迟
+    double latencyP99Ms = 0.0;
+    size_t samples = 0;
+};
+
+class FramePacer
+{
+public:
+    static const int QUERY_COUNT = 8;  // 最多同时等待的帧
+    static const int HISTORY = 240;    // 统计用的帧数
+    static const int SMOOTH_FRAMES = 4; // frameInterval 平均的帧数
+    static constexpr double MAX_FRAME_INTERVAL = 0.1;
+
+    double targetFps = 60.0;
+    double spinMs = 2.0;        // 离目标多近时改成空转
+    double lateLatchMarginMs = 1.0; // 延迟采样时给渲染耗时估计留的余量
+
+    void init(FramePacingMode pacingMode, double fps)
+    {
+        glGenQueries(QUERY_COUNT, queries);
+        targetFps = fps;
+        setMode(pacingMode);
+        calibrate();
+        lastFrameStart = now();
+        deadline = lastFrameStart;
+    }
+
+    void release()
+    {
+        for (Pending &pending : pendings)
+            glDeleteSync(pending.fence);
+        pendings.clear();
+        glDeleteQueries(QUERY_COUNT, queries);
+    }
+
+    // 需要当前上下文
+    void setMode(FramePacingMode pacingMode)
+    {
+        mode = pacingMode;
+        glfwSwapInterval(mode == PACING_VSYNC ? 1 : 0);
+        intervals.clear();
+        latencies.clear();
+        deadline = now();
+        pacedInterval = 0.0;
+    }
+
+    FramePacingMode getMode() const { return mode; }
+
+    // 循环开头调用，延迟采样模式在这里等待
+    void beginFrame()
+    {
+        if (mode == PACING_LATE_LATCH)
+        {
+            // 留出渲染需要的时间，剩下的时间都等待，输入尽量靠近交换
+            double wakeUp = nextDeadline() - renderEstimate - lateLatchMarginMs / 1000.0;
+            waitUntil(wakeUp);
+        }
+        double start = now();
+        record(intervals, (start - lastFrameStart) * 1000.0);
+        lastFrameStart = start;
+        readResults();
+    }
+
+    // 输入采样完成时调用，记录这一帧的输入时刻
+    void inputSampled()
+    {
+        inputTime = now();
+    }
+
+    // 代替 glfwSwapBuffers：限帧模式在这里等待，交换后插入时间戳查询和 fence
+    void present(GLFWwindow *window)
+    {
+        double target = nextDeadline();
+        if (mode == PACING_LIMITER)
+            waitUntil(target);
+        if (mode == PACING_LIMITER || mode == PACING_LATE_LATCH)
+        {
+            // 落后超过一帧时从现在重新开始计时，不连续赶帧
+            double current = now();
+            double next = current - target > interval() ? current : target;
+            pacedInterval = next - deadline;
+            deadline = next;
+        }
+
+        glfwSwapBuffers(window);
+        // 渲染耗时估计：采样输入到交换返回，慢慢收敛，突然变慢时马上跟上
+        double renderTime = now() - inputTime;
+        renderEstimate = renderTime > renderEstimate ? renderTime : renderEstimate * 0.9 + renderTime * 0.1;
+
+        if (pendings.size() < QUERY_COUNT)
+        {
+            GLuint query = queries[nextQuery];
+            nextQuery = (nextQuery + 1) % QUERY_COUNT;
+            glQueryCounter(query, GL_TIMESTAMP);
+            pendings.push_back({ query, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), inputTime });
+        }
+    }
+
+    // 给动画和移动用的帧间隔(秒)，比 glfwGetTime 的差值平稳：
+    // 限帧和延迟采样模式用目标交换时刻的间隔，按节奏走的时候正好是 1/帧率；
+    // 其它模式用最近几帧实测间隔的平均；卡顿时最多算 MAX_FRAME_INTERVAL，不会一下跳很远
+    double frameInterval() const
+    {
+        double result = interval();
+        if (mode == PACING_LIMITER || mode == PACING_LATE_LATCH)
+            result = pacedInterval > 0.0 ? pacedInterval : interval();
+        else if (!intervals.empty())
+        {
+            size_t count = std::min<size_t>(intervals.size(), SMOOTH_FRAMES);
+            double sum = 0.0;
+            for (size_t i = intervals.size() - count; i < intervals.size(); i++)
+                sum += intervals[i];
+            result = sum / count / 1000.0;
+        }
+        return std::min(result, MAX_FRAME_INTERVAL);
+    }
+
+    FramePacingStats stats() const
+    {
+        FramePacingStats stats;
+        stats.samples = latencies.size();
+        if (!intervals.empty())
+        {
+            double sum = 0.0, squares = 0.0;
+            for (double value : intervals)
+            {
+                sum += value;
+                squares += value * value;
+            }
+            stats.intervalMs = sum / intervals.size();
+            stats.intervalJitterMs = std::sqrt(std::max(0.0, squares / intervals.size() - stats.intervalMs * stats.intervalMs));
+        }
+        if (!latencies.empty())
+        {
+            std::vector<double> sorted(latencies.begin(), latencies.end());
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (double value : sorted)
+                sum += value;
+            stats.latencyMs = sum / sorted.size();
+            stats.latencyP99Ms = sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.99))];
+        }
+        return stats;
+    }
+
+private:
+    struct Pending
+    {
+        GLuint query;
+        GLsync fence;
+        double inputTime;
+    };
+
+    FramePacingMode mode = PACING_VSYNC;
+    GLuint queries[QUERY_COUNT] = {};
+    int nextQuery = 0;
+    std::deque<Pending> pendings;
+    std::deque<double> intervals; // 毫秒
+    std::deque<double> latencies; // 毫秒
+    double lastFrameStart = 0.0;
+    double deadline = 0.0;       // 上一帧的目标交换时刻
+    double pacedInterval = 0.0;  // 最近两次目标交换时刻的间隔(秒)
+    double inputTime = 0.0;
+    double renderEstimate = 0.0; // 秒
+    // GPU 时间戳和 CPU 时钟的对应关系
+    double calibrationCpu = 0.0;
+    int64_t calibrationGpu = 0;
+    unsigned int calibrationAge = 0;
+
+    static double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double interval() const { return 1.0 / targetFps; }
+    double nextDeadline() const { return deadline + interval(); }
+
+    // 先 sleep 到目标前 spinMs，再空转到目标
+    void waitUntil(double target)
+    {
+        double sleepUntil = target - spinMs / 1000.0;
+        double current = now();
+        if (current < sleepUntil)
+            std::this_thread::sleep_for(std::chrono::duration<double>(sleepUntil - current));
+        while (now() < target)
+            std::this_thread::yield();
+    }
+
+    // 同时读 CPU 时钟和 GPU 时间戳，两个时钟的漂移靠定期重新校准
+    void calibrate()
+    {
+        GLint64 gpuTime = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+        calibrationCpu = now();
+        calibrationGpu = gpuTime;
+        calibrationAge = 0;
+    }
+
+    void record(std::deque<double> &history, double value)
+    {
+        history.push_back(value);
+        if (history.size() > HISTORY)
+            history.pop_front();
+    }
+
+    // 读已经完成的帧，不等待
+    void readResults()
+    {
+        while (!pendings.empty())
+        {
+            Pending &pending = pendings.front();
+            GLenum result = glClientWaitSync(pending.fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+                break;
+            GLuint64 gpuTime = 0;
+            glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &gpuTime);
+            double finished = calibrationCpu + (double)((int64_t)gpuTime - calibrationGpu) / 1e9;
+            record(latencies, (finished - pending.inputTime) * 1000.0);
+            glDeleteSync(pending.fence);
+            pendings.pop_front();
+        }
+        // 大约每秒校准一次
+        if (++calibrationAge >= 60)
+            calibrate();
+    }
+};
+
+inline FramePacer framePacer;
+
+#endif /* frame_pacing_h */
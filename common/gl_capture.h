@@ -0,0 +1,688 @@
+//
+//  gl_capture.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef gl_capture_h
+#define gl_capture_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gl_extensions.h"
+#include "gl_intercept.h"
+
+// OpenGL 调用录制
+// 与 gl_intercept.h 一样替换 glad 的函数指针，把调用和它引用的缓冲/纹理数据序列化到一个二进制文件，
+// 再用 Replay 工具在没有应用逻辑的情况下反复回放，得到稳定、可分享的性能复现
+//
+// 录制方式：
+//   - 在 gladLoadGLLoader 之后、创建任何资源之前调用 glCaptureInstall
+//   - 录制范围之前只记录改变状态/创建资源的调用(跳过清屏和绘制)，作为回放的初始化部分
+//   - 范围内的帧完整记录，每帧结束调用 glCaptureEndFrame，范围结束后自动写文件并停止
+// 只录制 demo 用到的那部分 API(GL_CAPTURE_FUNCTIONS)；只读的查询(glGet*、glGetQueryObject*)不录制，
+// 它们不改变状态，回放时也不需要。新代码用到列表以外会改变状态或产生输出的调用时要在这里补上，
+// 否则回放的画面会缺东西
+//
+// 文件格式：
+//   文件头 GLCaptureHeader
+//   记录：uint16 操作码 + uint32 负载长度 + 负载，负载里的参数按调用顺序紧密排列
+
+enum GLCaptureOp : uint16_t
+{
+    GLCAP_FRAME_END = 1, // 帧结束标记，文件里第一个标记之前是初始化部分
+    GLCAP_GEN_VERTEX_ARRAYS, GLCAP_GEN_BUFFERS, GLCAP_GEN_TEXTURES, GLCAP_GEN_FRAMEBUFFERS, GLCAP_GEN_RENDERBUFFERS,
+    GLCAP_DELETE_VERTEX_ARRAYS, GLCAP_DELETE_BUFFERS, GLCAP_DELETE_TEXTURES, GLCAP_DELETE_FRAMEBUFFERS, GLCAP_DELETE_RENDERBUFFERS,
+    GLCAP_CREATE_SHADER, GLCAP_SHADER_SOURCE, GLCAP_COMPILE_SHADER, GLCAP_DELETE_SHADER,
+    GLCAP_CREATE_PROGRAM, GLCAP_ATTACH_SHADER, GLCAP_LINK_PROGRAM, GLCAP_DELETE_PROGRAM, GLCAP_USE_PROGRAM,
+    GLCAP_GET_UNIFORM_LOCATION,
+    GLCAP_UNIFORM_1I, GLCAP_UNIFORM_1F, GLCAP_UNIFORM_2F, GLCAP_UNIFORM_3F, GLCAP_UNIFORM_4F,
+    GLCAP_UNIFORM_3FV, GLCAP_UNIFORM_4FV, GLCAP_UNIFORM_MATRIX_4FV,
+    GLCAP_BIND_VERTEX_ARRAY, GLCAP_BIND_BUFFER, GLCAP_BUFFER_DATA, GLCAP_BUFFER_SUB_DATA,
+    GLCAP_VERTEX_ATTRIB_POINTER, GLCAP_ENABLE_VERTEX_ATTRIB_ARRAY, GLCAP_DISABLE_VERTEX_ATTRIB_ARRAY, GLCAP_VERTEX_ATTRIB_DIVISOR,
+    GLCAP_ACTIVE_TEXTURE, GLCAP_BIND_TEXTURE, GLCAP_TEX_PARAMETER_I, GLCAP_TEX_IMAGE_2D, GLCAP_TEX_SUB_IMAGE_2D,
+    GLCAP_GENERATE_MIPMAP, GLCAP_PIXEL_STORE_I,
+    GLCAP_BIND_FRAMEBUFFER, GLCAP_FRAMEBUFFER_TEXTURE_2D, GLCAP_BIND_RENDERBUFFER, GLCAP_RENDERBUFFER_STORAGE,
+    GLCAP_FRAMEBUFFER_RENDERBUFFER, GLCAP_BLIT_FRAMEBUFFER,
+    GLCAP_ENABLE, GLCAP_DISABLE, GLCAP_BLEND_FUNC, GLCAP_DEPTH_FUNC, GLCAP_DEPTH_MASK, GLCAP_COLOR_MASK, GLCAP_CULL_FACE,
+    GLCAP_POLYGON_MODE, GLCAP_VIEWPORT, GLCAP_CLEAR_COLOR, GLCAP_CLEAR,
+    GLCAP_DRAW_ARRAYS, GLCAP_DRAW_ELEMENTS, GLCAP_DRAW_ARRAYS_INSTANCED, GLCAP_DRAW_ELEMENTS_INSTANCED,
+    // GPU 驱动的剔除(OpenGL 4.3)，回放时需要 4.3 的上下文
+    GLCAP_UNIFORM_1UI, GLCAP_BIND_BUFFER_BASE, GLCAP_VERTEX_ATTRIB_I_POINTER,
+    GLCAP_DISPATCH_COMPUTE, GLCAP_MEMORY_BARRIER, GLCAP_MULTI_DRAW_ELEMENTS_INDIRECT,
+    // 分层渲染目标、模板、查询、条件渲染、读回
+    GLCAP_TEX_IMAGE_3D, GLCAP_FRAMEBUFFER_TEXTURE, GLCAP_FRAMEBUFFER_TEXTURE_LAYER,
+    GLCAP_CLEAR_STENCIL, GLCAP_STENCIL_FUNC, GLCAP_STENCIL_OP, GLCAP_STENCIL_MASK,
+    GLCAP_GEN_QUERIES, GLCAP_DELETE_QUERIES, GLCAP_BEGIN_QUERY, GLCAP_END_QUERY, GLCAP_QUERY_COUNTER,
+    GLCAP_BEGIN_CONDITIONAL_RENDER, GLCAP_END_CONDITIONAL_RENDER,
+    GLCAP_READ_BUFFER, GLCAP_READ_PIXELS, GLCAP_MAP_BUFFER_RANGE, GLCAP_UNMAP_BUFFER,
+    GLCAP_FENCE_SYNC, GLCAP_CLIENT_WAIT_SYNC, GLCAP_DELETE_SYNC, GLCAP_FLUSH, GLCAP_FINISH,
+    GLCAP_OP_COUNT
+};
+
+struct GLCaptureHeader
+{
+    char magic[8] = { 'G', 'L', 'C', 'A', 'P', 'T', '0', '1' };
+    uint32_t width = 0;  // 录制时默认帧缓冲的大小
+    uint32_t height = 0;
+    uint32_t frameCount = 0;
+    uint32_t reserved = 0;
+};
+
+// 录制用的函数指针，保存被替换前的指针(可能是驱动的，也可能是 gl_intercept 的包装)
+struct GLCaptureNext
+{
+    PFNGLGENVERTEXARRAYSPROC GenVertexArrays; PFNGLGENBUFFERSPROC GenBuffers; PFNGLGENTEXTURESPROC GenTextures;
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers; PFNGLGENRENDERBUFFERSPROC GenRenderbuffers;
+    PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays; PFNGLDELETEBUFFERSPROC DeleteBuffers; PFNGLDELETETEXTURESPROC DeleteTextures;
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers; PFNGLDELETERENDERBUFFERSPROC DeleteRenderbuffers;
+    PFNGLCREATESHADERPROC CreateShader; PFNGLSHADERSOURCEPROC ShaderSource; PFNGLCOMPILESHADERPROC CompileShader;
+    PFNGLDELETESHADERPROC DeleteShader; PFNGLCREATEPROGRAMPROC CreateProgram; PFNGLATTACHSHADERPROC AttachShader;
+    PFNGLLINKPROGRAMPROC LinkProgram; PFNGLDELETEPROGRAMPROC DeleteProgram; PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+    PFNGLUNIFORM1IPROC Uniform1i; PFNGLUNIFORM1FPROC Uniform1f; PFNGLUNIFORM2FPROC Uniform2f; PFNGLUNIFORM3FPROC Uniform3f;
+    PFNGLUNIFORM4FPROC Uniform4f; PFNGLUNIFORM3FVPROC Uniform3fv; PFNGLUNIFORM4FVPROC Uniform4fv;
+    PFNGLUNIFORMMATRIX4FVPROC UniformMatrix4fv;
+    PFNGLBINDVERTEXARRAYPROC BindVertexArray; PFNGLBINDBUFFERPROC BindBuffer; PFNGLBUFFERDATAPROC BufferData;
+    PFNGLBUFFERSUBDATAPROC BufferSubData; PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray; PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+    PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+    PFNGLACTIVETEXTUREPROC ActiveTexture; PFNGLBINDTEXTUREPROC BindTexture; PFNGLTEXPARAMETERIPROC TexParameteri;
+    PFNGLTEXIMAGE2DPROC TexImage2D; PFNGLTEXSUBIMAGE2DPROC TexSubImage2D; PFNGLGENERATEMIPMAPPROC GenerateMipmap;
+    PFNGLPIXELSTOREIPROC PixelStorei;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer; PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+    PFNGLBINDRENDERBUFFERPROC BindRenderbuffer; PFNGLRENDERBUFFERSTORAGEPROC RenderbufferStorage;
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC FramebufferRenderbuffer; PFNGLBLITFRAMEBUFFERPROC BlitFramebuffer;
+    PFNGLENABLEPROC Enable; PFNGLDISABLEPROC Disable; PFNGLBLENDFUNCPROC BlendFunc; PFNGLDEPTHFUNCPROC DepthFunc;
+    PFNGLDEPTHMASKPROC DepthMask; PFNGLCOLORMASKPROC ColorMask; PFNGLCULLFACEPROC CullFace;
+    PFNGLPOLYGONMODEPROC PolygonMode; PFNGLVIEWPORTPROC Viewport; PFNGLCLEARCOLORPROC ClearColor; PFNGLCLEARPROC Clear;
+    PFNGLDRAWARRAYSPROC DrawArrays; PFNGLDRAWELEMENTSPROC DrawElements;
+    PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced; PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced;
+    PFNGLUNIFORM1UIPROC Uniform1ui; PFNGLBINDBUFFERBASEPROC BindBufferBase; PFNGLVERTEXATTRIBIPOINTERPROC VertexAttribIPointer;
+    PFNGLDISPATCHCOMPUTEPROC DispatchCompute; PFNGLMEMORYBARRIERPROC MemoryBarrier;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+    PFNGLTEXIMAGE3DPROC TexImage3D; PFNGLFRAMEBUFFERTEXTUREPROC FramebufferTexture;
+    PFNGLFRAMEBUFFERTEXTURELAYERPROC FramebufferTextureLayer;
+    PFNGLCLEARSTENCILPROC ClearStencil; PFNGLSTENCILFUNCPROC StencilFunc; PFNGLSTENCILOPPROC StencilOp;
+    PFNGLSTENCILMASKPROC StencilMask;
+    PFNGLGENQUERIESPROC GenQueries; PFNGLDELETEQUERIESPROC DeleteQueries; PFNGLBEGINQUERYPROC BeginQuery;
+    PFNGLENDQUERYPROC EndQuery; PFNGLQUERYCOUNTERPROC QueryCounter;
+    PFNGLBEGINCONDITIONALRENDERPROC BeginConditionalRender; PFNGLENDCONDITIONALRENDERPROC EndConditionalRender;
+    PFNGLREADBUFFERPROC ReadBuffer; PFNGLREADPIXELSPROC ReadPixels;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange; PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    PFNGLFENCESYNCPROC FenceSync; PFNGLCLIENTWAITSYNCPROC ClientWaitSync; PFNGLDELETESYNCPROC DeleteSync;
+    PFNGLFLUSHPROC Flush; PFNGLFINISHPROC Finish;
+};
+
+// 映射中的缓冲：写入的数据在 glUnmapBuffer 时才确定，那时再录制
+struct GLCaptureMapping
+{
+    GLenum target;
+    GLintptr offset;
+    GLsizeiptr length;
+    GLbitfield access;
+    void *pointer;
+};
+
+struct GLCaptureState
+{
+    bool installed = false;
+    bool recording = false;          // 是否还在录制(范围结束后为 false)
+    bool inRange = false;            // 当前帧在录制范围内
+    uint32_t frame = 0;              // 安装以来的帧号
+    uint32_t startFrame = 0;
+    uint32_t frameCount = 0;
+    uint32_t capturedFrames = 0;
+    int unpackAlignment = 4;         // 计算纹理数据大小要用
+    std::thread::id thread;          // 只录制安装线程上的调用
+    std::set<GLuint> knownPrograms;  // 录制到创建过程的程序
+    std::vector<GLCaptureMapping> mappings; // 当前映射中的缓冲
+    std::string path;
+    GLCaptureHeader header;
+    std::vector<uint8_t> data;       // 全部记录，结束时一次写入
+    std::vector<uint8_t> payload;    // 当前记录的负载
+    GLCaptureNext next;
+};
+
+inline GLCaptureState glCapture;
+
+// 序列化参数
+inline void glCapturePut(const void *bytes, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)bytes;
+    glCapture.payload.insert(glCapture.payload.end(), p, p + size);
+}
+template <typename T>
+inline void glCapturePutValue(T value)
+{
+    glCapturePut(&value, sizeof(T));
+}
+inline void glCapturePutString(const char *text, size_t length)
+{
+    glCapturePutValue<uint32_t>((uint32_t)length);
+    glCapturePut(text, length);
+}
+
+// 当前调用是否需要录制；outputOnly 表示只产生画面不改变状态的调用(清屏、绘制)，初始化部分不需要
+inline bool glCaptureActive(bool outputOnly = false)
+{
+    if (!glCapture.recording || std::this_thread::get_id() != glCapture.thread)
+        return false;
+    return glCapture.inRange || !outputOnly;
+}
+
+inline void glCaptureBegin(GLCaptureOp op)
+{
+    glCapture.payload.clear();
+    glCapturePutValue<uint16_t>(op);
+    glCapturePutValue<uint32_t>(0);
+}
+
+inline void glCaptureEnd()
+{
+    uint32_t size = (uint32_t)(glCapture.payload.size() - 6);
+    memcpy(&glCapture.payload[2], &size, 4);
+    glCapture.data.insert(glCapture.data.end(), glCapture.payload.begin(), glCapture.payload.end());
+}
+
+// 只有标量参数的调用
+template <typename... Args>
+inline void glCaptureCall(GLCaptureOp op, bool outputOnly, Args... args)
+{
+    if (!glCaptureActive(outputOnly))
+        return;
+    glCaptureBegin(op);
+    (glCapturePutValue(args), ...);
+    glCaptureEnd();
+}
+
+// 生成/删除对象：数量 + 名字列表
+inline void glCaptureNames(GLCaptureOp op, GLsizei n, const GLuint *names)
+{
+    if (!glCaptureActive())
+        return;
+    glCaptureBegin(op);
+    glCapturePutValue<int32_t>(n);
+    glCapturePut(names, sizeof(GLuint) * n);
+    glCaptureEnd();
+}
+
+// 纹理数据大小，考虑行对齐
+inline uint64_t glCaptureImageSize(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    uint64_t row = (uint64_t)width * glInterceptPixelBytes(format, type);
+    uint64_t alignment = glCapture.unpackAlignment;
+    row = (row + alignment - 1) / alignment * alignment;
+    return row * height;
+}
+
+#define GL_CAPTURE_NAMES_WRAPPER(Name, OP) \
+    inline void APIENTRY glCapture##Name(GLsizei n, GLuint *names) { glCapture.next.Name(n, names); glCaptureNames(OP, n, names); }
+#define GL_CAPTURE_DELETE_WRAPPER(Name, OP) \
+    inline void APIENTRY glCapture##Name(GLsizei n, const GLuint *names) { glCaptureNames(OP, n, names); glCapture.next.Name(n, names); }
+GL_CAPTURE_NAMES_WRAPPER(GenVertexArrays, GLCAP_GEN_VERTEX_ARRAYS)
+GL_CAPTURE_NAMES_WRAPPER(GenBuffers, GLCAP_GEN_BUFFERS)
+GL_CAPTURE_NAMES_WRAPPER(GenTextures, GLCAP_GEN_TEXTURES)
+GL_CAPTURE_NAMES_WRAPPER(GenFramebuffers, GLCAP_GEN_FRAMEBUFFERS)
+GL_CAPTURE_NAMES_WRAPPER(GenRenderbuffers, GLCAP_GEN_RENDERBUFFERS)
+GL_CAPTURE_DELETE_WRAPPER(DeleteVertexArrays, GLCAP_DELETE_VERTEX_ARRAYS)
+GL_CAPTURE_DELETE_WRAPPER(DeleteBuffers, GLCAP_DELETE_BUFFERS)
+GL_CAPTURE_DELETE_WRAPPER(DeleteTextures, GLCAP_DELETE_TEXTURES)
+GL_CAPTURE_DELETE_WRAPPER(DeleteFramebuffers, GLCAP_DELETE_FRAMEBUFFERS)
+GL_CAPTURE_DELETE_WRAPPER(DeleteRenderbuffers, GLCAP_DELETE_RENDERBUFFERS)
+#undef GL_CAPTURE_NAMES_WRAPPER
+#undef GL_CAPTURE_DELETE_WRAPPER
+
+inline GLuint APIENTRY glCaptureCreateShader(GLenum type)
+{
+    GLuint shader = glCapture.next.CreateShader(type);
+    glCaptureCall(GLCAP_CREATE_SHADER, false, type, shader);
+    return shader;
+}
+inline void APIENTRY glCaptureShaderSource(GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths)
+{
+    if (glCaptureActive())
+    {
+        glCaptureBegin(GLCAP_SHADER_SOURCE);
+        glCapturePutValue(shader);
+        glCapturePutValue<int32_t>(count);
+        for (GLsizei i = 0; i < count; i++)
+            glCapturePutString(strings[i], lengths && lengths[i] >= 0 ? lengths[i] : strlen(strings[i]));
+        glCaptureEnd();
+    }
+    glCapture.next.ShaderSource(shader, count, strings, lengths);
+}
+inline void APIENTRY glCaptureCompileShader(GLuint shader) { glCaptureCall(GLCAP_COMPILE_SHADER, false, shader); glCapture.next.CompileShader(shader); }
+inline void APIENTRY glCaptureDeleteShader(GLuint shader) { glCaptureCall(GLCAP_DELETE_SHADER, false, shader); glCapture.next.DeleteShader(shader); }
+inline GLuint APIENTRY glCaptureCreateProgram()
+{
+    GLuint program = glCapture.next.CreateProgram();
+    if (glCaptureActive())
+        glCapture.knownPrograms.insert(program);
+    glCaptureCall(GLCAP_CREATE_PROGRAM, false, program);
+    return program;
+}
+inline void APIENTRY glCaptureAttachShader(GLuint program, GLuint shader) { glCaptureCall(GLCAP_ATTACH_SHADER, false, program, shader); glCapture.next.AttachShader(program, shader); }
+inline void APIENTRY glCaptureLinkProgram(GLuint program) { glCaptureCall(GLCAP_LINK_PROGRAM, false, program); glCapture.next.LinkProgram(program); }
+inline void APIENTRY glCaptureDeleteProgram(GLuint program)
+{
+    if (glCaptureActive())
+        glCapture.knownPrograms.erase(program);
+    glCaptureCall(GLCAP_DELETE_PROGRAM, false, program);
+    glCapture.next.DeleteProgram(program);
+}
+
+// 在别的线程(比如着色器热重载的共享上下文)创建的程序没有被录制到，
+// 第一次使用时从驱动查询着色器源码，补写一份创建过程
+inline void glCaptureSynthesizeProgram(GLuint program)
+{
+    glCapture.knownPrograms.insert(program);
+    GLuint shaders[8];
+    GLsizei count = 0;
+    glGetAttachedShaders(program, 8, &count, shaders);
+    glCaptureCall(GLCAP_CREATE_PROGRAM, false, program);
+    for (GLsizei i = 0; i < count; i++)
+    {
+        GLint type = 0, length = 0;
+        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+        glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length);
+        std::vector<char> source(length + 1);
+        glGetShaderSource(shaders[i], length + 1, NULL, source.data());
+        glCaptureCall(GLCAP_CREATE_SHADER, false, (GLenum)type, shaders[i]);
+        glCaptureBegin(GLCAP_SHADER_SOURCE);
+        glCapturePutValue(shaders[i]);
+        glCapturePutValue<int32_t>(1);
+        glCapturePutString(source.data(), strlen(source.data()));
+        glCaptureEnd();
+        glCaptureCall(GLCAP_COMPILE_SHADER, false, shaders[i]);
+        glCaptureCall(GLCAP_ATTACH_SHADER, false, program, shaders[i]);
+    }
+    glCaptureCall(GLCAP_LINK_PROGRAM, false, program);
+}
+inline void APIENTRY glCaptureUseProgram(GLuint program)
+{
+    if (glCaptureActive() && program && !glCapture.knownPrograms.count(program))
+        glCaptureSynthesizeProgram(program);
+    glCaptureCall(GLCAP_USE_PROGRAM, false, program);
+    glCapture.next.UseProgram(program);
+}
+inline GLint APIENTRY glCaptureGetUniformLocation(GLuint program, const GLchar *name)
+{
+    GLint location = glCapture.next.GetUniformLocation(program, name);
+    if (glCaptureActive())
+    {
+        if (program && !glCapture.knownPrograms.count(program))
+            glCaptureSynthesizeProgram(program);
+        glCaptureBegin(GLCAP_GET_UNIFORM_LOCATION);
+        glCapturePutValue(program);
+        glCapturePutString(name, strlen(name));
+        glCapturePutValue(location);
+        glCaptureEnd();
+    }
+    return location;
+}
+inline void APIENTRY glCaptureUniform1i(GLint l, GLint v) { glCaptureCall(GLCAP_UNIFORM_1I, false, l, v); glCapture.next.Uniform1i(l, v); }
+inline void APIENTRY glCaptureUniform1f(GLint l, GLfloat v) { glCaptureCall(GLCAP_UNIFORM_1F, false, l, v); glCapture.next.Uniform1f(l, v); }
+inline void APIENTRY glCaptureUniform2f(GLint l, GLfloat x, GLfloat y) { glCaptureCall(GLCAP_UNIFORM_2F, false, l, x, y); glCapture.next.Uniform2f(l, x, y); }
+inline void APIENTRY glCaptureUniform3f(GLint l, GLfloat x, GLfloat y, GLfloat z) { glCaptureCall(GLCAP_UNIFORM_3F, false, l, x, y, z); glCapture.next.Uniform3f(l, x, y, z); }
+inline void APIENTRY glCaptureUniform4f(GLint l, GLfloat x, GLfloat y, GLfloat z, GLfloat w) { glCaptureCall(GLCAP_UNIFORM_4F, false, l, x, y, z, w); glCapture.next.Uniform4f(l, x, y, z, w); }
+// 向量/矩阵 uniform：位置 + 数量 + 数据
+inline void glCaptureUniformArray(GLCaptureOp op, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value, int floatsPerElement)
+{
+    if (!glCaptureActive())
+        return;
+    glCaptureBegin(op);
+    glCapturePutValue(location);
+    glCapturePutValue<int32_t>(count);
+    glCapturePutValue<uint8_t>(transpose);
+    glCapturePut(value, sizeof(GLfloat) * floatsPerElement * count);
+    glCaptureEnd();
+}
+inline void APIENTRY glCaptureUniform3fv(GLint l, GLsizei c, const GLfloat *v) { glCaptureUniformArray(GLCAP_UNIFORM_3FV, l, c, GL_FALSE, v, 3); glCapture.next.Uniform3fv(l, c, v); }
+inline void APIENTRY glCaptureUniform4fv(GLint l, GLsizei c, const GLfloat *v) { glCaptureUniformArray(GLCAP_UNIFORM_4FV, l, c, GL_FALSE, v, 4); glCapture.next.Uniform4fv(l, c, v); }
+inline void APIENTRY glCaptureUniformMatrix4fv(GLint l, GLsizei c, GLboolean t, const GLfloat *v) { glCaptureUniformArray(GLCAP_UNIFORM_MATRIX_4FV, l, c, t, v, 16); glCapture.next.UniformMatrix4fv(l, c, t, v); }
+
+inline void APIENTRY glCaptureBindVertexArray(GLuint a) { glCaptureCall(GLCAP_BIND_VERTEX_ARRAY, false, a); glCapture.next.BindVertexArray(a); }
+inline void APIENTRY glCaptureBindBuffer(GLenum t, GLuint b) { glCaptureCall(GLCAP_BIND_BUFFER, false, t, b); glCapture.next.BindBuffer(t, b); }
+inline void APIENTRY glCaptureBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    if (glCaptureActive())
+    {
+        glCaptureBegin(GLCAP_BUFFER_DATA);
+        glCapturePutValue(target);
+        glCapturePutValue<int64_t>(size);
+        glCapturePutValue(usage);
+        glCapturePutValue<uint8_t>(data != NULL);
+        if (data)
+            glCapturePut(data, size);
+        glCaptureEnd();
+    }
+    glCapture.next.BufferData(target, size, data, usage);
+}
+inline void APIENTRY glCaptureBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+    if (glCaptureActive())
+    {
+        glCaptureBegin(GLCAP_BUFFER_SUB_DATA);
+        glCapturePutValue(target);
+        glCapturePutValue<int64_t>(offset);
+        glCapturePutValue<int64_t>(size);
+        glCapturePut(data, size);
+        glCaptureEnd();
+    }
+    glCapture.next.BufferSubData(target, offset, size, data);
+}
+inline void APIENTRY glCaptureVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+{
+    glCaptureCall(GLCAP_VERTEX_ATTRIB_POINTER, false, index, size, type, normalized, stride, (uint64_t)(uintptr_t)pointer);
+    glCapture.next.VertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+inline void APIENTRY glCaptureEnableVertexAttribArray(GLuint i) { glCaptureCall(GLCAP_ENABLE_VERTEX_ATTRIB_ARRAY, false, i); glCapture.next.EnableVertexAttribArray(i); }
+inline void APIENTRY glCaptureDisableVertexAttribArray(GLuint i) { glCaptureCall(GLCAP_DISABLE_VERTEX_ATTRIB_ARRAY, false, i); glCapture.next.DisableVertexAttribArray(i); }
+inline void APIENTRY glCaptureVertexAttribDivisor(GLuint i, GLuint d) { glCaptureCall(GLCAP_VERTEX_ATTRIB_DIVISOR, false, i, d); glCapture.next.VertexAttribDivisor(i, d); }
+
+inline void APIENTRY glCaptureActiveTexture(GLenum t) { glCaptureCall(GLCAP_ACTIVE_TEXTURE, false, t); glCapture.next.ActiveTexture(t); }
+inline void APIENTRY glCaptureBindTexture(GLenum t, GLuint tex) { glCaptureCall(GLCAP_BIND_TEXTURE, false, t, tex); glCapture.next.BindTexture(t, tex); }
+inline void APIENTRY glCaptureTexParameteri(GLenum t, GLenum p, GLint v) { glCaptureCall(GLCAP_TEX_PARAMETER_I, false, t, p, v); glCapture.next.TexParameteri(t, p, v); }
+inline void APIENTRY glCaptureTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    if (glCaptureActive())
+    {
+        glCaptureBegin(GLCAP_TEX_IMAGE_2D);
+        glCapturePutValue(target); glCapturePutValue(level); glCapturePutValue(internalFormat);
+        glCapturePutValue(width); glCapturePutValue(height); glCapturePutValue(border);
+        glCapturePutValue(format); glCapturePutValue(type);
+        // 像素缓冲(PBO)里的数据取不到，按空纹理录制
+        uint64_t size = pixels && !glInterceptUnpackBufferBound() ? glCaptureImageSize(width, height, format, type) : 0;
+        glCapturePutValue(size);
+        glCapturePut(pixels, size);
+        glCaptureEnd();
+    }
+    glCapture.next.TexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+inline void APIENTRY glCaptureTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+{
+    if (glCaptureActive() && !glInterceptUnpackBufferBound())
+    {
+        glCaptureBegin(GLCAP_TEX_SUB_IMAGE_2D);
+        glCapturePutValue(target); glCapturePutValue(level); glCapturePutValue(x); glCapturePutValue(y);
+        glCapturePutValue(width); glCapturePutValue(height); glCapturePutValue(format); glCapturePutValue(type);
+        uint64_t size = glCaptureImageSize(width, height, format, type);
+        glCapturePutValue(size);
+        glCapturePut(pixels, size);
+        glCaptureEnd();
+    }
+    glCapture.next.TexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+inline void APIENTRY glCaptureGenerateMipmap(GLenum t) { glCaptureCall(GLCAP_GENERATE_MIPMAP, false, t); glCapture.next.GenerateMipmap(t); }
+inline void APIENTRY glCapturePixelStorei(GLenum p, GLint v)
+{
+    if (p == GL_UNPACK_ALIGNMENT)
+        glCapture.unpackAlignment = v;
+    glCaptureCall(GLCAP_PIXEL_STORE_I, false, p, v);
+    glCapture.next.PixelStorei(p, v);
+}
+
+inline void APIENTRY glCaptureBindFramebuffer(GLenum t, GLuint f) { glCaptureCall(GLCAP_BIND_FRAMEBUFFER, false, t, f); glCapture.next.BindFramebuffer(t, f); }
+inline void APIENTRY glCaptureFramebufferTexture2D(GLenum t, GLenum a, GLenum tt, GLuint tex, GLint l) { glCaptureCall(GLCAP_FRAMEBUFFER_TEXTURE_2D, false, t, a, tt, tex, l); glCapture.next.FramebufferTexture2D(t, a, tt, tex, l); }
+inline void APIENTRY glCaptureBindRenderbuffer(GLenum t, GLuint r) { glCaptureCall(GLCAP_BIND_RENDERBUFFER, false, t, r); glCapture.next.BindRenderbuffer(t, r); }
+inline void APIENTRY glCaptureRenderbufferStorage(GLenum t, GLenum f, GLsizei w, GLsizei h) { glCaptureCall(GLCAP_RENDERBUFFER_STORAGE, false, t, f, w, h); glCapture.next.RenderbufferStorage(t, f, w, h); }
+inline void APIENTRY glCaptureFramebufferRenderbuffer(GLenum t, GLenum a, GLenum rt, GLuint r) { glCaptureCall(GLCAP_FRAMEBUFFER_RENDERBUFFER, false, t, a, rt, r); glCapture.next.FramebufferRenderbuffer(t, a, rt, r); }
+inline void APIENTRY glCaptureBlitFramebuffer(GLint a, GLint b, GLint c, GLint d, GLint e, GLint f, GLint g, GLint h, GLbitfield m, GLenum filter)
+{
+    glCaptureCall(GLCAP_BLIT_FRAMEBUFFER, true, a, b, c, d, e, f, g, h, m, filter);
+    glCapture.next.BlitFramebuffer(a, b, c, d, e, f, g, h, m, filter);
+}
+
+inline void APIENTRY glCaptureEnable(GLenum c) { glCaptureCall(GLCAP_ENABLE, false, c); glCapture.next.Enable(c); }
+inline void APIENTRY glCaptureDisable(GLenum c) { glCaptureCall(GLCAP_DISABLE, false, c); glCapture.next.Disable(c); }
+inline void APIENTRY glCaptureBlendFunc(GLenum s, GLenum d) { glCaptureCall(GLCAP_BLEND_FUNC, false, s, d); glCapture.next.BlendFunc(s, d); }
+inline void APIENTRY glCaptureDepthFunc(GLenum f) { glCaptureCall(GLCAP_DEPTH_FUNC, false, f); glCapture.next.DepthFunc(f); }
+inline void APIENTRY glCaptureDepthMask(GLboolean f) { glCaptureCall(GLCAP_DEPTH_MASK, false, f); glCapture.next.DepthMask(f); }
+inline void APIENTRY glCaptureColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) { glCaptureCall(GLCAP_COLOR_MASK, false, r, g, b, a); glCapture.next.ColorMask(r, g, b, a); }
+inline void APIENTRY glCaptureCullFace(GLenum m) { glCaptureCall(GLCAP_CULL_FACE, false, m); glCapture.next.CullFace(m); }
+inline void APIENTRY glCapturePolygonMode(GLenum f, GLenum m) { glCaptureCall(GLCAP_POLYGON_MODE, false, f, m); glCapture.next.PolygonMode(f, m); }
+inline void APIENTRY glCaptureViewport(GLint x, GLint y, GLsizei w, GLsizei h) { glCaptureCall(GLCAP_VIEWPORT, false, x, y, w, h); glCapture.next.Viewport(x, y, w, h); }
+inline void APIENTRY glCaptureClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) { glCaptureCall(GLCAP_CLEAR_COLOR, false, r, g, b, a); glCapture.next.ClearColor(r, g, b, a); }
+inline void APIENTRY glCaptureClear(GLbitfield m) { glCaptureCall(GLCAP_CLEAR, true, m); glCapture.next.Clear(m); }
+inline void APIENTRY glCaptureDrawArrays(GLenum m, GLint f, GLsizei c) { glCaptureCall(GLCAP_DRAW_ARRAYS, true, m, f, c); glCapture.next.DrawArrays(m, f, c); }
+inline void APIENTRY glCaptureDrawElements(GLenum m, GLsizei c, GLenum t, const void *i)
+{
+    glCaptureCall(GLCAP_DRAW_ELEMENTS, true, m, c, t, (uint64_t)(uintptr_t)i);
+    glCapture.next.DrawElements(m, c, t, i);
+}
+inline void APIENTRY glCaptureDrawArraysInstanced(GLenum m, GLint f, GLsizei c, GLsizei n) { glCaptureCall(GLCAP_DRAW_ARRAYS_INSTANCED, true, m, f, c, n); glCapture.next.DrawArraysInstanced(m, f, c, n); }
+inline void APIENTRY glCaptureDrawElementsInstanced(GLenum m, GLsizei c, GLenum t, const void *i, GLsizei n)
+{
+    glCaptureCall(GLCAP_DRAW_ELEMENTS_INSTANCED, true, m, c, t, (uint64_t)(uintptr_t)i, n);
+    glCapture.next.DrawElementsInstanced(m, c, t, i, n);
+}
+
+inline void APIENTRY glCaptureUniform1ui(GLint l, GLuint v) { glCaptureCall(GLCAP_UNIFORM_1UI, false, l, v); glCapture.next.Uniform1ui(l, v); }
+inline void APIENTRY glCaptureBindBufferBase(GLenum t, GLuint i, GLuint b) { glCaptureCall(GLCAP_BIND_BUFFER_BASE, false, t, i, b); glCapture.next.BindBufferBase(t, i, b); }
+inline void APIENTRY glCaptureVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer)
+{
+    glCaptureCall(GLCAP_VERTEX_ATTRIB_I_POINTER, false, index, size, type, stride, (uint64_t)(uintptr_t)pointer);
+    glCapture.next.VertexAttribIPointer(index, size, type, stride, pointer);
+}
+// 计算着色器写命令缓冲，也算只产生输出的调用
+inline void APIENTRY glCaptureDispatchCompute(GLuint x, GLuint y, GLuint z) { glCaptureCall(GLCAP_DISPATCH_COMPUTE, true, x, y, z); glCapture.next.DispatchCompute(x, y, z); }
+inline void APIENTRY glCaptureMemoryBarrier(GLbitfield b) { glCaptureCall(GLCAP_MEMORY_BARRIER, true, b); glCapture.next.MemoryBarrier(b); }
+inline void APIENTRY glCaptureMultiDrawElementsIndirect(GLenum m, GLenum t, const void *indirect, GLsizei n, GLsizei stride)
+{
+    glCaptureCall(GLCAP_MULTI_DRAW_ELEMENTS_INDIRECT, true, m, t, (uint64_t)(uintptr_t)indirect, n, stride);
+    glCapture.next.MultiDrawElementsIndirect(m, t, indirect, n, stride);
+}
+
+inline void APIENTRY glCaptureTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    if (glCaptureActive())
+    {
+        glCaptureBegin(GLCAP_TEX_IMAGE_3D);
+        glCapturePutValue(target); glCapturePutValue(level); glCapturePutValue(internalFormat);
+        glCapturePutValue(width); glCapturePutValue(height); glCapturePutValue(depth); glCapturePutValue(border);
+        glCapturePutValue(format); glCapturePutValue(type);
+        uint64_t size = pixels && !glInterceptUnpackBufferBound() ? glCaptureImageSize(width, height, format, type) * depth : 0;
+        glCapturePutValue(size);
+        glCapturePut(pixels, size);
+        glCaptureEnd();
+    }
+    glCapture.next.TexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+}
+inline void APIENTRY glCaptureFramebufferTexture(GLenum t, GLenum a, GLuint tex, GLint l) { glCaptureCall(GLCAP_FRAMEBUFFER_TEXTURE, false, t, a, tex, l); glCapture.next.FramebufferTexture(t, a, tex, l); }
+inline void APIENTRY glCaptureFramebufferTextureLayer(GLenum t, GLenum a, GLuint tex, GLint l, GLint layer)
+{
+    glCaptureCall(GLCAP_FRAMEBUFFER_TEXTURE_LAYER, false, t, a, tex, l, layer);
+    glCapture.next.FramebufferTextureLayer(t, a, tex, l, layer);
+}
+
+inline void APIENTRY glCaptureClearStencil(GLint s) { glCaptureCall(GLCAP_CLEAR_STENCIL, false, s); glCapture.next.ClearStencil(s); }
+inline void APIENTRY glCaptureStencilFunc(GLenum f, GLint r, GLuint m) { glCaptureCall(GLCAP_STENCIL_FUNC, false, f, r, m); glCapture.next.StencilFunc(f, r, m); }
+inline void APIENTRY glCaptureStencilOp(GLenum sf, GLenum df, GLenum dp) { glCaptureCall(GLCAP_STENCIL_OP, false, sf, df, dp); glCapture.next.StencilOp(sf, df, dp); }
+inline void APIENTRY glCaptureStencilMask(GLuint m) { glCaptureCall(GLCAP_STENCIL_MASK, false, m); glCapture.next.StencilMask(m); }
+
+// 查询：结果的读取不录制，回放时只重现 GPU 上的开销和条件渲染
+inline void APIENTRY glCaptureGenQueries(GLsizei n, GLuint *ids) { glCapture.next.GenQueries(n, ids); glCaptureNames(GLCAP_GEN_QUERIES, n, ids); }
+inline void APIENTRY glCaptureDeleteQueries(GLsizei n, const GLuint *ids) { glCaptureNames(GLCAP_DELETE_QUERIES, n, ids); glCapture.next.DeleteQueries(n, ids); }
+inline void APIENTRY glCaptureBeginQuery(GLenum t, GLuint id) { glCaptureCall(GLCAP_BEGIN_QUERY, true, t, id); glCapture.next.BeginQuery(t, id); }
+inline void APIENTRY glCaptureEndQuery(GLenum t) { glCaptureCall(GLCAP_END_QUERY, true, t); glCapture.next.EndQuery(t); }
+inline void APIENTRY glCaptureQueryCounter(GLuint id, GLenum t) { glCaptureCall(GLCAP_QUERY_COUNTER, true, id, t); glCapture.next.QueryCounter(id, t); }
+inline void APIENTRY glCaptureBeginConditionalRender(GLuint id, GLenum m) { glCaptureCall(GLCAP_BEGIN_CONDITIONAL_RENDER, true, id, m); glCapture.next.BeginConditionalRender(id, m); }
+inline void APIENTRY glCaptureEndConditionalRender() { glCaptureCall(GLCAP_END_CONDITIONAL_RENDER, true); glCapture.next.EndConditionalRender(); }
+
+// 读回：回放时读到临时内存或者同样的像素缓冲里，重现同步和拷贝的开销
+inline void APIENTRY glCaptureReadBuffer(GLenum m) { glCaptureCall(GLCAP_READ_BUFFER, false, m); glCapture.next.ReadBuffer(m); }
+inline void APIENTRY glCaptureReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, void *pixels)
+{
+    glCaptureCall(GLCAP_READ_PIXELS, true, x, y, w, h, format, type, (uint64_t)(uintptr_t)pixels);
+    glCapture.next.ReadPixels(x, y, w, h, format, type, pixels);
+}
+// 只读的映射按原样回放；写入的映射在解除映射时把写进去的数据按 glBufferSubData 录制
+inline void *APIENTRY glCaptureMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    void *pointer = glCapture.next.MapBufferRange(target, offset, length, access);
+    if (glCaptureActive() && pointer)
+    {
+        glCapture.mappings.push_back({ target, offset, length, access, pointer });
+        if (!(access & GL_MAP_WRITE_BIT))
+            glCaptureCall(GLCAP_MAP_BUFFER_RANGE, false, target, (int64_t)offset, (int64_t)length, access);
+    }
+    return pointer;
+}
+inline GLboolean APIENTRY glCaptureUnmapBuffer(GLenum target)
+{
+    for (size_t i = 0; i < glCapture.mappings.size(); i++)
+    {
+        GLCaptureMapping mapping = glCapture.mappings[i];
+        if (mapping.target != target)
+            continue;
+        glCapture.mappings.erase(glCapture.mappings.begin() + i);
+        if (!glCaptureActive())
+            break;
+        if (mapping.access & GL_MAP_WRITE_BIT)
+        {
+            glCaptureBegin(GLCAP_BUFFER_SUB_DATA);
+            glCapturePutValue(target);
+            glCapturePutValue<int64_t>(mapping.offset);
+            glCapturePutValue<int64_t>(mapping.length);
+            glCapturePut(mapping.pointer, mapping.length);
+            glCaptureEnd();
+        }
+        else
+            glCaptureCall(GLCAP_UNMAP_BUFFER, false, target);
+        break;
+    }
+    return glCapture.next.UnmapBuffer(target);
+}
+// 同步对象按指针值记录，回放时对应到新的同步对象
+inline GLsync APIENTRY glCaptureFenceSync(GLenum c, GLbitfield f)
+{
+    GLsync sync = glCapture.next.FenceSync(c, f);
+    glCaptureCall(GLCAP_FENCE_SYNC, true, c, f, (uint64_t)(uintptr_t)sync);
+    return sync;
+}
+inline GLenum APIENTRY glCaptureClientWaitSync(GLsync sync, GLbitfield f, GLuint64 timeout)
+{
+    glCaptureCall(GLCAP_CLIENT_WAIT_SYNC, true, (uint64_t)(uintptr_t)sync, f, (uint64_t)timeout);
+    return glCapture.next.ClientWaitSync(sync, f, timeout);
+}
+inline void APIENTRY glCaptureDeleteSync(GLsync sync) { glCaptureCall(GLCAP_DELETE_SYNC, true, (uint64_t)(uintptr_t)sync); glCapture.next.DeleteSync(sync); }
+inline void APIENTRY glCaptureFlush() { glCaptureCall(GLCAP_FLUSH, true); glCapture.next.Flush(); }
+inline void APIENTRY glCaptureFinish() { glCaptureCall(GLCAP_FINISH, true); glCapture.next.Finish(); }
+
+#define GL_CAPTURE_FUNCTIONS(X) \
+    X(GenVertexArrays) X(GenBuffers) X(GenTextures) X(GenFramebuffers) X(GenRenderbuffers) \
+    X(DeleteVertexArrays) X(DeleteBuffers) X(DeleteTextures) X(DeleteFramebuffers) X(DeleteRenderbuffers) \
+    X(CreateShader) X(ShaderSource) X(CompileShader) X(DeleteShader) X(CreateProgram) X(AttachShader) \
+    X(LinkProgram) X(DeleteProgram) X(UseProgram) X(GetUniformLocation) \
+    X(Uniform1i) X(Uniform1f) X(Uniform2f) X(Uniform3f) X(Uniform4f) X(Uniform3fv) X(Uniform4fv) X(UniformMatrix4fv) \
+    X(BindVertexArray) X(BindBuffer) X(BufferData) X(BufferSubData) X(VertexAttribPointer) \
+    X(EnableVertexAttribArray) X(DisableVertexAttribArray) X(VertexAttribDivisor) \
+    X(ActiveTexture) X(BindTexture) X(TexParameteri) X(TexImage2D) X(TexSubImage2D) X(GenerateMipmap) X(PixelStorei) \
+    X(BindFramebuffer) X(FramebufferTexture2D) X(BindRenderbuffer) X(RenderbufferStorage) X(FramebufferRenderbuffer) \
+    X(BlitFramebuffer) \
+    X(Enable) X(Disable) X(BlendFunc) X(DepthFunc) X(DepthMask) X(ColorMask) X(CullFace) \
+    X(PolygonMode) X(Viewport) X(ClearColor) X(Clear) \
+    X(DrawArrays) X(DrawElements) X(DrawArraysInstanced) X(DrawElementsInstanced) \
+    X(Uniform1ui) X(BindBufferBase) X(VertexAttribIPointer) \
+    X(DispatchCompute) X(MemoryBarrier) X(MultiDrawElementsIndirect) \
+    X(TexImage3D) X(FramebufferTexture) X(FramebufferTextureLayer) \
+    X(ClearStencil) X(StencilFunc) X(StencilOp) X(StencilMask) \
+    X(GenQueries) X(DeleteQueries) X(BeginQuery) X(EndQuery) X(QueryCounter) \
+    X(BeginConditionalRender) X(EndConditionalRender) \
+    X(ReadBuffer) X(ReadPixels) X(MapBufferRange) X(UnmapBuffer) \
+    X(FenceSync) X(ClientWaitSync) X(DeleteSync) X(Flush) X(Finish)
+
+// 开始录制：从第 startFrame 帧开始录 frameCount 帧，写到 path
+// 第 0 帧里通常还有资源创建，所以最早从第 1 帧开始，保证初始化部分完整
+// width/height 是默认帧缓冲的大小，回放时用同样大小的离屏窗口
+inline void glCaptureInstall(const char *path, uint32_t startFrame, uint32_t frameCount, int width, int height)
+{
+    if (glCapture.installed)
+        return;
+    if (startFrame < 1)
+        startFrame = 1;
+#define GL_CAPTURE_INSTALL(name) \
+    glCapture.next.name = glad_gl##name; \
+    if (glad_gl##name) glad_gl##name = glCapture##name;
+    GL_CAPTURE_FUNCTIONS(GL_CAPTURE_INSTALL)
+#undef GL_CAPTURE_INSTALL
+    glCapture.installed = true;
+    glCapture.recording = frameCount > 0;
+    glCapture.inRange = false;
+    glCapture.startFrame = startFrame;
+    glCapture.frameCount = frameCount;
+    glCapture.thread = std::this_thread::get_id();
+    glCapture.path = path;
+    glCapture.header.width = width;
+    glCapture.header.height = height;
+    glCapture.data.reserve(1 << 20);
+}
+
+// 录制完成后还原函数指针
+inline void glCaptureUninstall()
+{
+    if (!glCapture.installed)
+        return;
+// 之后又有别的拦截层装在上面时不能直接还原，只停止录制，包装函数会原样转发
+#define GL_CAPTURE_UNINSTALL(name) \
+    if (glCapture.next.name && glad_gl##name == glCapture##name) glad_gl##name = glCapture.next.name;
+    GL_CAPTURE_FUNCTIONS(GL_CAPTURE_UNINSTALL)
+#undef GL_CAPTURE_UNINSTALL
+    glCapture.installed = false;
+    glCapture.recording = false;
+}
+
+// 录制结果写入文件
+inline bool glCaptureWrite()
+{
+    FILE *file = fopen(glCapture.path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::CAPTURE::FILE_OPEN_FAILED " << glCapture.path << std::endl;
+        return false;
+    }
+    glCapture.header.frameCount = glCapture.capturedFrames;
+    fwrite(&glCapture.header, sizeof(glCapture.header), 1, file);
+    fwrite(glCapture.data.data(), 1, glCapture.data.size(), file);
+    fclose(file);
+    std::cout << "Captured " << glCapture.capturedFrames << " frames (" << glCapture.data.size() << " bytes) to " << glCapture.path << std::endl;
+    glCapture.data.clear();
+    glCapture.data.shrink_to_fit();
+    return true;
+}
+
+// 每帧 swap 之前调用
+inline void glCaptureEndFrame()
+{
+    if (!glCapture.recording)
+        return;
+    if (glCapture.inRange)
+    {
+        glCaptureCall(GLCAP_FRAME_END, false);
+        glCapture.capturedFrames++;
+    }
+    else if (glCapture.frame + 1 == glCapture.startFrame)
+    {
+        // 初始化部分结束
+        glCaptureCall(GLCAP_FRAME_END, false);
+    }
+    glCapture.frame++;
+    glCapture.inRange = glCapture.frame >= glCapture.startFrame && glCapture.capturedFrames < glCapture.frameCount;
+    if (glCapture.capturedFrames >= glCapture.frameCount)
+    {
+        glCapture.recording = false;
+        glCaptureWrite();
+        glCaptureUninstall();
+    }
+}
+
+#endif /* gl_capture_h */
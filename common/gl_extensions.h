@@ -0,0 +1,57 @@
+//
+//  gl_extensions.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef gl_extensions_h
+#define gl_extensions_h
+
+#include <glad/glad.h>
+
+// glad 只生成了 3.3 的接口，用到的 4.3 函数在这里按 glad 的方式定义：
+// 全局函数指针 glad_glXxx + 同名宏，运行时取地址
+// 和 glad 的指针放在一起，调用拦截(gl_intercept.h)和录制(gl_capture.h)才能替换它们
+// 要在 gladLoadGLLoader 之后、安装任何拦截层之前调用 glExtensionsLoad
+//
+// 用法：
+//   gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+//   glExtensionsLoad((GLADloadproc)glfwGetProcAddress);
+//   if (glExtensionsCompute()) glDispatchCompute(...);
+
+#ifndef GL_VERSION_4_3
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount, GLsizei stride);
+inline PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = NULL;
+inline PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = NULL;
+inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = NULL;
+#define glDispatchCompute glad_glDispatchCompute
+#define glMemoryBarrier glad_glMemoryBarrier
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+// 上下文低于 4.3 时指针保持为空；已经取过的不再覆盖，避免把装好的拦截层换掉
+inline void glExtensionsLoad(GLADloadproc load)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major * 10 + minor < 43)
+        return;
+    if (!glad_glDispatchCompute)
+        glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+    if (!glad_glMemoryBarrier)
+        glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    if (!glad_glMultiDrawElementsIndirect)
+        glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+}
+
+// 计算着色器 + 间接绘制是否可用
+inline bool glExtensionsCompute()
+{
+    return glad_glDispatchCompute && glad_glMemoryBarrier && glad_glMultiDrawElementsIndirect;
+}
+
+#endif /* gl_extensions_h */
@@ -0,0 +1,303 @@
+//
+//  gl_intercept.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef gl_intercept_h
+#define gl_intercept_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "gl_extensions.h"
+
+// OpenGL 调用拦截层
+// glad 把每个 gl 函数都定义成了全局函数指针(glDrawArrays 实际是 glad_glDrawArrays)，
+// 所以在 gladLoadGLLoader 之后把这些指针换成我们的包装函数，就能统计每帧的调用情况：
+// 绘制调用、三角形数、状态切换、上传到缓冲/纹理的字节数、glGetUniformLocation 调用次数
+// 不安装时没有任何额外开销；安装后每个被拦截的调用多一次间接调用和几次加法
+//
+// 其它需要拦截调用的模块(比如调用录制)可以在此之后再替换同一个指针，
+// 只要保存被替换前的指针并在包装函数里调用它，就能形成调用链
+
+struct GLFrameCounters
+{
+    uint64_t drawCalls = 0;              // 绘制调用次数
+    uint64_t triangles = 0;              // 提交的三角形数(实例化绘制按实例数累计)
+    uint64_t stateChanges = 0;           // 状态切换：绑定、开关、混合/深度/视口设置等
+    uint64_t bufferBytes = 0;            // glBufferData / glBufferSubData 上传的字节数
+    uint64_t textureBytes = 0;           // glTexImage / glTexSubImage 上传的字节数
+    uint64_t uniformLocationQueries = 0; // glGetUniformLocation 调用次数
+    uint64_t dispatches = 0;             // 计算着色器调度次数
+};
+
+// 原始的函数指针，安装时保存
+struct GLRealFunctions
+{
+    PFNGLDRAWARRAYSPROC DrawArrays;
+    PFNGLDRAWELEMENTSPROC DrawElements;
+    PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+    PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced;
+    PFNGLDRAWRANGEELEMENTSPROC DrawRangeElements;
+    PFNGLDRAWELEMENTSBASEVERTEXPROC DrawElementsBaseVertex;
+    PFNGLMULTIDRAWARRAYSPROC MultiDrawArrays;
+    PFNGLMULTIDRAWELEMENTSPROC MultiDrawElements;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+    PFNGLDISPATCHCOMPUTEPROC DispatchCompute;
+    PFNGLMEMORYBARRIERPROC MemoryBarrier;
+    PFNGLENABLEPROC Enable;
+    PFNGLDISABLEPROC Disable;
+    PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBINDTEXTUREPROC BindTexture;
+    PFNGLACTIVETEXTUREPROC ActiveTexture;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+    PFNGLBLENDFUNCPROC BlendFunc;
+    PFNGLDEPTHFUNCPROC DepthFunc;
+    PFNGLDEPTHMASKPROC DepthMask;
+    PFNGLCOLORMASKPROC ColorMask;
+    PFNGLCULLFACEPROC CullFace;
+    PFNGLVIEWPORTPROC Viewport;
+    PFNGLPOLYGONMODEPROC PolygonMode;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLBUFFERSUBDATAPROC BufferSubData;
+    PFNGLTEXIMAGE2DPROC TexImage2D;
+    PFNGLTEXSUBIMAGE2DPROC TexSubImage2D;
+    PFNGLTEXIMAGE3DPROC TexImage3D;
+    PFNGLTEXSUBIMAGE3DPROC TexSubImage3D;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+};
+
+struct GLInterceptState
+{
+    bool installed = false;
+    GLRealFunctions real;
+    GLFrameCounters current;    // 当前帧累计中
+    GLFrameCounters lastFrame;  // 上一帧的结果
+    GLFrameCounters peak;       // 安装以来单帧最大值
+    uint64_t drawCallBudget = 0; // 大于 0 时，单帧绘制调用超出预算会打印警告
+};
+
+inline GLInterceptState glIntercept;
+
+// 图元数换算成三角形数
+inline uint64_t glInterceptTriangles(GLenum mode, GLsizei count)
+{
+    if (mode == GL_TRIANGLES)
+        return count / 3;
+    if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+        return count - 2;
+    return 0;
+}
+
+// 一个像素占的字节数，只覆盖常见格式
+inline uint64_t glInterceptPixelBytes(GLenum format, GLenum type)
+{
+    int components = 4;
+    switch (format)
+    {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+        default: components = 4; break;
+    }
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+        case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_5_5_5_1: return 2;
+        case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_8_8_8_8_REV: case GL_UNSIGNED_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV: return 4;
+        default: return components * 4;
+    }
+}
+
+// 是否有像素缓冲绑定在 GL_PIXEL_UNPACK_BUFFER 上，此时 data 是偏移量，0 也是合法的上传
+inline bool glInterceptUnpackBufferBound()
+{
+    GLint buffer = 0;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &buffer);
+    return buffer != 0;
+}
+
+// 包装函数
+inline void APIENTRY glInterceptDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count);
+    glIntercept.real.DrawArrays(mode, first, count);
+}
+inline void APIENTRY glInterceptDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count);
+    glIntercept.real.DrawElements(mode, count, type, indices);
+}
+inline void APIENTRY glInterceptDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count) * instances;
+    glIntercept.real.DrawArraysInstanced(mode, first, count, instances);
+}
+inline void APIENTRY glInterceptDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instances)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count) * instances;
+    glIntercept.real.DrawElementsInstanced(mode, count, type, indices, instances);
+}
+inline void APIENTRY glInterceptDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count);
+    glIntercept.real.DrawRangeElements(mode, start, end, count, type, indices);
+}
+inline void APIENTRY glInterceptDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint baseVertex)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.current.triangles += glInterceptTriangles(mode, count);
+    glIntercept.real.DrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+inline void APIENTRY glInterceptMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount)
+{
+    glIntercept.current.drawCalls++;
+    for (GLsizei i = 0; i < drawCount; i++)
+        glIntercept.current.triangles += glInterceptTriangles(mode, count[i]);
+    glIntercept.real.MultiDrawArrays(mode, first, count, drawCount);
+}
+inline void APIENTRY glInterceptMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawCount)
+{
+    glIntercept.current.drawCalls++;
+    for (GLsizei i = 0; i < drawCount; i++)
+        glIntercept.current.triangles += glInterceptTriangles(mode, count[i]);
+    glIntercept.real.MultiDrawElements(mode, count, type, indices, drawCount);
+}
+// 间接绘制的命令在 GPU 上生成，CPU 不知道三角形数，和 glMultiDrawElements 一样算一次绘制调用
+inline void APIENTRY glInterceptMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount, GLsizei stride)
+{
+    glIntercept.current.drawCalls++;
+    glIntercept.real.MultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+}
+inline void APIENTRY glInterceptDispatchCompute(GLuint x, GLuint y, GLuint z)
+{
+    glIntercept.current.dispatches++;
+    glIntercept.real.DispatchCompute(x, y, z);
+}
+inline void APIENTRY glInterceptMemoryBarrier(GLbitfield barriers) { glIntercept.current.stateChanges++; glIntercept.real.MemoryBarrier(barriers); }
+
+inline void APIENTRY glInterceptEnable(GLenum cap) { glIntercept.current.stateChanges++; glIntercept.real.Enable(cap); }
+inline void APIENTRY glInterceptDisable(GLenum cap) { glIntercept.current.stateChanges++; glIntercept.real.Disable(cap); }
+inline void APIENTRY glInterceptUseProgram(GLuint program) { glIntercept.current.stateChanges++; glIntercept.real.UseProgram(program); }
+inline void APIENTRY glInterceptBindVertexArray(GLuint array) { glIntercept.current.stateChanges++; glIntercept.real.BindVertexArray(array); }
+inline void APIENTRY glInterceptBindBuffer(GLenum target, GLuint buffer) { glIntercept.current.stateChanges++; glIntercept.real.BindBuffer(target, buffer); }
+inline void APIENTRY glInterceptBindTexture(GLenum target, GLuint texture) { glIntercept.current.stateChanges++; glIntercept.real.BindTexture(target, texture); }
+inline void APIENTRY glInterceptActiveTexture(GLenum texture) { glIntercept.current.stateChanges++; glIntercept.real.ActiveTexture(texture); }
+inline void APIENTRY glInterceptBindFramebuffer(GLenum target, GLuint framebuffer) { glIntercept.current.stateChanges++; glIntercept.real.BindFramebuffer(target, framebuffer); }
+inline void APIENTRY glInterceptBlendFunc(GLenum s, GLenum d) { glIntercept.current.stateChanges++; glIntercept.real.BlendFunc(s, d); }
+inline void APIENTRY glInterceptDepthFunc(GLenum func) { glIntercept.current.stateChanges++; glIntercept.real.DepthFunc(func); }
+inline void APIENTRY glInterceptDepthMask(GLboolean flag) { glIntercept.current.stateChanges++; glIntercept.real.DepthMask(flag); }
+inline void APIENTRY glInterceptColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) { glIntercept.current.stateChanges++; glIntercept.real.ColorMask(r, g, b, a); }
+inline void APIENTRY glInterceptCullFace(GLenum mode) { glIntercept.current.stateChanges++; glIntercept.real.CullFace(mode); }
+inline void APIENTRY glInterceptViewport(GLint x, GLint y, GLsizei w, GLsizei h) { glIntercept.current.stateChanges++; glIntercept.real.Viewport(x, y, w, h); }
+inline void APIENTRY glInterceptPolygonMode(GLenum face, GLenum mode) { glIntercept.current.stateChanges++; glIntercept.real.PolygonMode(face, mode); }
+
+inline void APIENTRY glInterceptBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    if (data)
+        glIntercept.current.bufferBytes += size;
+    glIntercept.real.BufferData(target, size, data, usage);
+}
+inline void APIENTRY glInterceptBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+    glIntercept.current.bufferBytes += size;
+    glIntercept.real.BufferSubData(target, offset, size, data);
+}
+inline void APIENTRY glInterceptTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    if (pixels || glInterceptUnpackBufferBound())
+        glIntercept.current.textureBytes += (uint64_t)width * height * glInterceptPixelBytes(format, type);
+    glIntercept.real.TexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+inline void APIENTRY glInterceptTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+{
+    glIntercept.current.textureBytes += (uint64_t)width * height * glInterceptPixelBytes(format, type);
+    glIntercept.real.TexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+inline void APIENTRY glInterceptTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    if (pixels || glInterceptUnpackBufferBound())
+        glIntercept.current.textureBytes += (uint64_t)width * height * depth * glInterceptPixelBytes(format, type);
+    glIntercept.real.TexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+}
+inline void APIENTRY glInterceptTexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels)
+{
+    glIntercept.current.textureBytes += (uint64_t)width * height * depth * glInterceptPixelBytes(format, type);
+    glIntercept.real.TexSubImage3D(target, level, x, y, z, width, height, depth, format, type, pixels);
+}
+inline GLint APIENTRY glInterceptGetUniformLocation(GLuint program, const GLchar *name)
+{
+    glIntercept.current.uniformLocationQueries++;
+    return glIntercept.real.GetUniformLocation(program, name);
+}
+
+// 替换/还原 glad 的函数指针
+#define GL_INTERCEPT_FUNCTIONS(X) \
+    X(DrawArrays) X(DrawElements) X(DrawArraysInstanced) X(DrawElementsInstanced) X(DrawRangeElements) \
+    X(DrawElementsBaseVertex) X(MultiDrawArrays) X(MultiDrawElements) \
+    X(MultiDrawElementsIndirect) X(DispatchCompute) X(MemoryBarrier) \
+    X(Enable) X(Disable) X(UseProgram) X(BindVertexArray) X(BindBuffer) X(BindTexture) X(ActiveTexture) \
+    X(BindFramebuffer) X(BlendFunc) X(DepthFunc) X(DepthMask) X(ColorMask) X(CullFace) X(Viewport) X(PolygonMode) \
+    X(BufferData) X(BufferSubData) X(TexImage2D) X(TexSubImage2D) X(TexImage3D) X(TexSubImage3D) \
+    X(GetUniformLocation)
+
+// 在 gladLoadGLLoader 之后调用
+inline void glInterceptInstall()
+{
+    if (glIntercept.installed)
+        return;
+    // 驱动没有提供的函数保持为空，不替换
+#define GL_INTERCEPT_INSTALL(name) \
+    glIntercept.real.name = glad_gl##name; \
+    if (glad_gl##name) glad_gl##name = glIntercept##name;
+    GL_INTERCEPT_FUNCTIONS(GL_INTERCEPT_INSTALL)
+#undef GL_INTERCEPT_INSTALL
+    glIntercept.current = GLFrameCounters();
+    glIntercept.installed = true;
+}
+
+// 还原原始指针，之后不再有额外开销
+// 注意：如果之后又有别的模块替换了同一个指针，需要先卸载那个模块
+inline void glInterceptUninstall()
+{
+    if (!glIntercept.installed)
+        return;
+#define GL_INTERCEPT_UNINSTALL(name) \
+    if (glIntercept.real.name) glad_gl##name = glIntercept.real.name;
+    GL_INTERCEPT_FUNCTIONS(GL_INTERCEPT_UNINSTALL)
+#undef GL_INTERCEPT_UNINSTALL
+    glIntercept.installed = false;
+}
+
+// 每帧结束时调用(swap 之前)，保存本帧计数并清零
+inline const GLFrameCounters &glInterceptEndFrame()
+{
+    GLFrameCounters &frame = glIntercept.current;
+    GLFrameCounters &peak = glIntercept.peak;
+    peak.drawCalls = frame.drawCalls > peak.drawCalls ? frame.drawCalls : peak.drawCalls;
+    peak.triangles = frame.triangles > peak.triangles ? frame.triangles : peak.triangles;
+    peak.stateChanges = frame.stateChanges > peak.stateChanges ? frame.stateChanges : peak.stateChanges;
+    peak.bufferBytes = frame.bufferBytes > peak.bufferBytes ? frame.bufferBytes : peak.bufferBytes;
+    peak.textureBytes = frame.textureBytes > peak.textureBytes ? frame.textureBytes : peak.textureBytes;
+    peak.uniformLocationQueries = frame.uniformLocationQueries > peak.uniformLocationQueries ? frame.uniformLocationQueries : peak.uniformLocationQueries;
+    peak.dispatches = frame.dispatches > peak.dispatches ? frame.dispatches : peak.dispatches;
+    if (glIntercept.drawCallBudget && frame.drawCalls > glIntercept.drawCallBudget)
+        std::cout << "WARNING::GL::DRAW_CALL_BUDGET_EXCEEDED " << frame.drawCalls << " > " << glIntercept.drawCallBudget << std::endl;
+    glIntercept.lastFrame = frame;
+    frame = GLFrameCounters();
+    return glIntercept.lastFrame;
+}
+
+#endif /* gl_intercept_h */
@@ -0,0 +1,363 @@
+//
+//  gpu_culling.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef gpu_culling_h
+#define gpu_culling_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "gl_extensions.h"
+
+// glad 只生成了 3.3 的接口，4.3 的枚举自己定义，函数在 gl_extensions.h 里取
+#ifndef GL_SHADER_STORAGE_BUFFER
+    #define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+    #define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMPUTE_SHADER
+    #define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+    #define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+    #define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+
+// GPU 驱动的剔除和提交
+// 物体的包围球和模型矩阵放在 SSBO 里，计算着色器做视锥剔除，
+// 为每个物体写一条 DrawElementsIndirectCommand(不可见的 instanceCount 为 0)，
+// 然后一次 glMultiDrawElementsIndirect 画完，CPU 每帧的提交和物体数量无关
+//
+// 渲染用的顶点着色器从 SSBO 取模型矩阵：物体编号是一个 divisor 为 1 的整数属性，
+// 每条命令的 baseInstance 就是物体编号，所以第 i 条命令读到的编号是 i
+//   layout (location = 2) in uint aObjectId;
+//   layout (std430, binding = 0) readonly buffer Objects { GpuCullObject objects[]; };
+//   gl_Position = projection * view * objects[aObjectId].model * vec4(aPos, 1.0);
+//
+// 需要 OpenGL 4.3(计算着色器、SSBO、glMultiDrawElementsIndirect)，
+// macOS 最高只有 4.1，这时退化成 CPU 逐个物体做视锥剔除再逐个 glDrawElements，用普通的 model uniform
+//
+// 用法：
+//   GpuCuller culler;
+//   culler.init(VAO, indexCount, boundsCenter, boundsRadius, 2);
+//   int object = culler.addObject(model);
+//   culler.setTransform(object, model);                   // 只有变了的物体才需要
+//   culler.draw(projection * view, program, modelLoc);     // program 按 culler.gpuDriven() 选择
+
+// 和 glMultiDrawElementsIndirect 要求的布局一致
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// SSBO 里每个物体的数据，std430 布局
+struct GpuCullObject
+{
+    glm::mat4 model;
+    glm::vec4 sphere; // 模型空间的包围球，xyz 中心，w 半径
+};
+
+// 从 projection * view 提取视锥的 6 个平面，法线朝内并归一化
+inline void extractFrustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6])
+{
+    glm::mat4 m = glm::transpose(viewProjection);
+    planes[0] = m[3] + m[0]; // 左
+    planes[1] = m[3] - m[0]; // 右
+    planes[2] = m[3] + m[1]; // 下
+    planes[3] = m[3] - m[1]; // 上
+    planes[4] = m[3] + m[2]; // 近
+    planes[5] = m[3] - m[2]; // 远
+    for (int i = 0; i < 6; i++)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// 包围球是否和视锥相交，模型矩阵有缩放时半径取最大的缩放
+inline bool sphereInFrustum(const glm::vec4 planes[6], const glm::mat4 &model, const glm::vec4 &sphere)
+{
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float radius = sphere.w * scale;
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+            return false;
+    }
+    return true;
+}
+
+// 非索引的三角形列表去掉重复顶点，转成顶点 + 索引
+inline void buildIndexedMesh(const float *vertices, int stride, int count, std::vector<float> &outVertices, std::vector<GLuint> &outIndices)
+{
+    outVertices.clear();
+    outIndices.clear();
+    for (int i = 0; i < count; i++)
+    {
+        const float *v = vertices + i * stride;
+        GLuint index = (GLuint)(outVertices.size() / stride);
+        for (GLuint k = 0; k < index; k++)
+        {
+            if (std::equal(v, v + stride, outVertices.begin() + k * stride))
+            {
+                index = k;
+                break;
+            }
+        }
+        if (index == outVertices.size() / stride)
+            outVertices.insert(outVertices.end(), v, v + stride);
+        outIndices.push_back(index);
+    }
+}
+
+// 剔除用的计算着色器，每个线程处理一个物体
+inline const char *gpuCullComputeSource = R"(#version 430 core
+layout (local_size_x = 64) in;
+struct GpuCullObject
+{
+    mat4 model;
+    vec4 sphere;
+};
+struct DrawElementsIndirectCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+layout (std430, binding = 0) readonly buffer Objects { GpuCullObject objects[]; };
+layout (std430, binding = 1) writeonly buffer Commands { DrawElementsIndirectCommand commands[]; };
+uniform vec4 planes[6];
+uniform uint objectCount;
+uniform uint indexCount;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= objectCount)
+        return;
+    mat4 model = objects[i].model;
+    vec3 center = (model * vec4(objects[i].sphere.xyz, 1.0)).xyz;
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = objects[i].sphere.w * scale;
+    bool visible = true;
+    for (int p = 0; p < 6; p++)
+        visible = visible && dot(planes[p].xyz, center) + planes[p].w >= -radius;
+    commands[i].count = indexCount;
+    commands[i].instanceCount = visible ? 1u : 0u;
+    commands[i].firstIndex = 0u;
+    commands[i].baseVertex = 0;
+    commands[i].baseInstance = i;
+}
+)";
+
+class GpuCuller
+{
+public:
+    static const int WORKGROUP_SIZE = 64;
+
+    // 所有物体共用一个网格：vertexArray 里已经绑好顶点属性和索引缓冲(GL_UNSIGNED_INT)
+    // objectIdLocation 是渲染着色器里物体编号属性的位置
+    void init(GLuint vertexArray, GLsizei meshIndexCount, const glm::vec3 &boundsCenter, float boundsRadius, GLuint objectIdLocation)
+    {
+        vao = vertexArray;
+        indexCount = meshIndexCount;
+        sphere = glm::vec4(boundsCenter, boundsRadius);
+        idLocation = objectIdLocation;
+        gpu = loadFunctions() && createComputeProgram();
+        if (gpu)
+        {
+            glGenBuffers(1, &objectBuffer);
+            glGenBuffers(1, &commandBuffer);
+            glGenBuffers(1, &idBuffer);
+        }
+        std::cout << "GpuCuller: " << (gpu ? "compute shader culling + glMultiDrawElementsIndirect" : "OpenGL 4.3 not available, CPU culling") << std::endl;
+    }
+
+    void release()
+    {
+        if (!gpu)
+            return;
+        glDeleteProgram(computeProgram);
+        glDeleteBuffers(1, &objectBuffer);
+        glDeleteBuffers(1, &commandBuffer);
+        glDeleteBuffers(1, &idBuffer);
+    }
+
+    int addObject(const glm::mat4 &model)
+    {
+        objects.push_back({ model, sphere });
+        markDirty((int)objects.size() - 1);
+        return (int)objects.size() - 1;
+    }
+
+    void setTransform(int object, const glm::mat4 &model)
+    {
+        objects[object].model = model;
+        markDirty(object);
+    }
+
+    // 是否走 GPU 路径，决定渲染时用哪个着色器
+    bool gpuDriven() const { return gpu; }
+    // CPU 路径上一次画了多少个物体，GPU 路径不读回，返回物体总数
+    int lastDrawCount() const { return drawCount; }
+
+    // 剔除并绘制，program 是当前路径的渲染程序(调用前设置好 view、projection 等 uniform)
+    // modelLocation 只在 CPU 路径使用
+    void draw(const glm::mat4 &viewProjection, GLuint program, GLint modelLocation)
+    {
+        glm::vec4 planes[6];
+        extractFrustumPlanes(viewProjection, planes);
+        if (!gpu)
+        {
+            drawCpu(planes, program, modelLocation);
+            return;
+        }
+
+        GLuint count = (GLuint)objects.size();
+        upload();
+        // 剔除：每个物体写一条命令
+        glUseProgram(computeProgram);
+        glUniform4fv(glGetUniformLocation(computeProgram, "planes"), 6, &planes[0][0]);
+        glUniform1ui(glGetUniformLocation(computeProgram, "objectCount"), count);
+        glUniform1ui(glGetUniformLocation(computeProgram, "indexCount"), (GLuint)indexCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objectBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+        glDispatchCompute((count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        // 命令缓冲作为间接绘制参数读取之前，计算着色器的写入必须完成
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(program);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)0, (GLsizei)count, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        drawCount = (int)count;
+    }
+
+private:
+    GLuint vao = 0;
+    GLsizei indexCount = 0;
+    glm::vec4 sphere = glm::vec4(0.0f);
+    GLuint idLocation = 0;
+    bool gpu = false;
+    GLuint computeProgram = 0;
+    GLuint objectBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint idBuffer = 0;
+    size_t bufferCapacity = 0; // 缓冲按物体数分配的容量
+    std::vector<GpuCullObject> objects;
+    int dirtyBegin = INT32_MAX, dirtyEnd = 0; // 需要上传的物体范围 [dirtyBegin, dirtyEnd)
+    int drawCount = 0;
+
+    // 一般在 gladLoadGLLoader 之后已经取过，这里补一次，已经取到的不会被覆盖
+    bool loadFunctions()
+    {
+        glExtensionsLoad((GLADloadproc)glfwGetProcAddress);
+        return glExtensionsCompute();
+    }
+
+    bool createComputeProgram()
+    {
+        int success;
+        char infoLog[512];
+        GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &gpuCullComputeSource, NULL);
+        glCompileShader(shader);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+            glDeleteShader(shader);
+            return false;
+        }
+        computeProgram = glCreateProgram();
+        glAttachShader(computeProgram, shader);
+        glLinkProgram(computeProgram);
+        glDeleteShader(shader);
+        glGetProgramiv(computeProgram, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(computeProgram, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(computeProgram);
+            computeProgram = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void markDirty(int object)
+    {
+        dirtyBegin = std::min(dirtyBegin, object);
+        dirtyEnd = std::max(dirtyEnd, object + 1);
+    }
+
+    // 只上传改过的物体；物体数变多时重新分配缓冲，同时更新物体编号属性
+    void upload()
+    {
+        if (objects.size() > bufferCapacity)
+        {
+            bufferCapacity = std::max(objects.size(), bufferCapacity * 2);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bufferCapacity * sizeof(GpuCullObject), NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bufferCapacity * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_COPY);
+
+            std::vector<GLuint> ids(bufferCapacity);
+            for (size_t i = 0; i < ids.size(); i++)
+                ids[i] = (GLuint)i;
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, idBuffer);
+            glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+            glVertexAttribIPointer(idLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *)0);
+            glVertexAttribDivisor(idLocation, 1);
+            glEnableVertexAttribArray(idLocation);
+            dirtyBegin = 0;
+            dirtyEnd = (int)objects.size();
+        }
+        if (dirtyBegin < dirtyEnd)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, dirtyBegin * sizeof(GpuCullObject),
+                            (dirtyEnd - dirtyBegin) * sizeof(GpuCullObject), &objects[dirtyBegin]);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        dirtyBegin = INT32_MAX;
+        dirtyEnd = 0;
+    }
+
+    void drawCpu(const glm::vec4 planes[6], GLuint program, GLint modelLocation)
+    {
+        glUseProgram(program);
+        glBindVertexArray(vao);
+        drawCount = 0;
+        for (const GpuCullObject &object : objects)
+        {
+            if (!sphereInFrustum(planes, object.model, object.sphere))
+                continue;
+            glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(object.model));
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void *)0);
+            drawCount++;
+        }
+        dirtyBegin = INT32_MAX;
+        dirtyEnd = 0;
+    }
+};
+
+#endif /* gpu_culling_h */
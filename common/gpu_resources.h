@@ -0,0 +1,354 @@
+//
+//  gpu_resources.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef gpu_resources_h
+#define gpu_resources_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <tuple>
+#include <vector>
+
+// GPU 资源池
+// VAO、缓冲、纹理、程序各有一个池，对外只给带代数(generation)的句柄，不直接暴露 OpenGL 的名字：
+//   - 句柄 = 槽位下标 + 代数，查找是一次数组访问，O(1)
+//   - 销毁后槽位的代数加一，旧句柄再查找只会得到 0，不会误用被复用的槽位
+//   - 销毁的对象先放进待删除队列，等最后使用它的那一帧的 fence 完成后才真正 glDelete，
+//     不会因为删除 GPU 还在用的对象而让驱动同步等待
+//   - release 时统计没有销毁的句柄，报告泄漏并统一删除
+//
+// 用法：
+//   GpuResources resources;
+//   TextureHandle texture = resources.createTexture();
+//   glBindTexture(GL_TEXTURE_2D, resources.get(texture)); // get 会记录这一帧用到了它
+//   resources.destroy(texture);
+//   resources.endFrame();                                 // 每帧 swap 之前调用
+//   resources.release();                                  // OpenGL 上下文销毁前调用
+
+template <typename Tag>
+struct GpuHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0; // 0 表示空句柄
+
+    bool valid() const { return generation != 0; }
+    bool operator==(const GpuHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GpuHandle &other) const { return !(*this == other); }
+};
+
+struct VertexArrayTag {};
+struct BufferTag {};
+struct TextureTag {};
+struct ProgramTag {};
+typedef GpuHandle<VertexArrayTag> VertexArrayHandle;
+typedef GpuHandle<BufferTag> BufferHandle;
+typedef GpuHandle<TextureTag> TextureHandle;
+typedef GpuHandle<ProgramTag> ProgramHandle;
+
+// 池的占用情况
+struct GpuPoolStats
+{
+    size_t live = 0;     // 存活的句柄
+    size_t peak = 0;     // 存活句柄的峰值
+    size_t capacity = 0; // 槽位总数
+    size_t pending = 0;  // 已销毁、等待 GPU 用完后删除的对象
+};
+
+// 一种资源的池，槽位连续存放，空闲槽位用栈复用
+template <typename Tag>
+class GpuResourcePool
+{
+public:
+    typedef GpuHandle<Tag> Handle;
+
+    Handle add(GLuint name)
+    {
+        uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        Slot &slot = slots[index];
+        slot.name = name;
+        slot.lastUsedFrame = -1;
+        live++;
+        if (live > peak)
+            peak = live;
+        Handle handle;
+        handle.index = index;
+        handle.generation = slot.generation;
+        return handle;
+    }
+
+    bool alive(Handle handle) const
+    {
+        return handle.valid() && handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    // 句柄失效时返回 0
+    GLuint get(Handle handle, int64_t frame)
+    {
+        if (!alive(handle))
+            return 0;
+        Slot &slot = slots[handle.index];
+        slot.lastUsedFrame = frame;
+        return slot.name;
+    }
+
+    // 让句柄失效，返回 OpenGL 名字和最后使用的帧，由调用者推迟删除
+    bool remove(Handle handle, GLuint &name, int64_t &lastUsedFrame)
+    {
+        if (!alive(handle))
+            return false;
+        Slot &slot = slots[handle.index];
+        name = slot.name;
+        lastUsedFrame = slot.lastUsedFrame;
+        slot.name = 0;
+        // 代数跳过 0，0 留给空句柄
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        freeSlots.push_back(handle.index);
+        live--;
+        return true;
+    }
+
+    // 遍历存活的对象，release 时用
+    template <typename Fn>
+    void forEachLive(Fn fn) const
+    {
+        for (const Slot &slot : slots)
+        {
+            if (slot.name)
+                fn(slot.name);
+        }
+    }
+
+    void clear()
+    {
+        slots.clear();
+        freeSlots.clear();
+        live = 0;
+    }
+
+    GpuPoolStats stats() const
+    {
+        GpuPoolStats stats;
+        stats.live = live;
+        stats.peak = peak;
+        stats.capacity = slots.size();
+        return stats;
+    }
+
+private:
+    struct Slot
+    {
+        GLuint name = 0;
+        uint32_t generation = 1;
+        int64_t lastUsedFrame = -1;
+    };
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t live = 0;
+    size_t peak = 0;
+};
+
+class GpuResources
+{
+public:
+    // 同时在途的帧数上限，超过时 endFrame 会等最早的 fence，避免 fence 无限堆积
+    static const size_t MAX_FRAMES_IN_FLIGHT = 8;
+
+    VertexArrayHandle createVertexArray()
+    {
+        GLuint name;
+        glGenVertexArrays(1, &name);
+        return pool<VertexArrayTag>().add(name);
+    }
+    BufferHandle createBuffer()
+    {
+        GLuint name;
+        glGenBuffers(1, &name);
+        return pool<BufferTag>().add(name);
+    }
+    TextureHandle createTexture()
+    {
+        GLuint name;
+        glGenTextures(1, &name);
+        return pool<TextureTag>().add(name);
+    }
+    // 程序通常由着色器加载代码创建，创建好后交给资源池管理
+    ProgramHandle adoptProgram(GLuint program)
+    {
+        return pool<ProgramTag>().add(program);
+    }
+
+    // 取得 OpenGL 名字，同时记录这一帧用到了它；句柄已经失效时返回 0
+    template <typename Tag>
+    GLuint get(GpuHandle<Tag> handle)
+    {
+        return pool<Tag>().get(handle, frame);
+    }
+
+    template <typename Tag>
+    bool alive(GpuHandle<Tag> handle) const
+    {
+        return std::get<GpuResourcePool<Tag>>(pools).alive(handle);
+    }
+
+    // 句柄立即失效，对象在 GPU 用完之后才删除
+    template <typename Tag>
+    void destroy(GpuHandle<Tag> &handle)
+    {
+        PendingDelete pending;
+        if (pool<Tag>().remove(handle, pending.name, pending.lastUsedFrame))
+        {
+            pending.kind = kindOf(Tag());
+            // 没有用过或者用它的帧已经完成，直接删除
+            if (pending.lastUsedFrame <= completedFrame)
+                deleteObject(pending.kind, pending.name);
+            else
+            {
+                pendingDeletes.push_back(pending);
+                pendingCounts[pending.kind]++;
+            }
+        }
+        handle = GpuHandle<Tag>();
+    }
+
+    // 每帧结束时调用：给这一帧插入 fence，删除 GPU 已经用完的对象
+    void endFrame()
+    {
+        fences.push_back({ frame, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+        frame++;
+        collect(fences.size() > MAX_FRAMES_IN_FLIGHT);
+    }
+
+    template <typename Tag>
+    GpuPoolStats stats() const
+    {
+        GpuPoolStats stats = std::get<GpuResourcePool<Tag>>(pools).stats();
+        stats.pending = pendingCounts[kindOf(Tag())];
+        return stats;
+    }
+
+    // 等 GPU 完成后删除所有对象，没有 destroy 的句柄算作泄漏
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        glFinish();
+        for (Fence &fence : fences)
+            glDeleteSync(fence.sync);
+        fences.clear();
+        for (const PendingDelete &pending : pendingDeletes)
+            deleteObject(pending.kind, pending.name);
+        pendingDeletes.clear();
+        for (size_t &count : pendingCounts)
+            count = 0;
+        releasePool<VertexArrayTag>("vertex array");
+        releasePool<BufferTag>("buffer");
+        releasePool<TextureTag>("texture");
+        releasePool<ProgramTag>("program");
+    }
+
+private:
+    enum Kind { VERTEX_ARRAY, BUFFER, TEXTURE, PROGRAM, KIND_COUNT };
+    static Kind kindOf(VertexArrayTag) { return VERTEX_ARRAY; }
+    static Kind kindOf(BufferTag) { return BUFFER; }
+    static Kind kindOf(TextureTag) { return TEXTURE; }
+    static Kind kindOf(ProgramTag) { return PROGRAM; }
+
+    struct PendingDelete
+    {
+        Kind kind;
+        GLuint name;
+        int64_t lastUsedFrame;
+    };
+    struct Fence
+    {
+        int64_t frame;
+        GLsync sync;
+    };
+
+    std::tuple<GpuResourcePool<VertexArrayTag>, GpuResourcePool<BufferTag>,
+               GpuResourcePool<TextureTag>, GpuResourcePool<ProgramTag>> pools;
+    std::vector<PendingDelete> pendingDeletes;
+    size_t pendingCounts[KIND_COUNT] = {};
+    std::deque<Fence> fences;
+    int64_t frame = 0;
+    int64_t completedFrame = -1; // GPU 已经完成的最后一帧
+
+    template <typename Tag>
+    GpuResourcePool<Tag> &pool()
+    {
+        return std::get<GpuResourcePool<Tag>>(pools);
+    }
+
+    static void deleteObject(Kind kind, GLuint name)
+    {
+        switch (kind)
+        {
+            case VERTEX_ARRAY: glDeleteVertexArrays(1, &name); break;
+            case BUFFER: glDeleteBuffers(1, &name); break;
+            case TEXTURE: glDeleteTextures(1, &name); break;
+            case PROGRAM: glDeleteProgram(name); break;
+            default: break;
+        }
+    }
+
+    // 检查已完成的 fence，不等待；wait 为 true 时等最早的那个完成
+    void collect(bool wait)
+    {
+        while (!fences.empty())
+        {
+            Fence &fence = fences.front();
+            GLenum result = glClientWaitSync(fence.sync, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+                break;
+            completedFrame = fence.frame;
+            glDeleteSync(fence.sync);
+            fences.pop_front();
+            wait = false;
+        }
+
+        // 最后一次使用已经完成的对象可以删除了
+        size_t kept = 0;
+        for (size_t i = 0; i < pendingDeletes.size(); i++)
+        {
+            PendingDelete &pending = pendingDeletes[i];
+            if (pending.lastUsedFrame <= completedFrame)
+            {
+                deleteObject(pending.kind, pending.name);
+                pendingCounts[pending.kind]--;
+            }
+            else
+                pendingDeletes[kept++] = pending;
+        }
+        pendingDeletes.resize(kept);
+    }
+
+    template <typename Tag>
+    void releasePool(const char *label)
+    {
+        GpuResourcePool<Tag> &resources = pool<Tag>();
+        size_t leaked = resources.stats().live;
+        if (leaked)
+            printf("GpuResources: %zu %s object(s) were never destroyed\n", leaked, label);
+        Kind kind = kindOf(Tag());
+        resources.forEachLive([kind](GLuint name) { deleteObject(kind, name); });
+        resources.clear();
+    }
+};
+
+#endif /* gpu_resources_h */
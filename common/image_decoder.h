@@ -0,0 +1,1336 @@
+//
+//  image_decoder.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef image_decoder_h
+#define image_decoder_h
+
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "simd.h"
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define JPEG_AVX2 1
+#endif
+#if defined(__SSSE3__)
+    #include <tmmintrin.h>
+    #define IMAGE_SSSE3 1
+#endif
+
+// 图片解码
+// 解码后端接口 + 两个后端：
+//   - JpegSimdBackend：基线(baseline)JPEG，IDCT 和颜色转换走 SIMD(AVX2 一次一行 8 个，否则用 simd.h 的 4 路)；
+//     有重启间隔(DRI)时按 RST 标记切段，多线程并行解码；全 0 交流系数的块跳过 IDCT；
+//     色度上采样和 libjpeg 的 fancy upsampling 一致
+//   - StbImageBackend：其它格式，以及渐进式、CMYK、多次扫描等 JPEG 的后备
+// imageDecoder.decode 按顺序找第一个能解码的后端，失败时交给下一个
+//
+// 翻转、通道数、行对齐都是每次调用的选项(ImageDecodeOptions)，没有全局状态，多个线程可以同时解码；
+// 不要再调用 stbi_set_flip_vertically_on_load
+// decodeInto 直接写进调用者的缓冲(比如 glMapBufferRange 映射的 PBO)，翻转和通道转换在写的时候完成，
+// JPEG 后端不再经过中间的整张图
+// 解码用的临时缓冲从 ImageAllocator 分配，默认是全局的 imagePool
+//
+// stb_image 的实现(STB_IMAGE_IMPLEMENTATION)仍然由 demo 的一个源文件提供
+//
+// 用法：
+//   ImageDecodeOptions options;
+//   options.channels = 4;
+//   options.flipVertically = true;
+//   DecodedImage image;
+//   if (imageDecoder.decode(data, size, options, image))
+//       glTexImage2D(GL_TEXTURE_2D, 0, image.layout.glInternalFormat(), image.layout.width, image.layout.height, 0,
+//                    image.layout.glFormat(), GL_UNSIGNED_BYTE, image.pixels.data());
+//
+//   直接写 PBO：
+//   ImageLayout layout;
+//   imageDecoder.readLayout(data, size, options, layout);
+//   glBufferData(GL_PIXEL_UNPACK_BUFFER, layout.size(), NULL, GL_STREAM_DRAW);
+//   void *target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, layout.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+//   imageDecoder.decodeInto(data, size, options, layout, (uint8_t *)target);
+
+// 每次解码的选项
+struct ImageDecodeOptions
+{
+    int channels = 0;             // 0 保持文件本身的通道数，否则 1~4
+    bool flipVertically = false;  // 第一行是图片的最后一行，和 OpenGL 纹理坐标一致
+    bool srgb = false;            // 颜色按 sRGB 存储，只影响 glInternalFormat
+    int rowAlignment = 1;         // 每行字节数按这个对齐，和 GL_UNPACK_ALIGNMENT 一致(1、2、4、8)
+};
+
+// 解码结果在缓冲里的布局
+struct ImageLayout
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    size_t rowBytes = 0;          // 对齐之后每行的字节数
+    bool srgb = false;
+
+    size_t size() const { return rowBytes * height; }
+    // 对应的 GL 格式，按数值给出，这个头文件不依赖 glad
+    // 没有解码成功(通道数不在 1~4)时返回 0，上传会报 GL_INVALID_ENUM 而不是越界读
+    unsigned int glFormat() const
+    {
+        if (channels < 1 || channels > 4)
+            return 0;
+        static const unsigned int formats[] = { 0x1903 /* GL_RED */, 0x8227 /* GL_RG */, 0x1907 /* GL_RGB */, 0x1908 /* GL_RGBA */ };
+        return formats[channels - 1];
+    }
+    unsigned int glInternalFormat() const
+    {
+        if (channels < 1 || channels > 4)
+            return 0;
+        if (srgb && channels == 3)
+            return 0x8C41;        // GL_SRGB8
+        if (srgb && channels == 4)
+            return 0x8C43;        // GL_SRGB8_ALPHA8
+        static const unsigned int formats[] = { 0x8229 /* GL_R8 */, 0x822B /* GL_RG8 */, 0x8051 /* GL_RGB8 */, 0x8058 /* GL_RGBA8 */ };
+        return formats[channels - 1];
+    }
+};
+
+inline ImageLayout makeImageLayout(int width, int height, int fileChannels, const ImageDecodeOptions &options)
+{
+    ImageLayout layout;
+    layout.width = width;
+    layout.height = height;
+    layout.channels = options.channels ? options.channels : fileChannels;
+    size_t alignment = std::max(1, options.rowAlignment);
+    layout.rowBytes = ((size_t)width * layout.channels + alignment - 1) / alignment * alignment;
+    layout.srgb = options.srgb;
+    return layout;
+}
+
+struct DecodedImage
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    ImageLayout layout;
+    std::vector<uint8_t> pixels;  // 行的顺序和间距见 layout
+    const char *backend = "";
+};
+
+// ---- 临时缓冲的分配 ----
+
+class ImageAllocator
+{
+public:
+    virtual ~ImageAllocator() {}
+    virtual uint8_t *allocate(size_t size) = 0;
+    virtual void deallocate(uint8_t *data, size_t size) = 0;
+};
+
+class ImageHeapAllocator : public ImageAllocator
+{
+public:
+    uint8_t *allocate(size_t size) override { return (uint8_t *)malloc(size); }
+    void deallocate(uint8_t *data, size_t) override { free(data); }
+};
+
+// 按 2 的幂分桶，释放的块留着给下一次解码复用；留存的总量超过上限时直接还给系统
+// 加了锁，多个解码线程可以共用
+class ImagePoolAllocator : public ImageAllocator
+{
+public:
+    explicit ImagePoolAllocator(size_t maxRetained = 64 << 20) : maxRetained(maxRetained) {}
+    ~ImagePoolAllocator() override { trim(); }
+
+    uint8_t *allocate(size_t size) override
+    {
+        int bucket = bucketOf(size);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            allocations++;
+            if (!buckets[bucket].empty())
+            {
+                uint8_t *data = buckets[bucket].back();
+                buckets[bucket].pop_back();
+                retained -= (size_t)1 << bucket;
+                reuses++;
+                return data;
+            }
+        }
+        return (uint8_t *)malloc((size_t)1 << bucket);
+    }
+
+    void deallocate(uint8_t *data, size_t size) override
+    {
+        if (!data)
+            return;
+        int bucket = bucketOf(size);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (retained + ((size_t)1 << bucket) > maxRetained)
+        {
+            free(data);
+            return;
+        }
+        buckets[bucket].push_back(data);
+        retained += (size_t)1 << bucket;
+    }
+
+    // 释放所有留存的块
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::vector<uint8_t *> &bucket : buckets)
+        {
+            for (uint8_t *data : bucket)
+                free(data);
+            bucket.clear();
+        }
+        retained = 0;
+    }
+
+    uint64_t allocationCount() const { return allocations; }
+    uint64_t reuseCount() const { return reuses; }
+
+private:
+    static int bucketOf(size_t size)
+    {
+        int bucket = 12;  // 最小 4KB
+        while (((size_t)1 << bucket) < size)
+            bucket++;
+        return bucket;
+    }
+
+    std::mutex mutex;
+    std::vector<uint8_t *> buckets[64];
+    size_t retained = 0, maxRetained;
+    uint64_t allocations = 0, reuses = 0;
+};
+
+inline ImagePoolAllocator imagePool;
+
+// 从 ImageAllocator 分配的一块缓冲，析构时归还
+class ImageBuffer
+{
+public:
+    ImageBuffer() {}
+    ImageBuffer(ImageAllocator *allocator, size_t size) : allocator(allocator), bytes(allocator->allocate(size)), length(size) {}
+    ImageBuffer(ImageBuffer &&other) noexcept { swap(other); }
+    ImageBuffer &operator=(ImageBuffer &&other) noexcept { swap(other); return *this; }
+    ImageBuffer(const ImageBuffer &) = delete;
+    ImageBuffer &operator=(const ImageBuffer &) = delete;
+    ~ImageBuffer()
+    {
+        if (bytes)
+            allocator->deallocate(bytes, length);
+    }
+
+    uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void swap(ImageBuffer &other)
+    {
+        std::swap(allocator, other.allocator);
+        std::swap(bytes, other.bytes);
+        std::swap(length, other.length);
+    }
+
+    ImageAllocator *allocator = NULL;
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+};
+
+// ---- 行的通道转换和翻转 ----
+
+// RGB -> RGBA，alpha 补 255
+inline void expandRgbToRgba(const uint8_t *rgb, uint8_t *rgba, int count)
+{
+    int i = 0;
+#if IMAGE_SSSE3
+    // 一次 16 个像素：48 字节进，64 字节出，每 4 个像素用一次 pshufb
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; i + 16 <= count; i += 16)
+    {
+        const uint8_t *in = rgb + i * 3;
+        __m128i a = _mm_loadu_si128((const __m128i *)in);
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(in + 32));
+        __m128i *out = (__m128i *)(rgba + i * 4);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(a, spread), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), spread), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), spread), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), spread), alpha));
+    }
+#elif SIMD_NEON
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t in = vld3q_u8(rgb + i * 3);
+        uint8x16x4_t out = { { in.val[0], in.val[1], in.val[2], vdupq_n_u8(255) } };
+        vst4q_u8(rgba + i * 4, out);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+// 一行像素的通道数转换：灰度 <-> RGB，补/去 alpha
+inline void convertRowChannels(const uint8_t *src, int from, uint8_t *dst, int to, int count)
+{
+    if (from == to)
+    {
+        memcpy(dst, src, (size_t)count * from);
+        return;
+    }
+    if (from == 3 && to == 4)
+    {
+        expandRgbToRgba(src, dst, count);
+        return;
+    }
+    for (int i = 0; i < count; i++, src += from, dst += to)
+    {
+        uint8_t gray = from >= 3 ? (uint8_t)((src[0] * 77 + src[1] * 150 + src[2] * 29) >> 8) : src[0];
+        uint8_t alpha = from == 2 ? src[1] : from == 4 ? src[3] : 255;
+        if (to <= 2)
+        {
+            dst[0] = gray;
+            if (to == 2)
+                dst[1] = alpha;
+        }
+        else
+        {
+            dst[0] = from >= 3 ? src[0] : gray;
+            dst[1] = from >= 3 ? src[1] : gray;
+            dst[2] = from >= 3 ? src[2] : gray;
+            if (to == 4)
+                dst[3] = alpha;
+        }
+    }
+}
+
+// 原地上下翻转
+inline void flipImageRows(uint8_t *pixels, size_t rowBytes, int height)
+{
+    for (int y = 0; y < height / 2; y++)
+        std::swap_ranges(pixels + y * rowBytes, pixels + (y + 1) * rowBytes, pixels + (height - 1 - y) * rowBytes);
+}
+
+// 把紧密排列的整张图按布局写进目标缓冲，翻转在写的时候完成
+inline void writeImageRows(const uint8_t *pixels, int channels, const ImageLayout &layout, bool flip, uint8_t *target)
+{
+    for (int y = 0; y < layout.height; y++)
+    {
+        uint8_t *row = target + (size_t)(flip ? layout.height - 1 - y : y) * layout.rowBytes;
+        convertRowChannels(pixels + (size_t)y * layout.width * channels, channels, row, layout.channels, layout.width);
+    }
+}
+
+// ---- 后端 ----
+
+class ImageDecoderBackend
+{
+public:
+    virtual ~ImageDecoderBackend() {}
+    virtual const char *name() const = 0;
+    virtual bool canDecode(const uint8_t *data, size_t size) const = 0;
+    // 只读文件头，得到大小和文件本身的通道数
+    virtual bool readInfo(const uint8_t *data, size_t size, int &width, int &height, int &channels) = 0;
+    // 按 layout 写进 target，target 至少有 layout.size() 字节
+    virtual bool decodeInto(const uint8_t *data, size_t size, const ImageDecodeOptions &options, const ImageLayout &layout, uint8_t *target) = 0;
+
+    bool decode(const uint8_t *data, size_t size, const ImageDecodeOptions &options, DecodedImage &image)
+    {
+        int width, height, channels;
+        if (!readInfo(data, size, width, height, channels))
+            return false;
+        ImageLayout layout = makeImageLayout(width, height, channels, options);
+        image.pixels.resize(layout.size());
+        if (!decodeInto(data, size, options, layout, image.pixels.data()))
+            return false;
+        image.width = width;
+        image.height = height;
+        image.channels = layout.channels;
+        image.layout = layout;
+        image.backend = name();
+        return true;
+    }
+    // desiredChannels 为 0 时保持文件本身的通道数，和 stbi_load 一致
+    bool decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image)
+    {
+        ImageDecodeOptions options;
+        options.channels = desiredChannels;
+        return decode(data, size, options, image);
+    }
+
+    ImageAllocator *allocator = &imagePool;
+};
+
+class StbImageBackend : public ImageDecoderBackend
+{
+public:
+    const char *name() const override { return "stb_image"; }
+    bool canDecode(const uint8_t *, size_t size) const override { return size > 0; }
+
+    bool readInfo(const uint8_t *data, size_t size, int &width, int &height, int &channels) override
+    {
+        return stbi_info_from_memory(data, (int)size, &width, &height, &channels) != 0;
+    }
+
+    // stb_image 自己分配整张图，这里只能再拷一次；翻转用选项完成，不碰 stb 的全局开关
+    bool decodeInto(const uint8_t *data, size_t size, const ImageDecodeOptions &options, const ImageLayout &layout, uint8_t *target) override
+    {
+        int width, height, channels;
+        unsigned char *pixels = stbi_load_from_memory(data, (int)size, &width, &height, &channels, layout.channels);
+        if (!pixels)
+            return false;
+        bool ok = width == layout.width && height == layout.height;
+        if (ok)
+            writeImageRows(pixels, layout.channels, layout, options.flipVertically, target);
+        stbi_image_free(pixels);
+        return ok;
+    }
+};
+
+// ---- JPEG 的 SIMD 部分 ----
+
+// 8 个 float，IDCT 里的一行
+#if JPEG_AVX2
+struct JpegRow { __m256 v; };
+inline JpegRow jpegAdd(JpegRow a, JpegRow b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline JpegRow jpegSub(JpegRow a, JpegRow b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline JpegRow jpegScale(JpegRow a, float s) { return { _mm256_mul_ps(a.v, _mm256_set1_ps(s)) }; }
+inline JpegRow jpegLoad(const float *p) { return { _mm256_loadu_ps(p) }; }
+inline void jpegStore(float *p, JpegRow a) { _mm256_storeu_ps(p, a.v); }
+#else
+struct JpegRow { f32x4 lo, hi; };
+inline JpegRow jpegAdd(JpegRow a, JpegRow b) { return { simd_add(a.lo, b.lo), simd_add(a.hi, b.hi) }; }
+inline JpegRow jpegSub(JpegRow a, JpegRow b) { return { simd_sub(a.lo, b.lo), simd_sub(a.hi, b.hi) }; }
+inline JpegRow jpegScale(JpegRow a, float s) { return { simd_mul(a.lo, simd_set1(s)), simd_mul(a.hi, simd_set1(s)) }; }
+inline JpegRow jpegLoad(const float *p) { return { simd_load(p), simd_load(p + 4) }; }
+inline void jpegStore(float *p, JpegRow a) { simd_store(p, a.lo); simd_store(p + 4, a.hi); }
+#endif
+
+// 一维 AAN IDCT(libjpeg jidctflt.c)，8 行同时做，相当于对 8 列各做一次
+inline void jpegIdctPass(JpegRow r[8])
+{
+    // 偶数部分
+    JpegRow tmp10 = jpegAdd(r[0], r[4]);
+    JpegRow tmp11 = jpegSub(r[0], r[4]);
+    JpegRow tmp13 = jpegAdd(r[2], r[6]);
+    JpegRow tmp12 = jpegSub(jpegScale(jpegSub(r[2], r[6]), 1.414213562f), tmp13);
+    JpegRow tmp0 = jpegAdd(tmp10, tmp13);
+    JpegRow tmp3 = jpegSub(tmp10, tmp13);
+    JpegRow tmp1 = jpegAdd(tmp11, tmp12);
+    JpegRow tmp2 = jpegSub(tmp11, tmp12);
+    // 奇数部分
+    JpegRow z13 = jpegAdd(r[5], r[3]);
+    JpegRow z10 = jpegSub(r[5], r[3]);
+    JpegRow z11 = jpegAdd(r[1], r[7]);
+    JpegRow z12 = jpegSub(r[1], r[7]);
+    JpegRow tmp7 = jpegAdd(z11, z13);
+    JpegRow odd11 = jpegScale(jpegSub(z11, z13), 1.414213562f);
+    JpegRow z5 = jpegScale(jpegAdd(z10, z12), 1.847759065f);
+    JpegRow odd10 = jpegSub(jpegScale(z12, 1.082392200f), z5);
+    JpegRow odd12 = jpegAdd(jpegScale(z10, -2.613125930f), z5);
+    JpegRow tmp6 = jpegSub(odd12, tmp7);
+    JpegRow tmp5 = jpegSub(odd11, tmp6);
+    JpegRow tmp4 = jpegAdd(odd10, tmp5);
+    r[0] = jpegAdd(tmp0, tmp7);
+    r[7] = jpegSub(tmp0, tmp7);
+    r[1] = jpegAdd(tmp1, tmp6);
+    r[6] = jpegSub(tmp1, tmp6);
+    r[2] = jpegAdd(tmp2, tmp5);
+    r[5] = jpegSub(tmp2, tmp5);
+    r[4] = jpegAdd(tmp3, tmp4);
+    r[3] = jpegSub(tmp3, tmp4);
+}
+
+inline void jpegTranspose(JpegRow r[8])
+{
+#if JPEG_AVX2
+    __m256 t0 = _mm256_unpacklo_ps(r[0].v, r[1].v), t1 = _mm256_unpackhi_ps(r[0].v, r[1].v);
+    __m256 t2 = _mm256_unpacklo_ps(r[2].v, r[3].v), t3 = _mm256_unpackhi_ps(r[2].v, r[3].v);
+    __m256 t4 = _mm256_unpacklo_ps(r[4].v, r[5].v), t5 = _mm256_unpackhi_ps(r[4].v, r[5].v);
+    __m256 t6 = _mm256_unpacklo_ps(r[6].v, r[7].v), t7 = _mm256_unpackhi_ps(r[6].v, r[7].v);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44), s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44), s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44), s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44), s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+    r[0].v = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1].v = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2].v = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3].v = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4].v = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5].v = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6].v = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7].v = _mm256_permute2f128_ps(s3, s7, 0x31);
+#elif SIMD_SSE2
+    // 四个 4x4 块各自转置，再交换右上和左下
+    for (int i = 0; i < 8; i += 4)
+    {
+        _MM_TRANSPOSE4_PS(r[i].lo.v, r[i + 1].lo.v, r[i + 2].lo.v, r[i + 3].lo.v);
+        _MM_TRANSPOSE4_PS(r[i].hi.v, r[i + 1].hi.v, r[i + 2].hi.v, r[i + 3].hi.v);
+    }
+    for (int i = 0; i < 4; i++)
+        std::swap(r[i].hi, r[i + 4].lo);
+#else
+    float block[64];
+    for (int i = 0; i < 8; i++)
+        jpegStore(block + i * 8, r[i]);
+    for (int i = 0; i < 8; i++)
+    {
+        float column[8];
+        for (int j = 0; j < 8; j++)
+            column[j] = block[j * 8 + i];
+        r[i] = jpegLoad(column);
+    }
+#endif
+}
+
+// 8 个 float 四舍五入、截断到 0~255，写成 8 个字节
+inline void jpegStoreBytes(uint8_t *out, JpegRow a)
+{
+#if JPEG_AVX2
+    __m256i integers = _mm256_cvtps_epi32(a.v);
+    __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+    _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(words, words));
+#elif SIMD_SSE2
+    __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(a.lo.v), _mm_cvtps_epi32(a.hi.v));
+    _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(words, words));
+#else
+    float values[8];
+    jpegStore(values, a);
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)std::min(std::max(std::nearbyint(values[i]), 0.0f), 255.0f);
+#endif
+}
+
+// 8 个字节转成 8 个 float
+inline JpegRow jpegLoadBytes(const uint8_t *in)
+{
+#if JPEG_AVX2
+    return { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)in))) };
+#elif SIMD_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)in), zero);
+    JpegRow row;
+    row.lo.v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+    row.hi.v = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+    return row;
+#else
+    float values[8];
+    for (int i = 0; i < 8; i++)
+        values[i] = in[i];
+    return jpegLoad(values);
+#endif
+}
+
+// YCbCr -> RGB，一次 8 个像素，写成交错的 RGB
+inline void jpegYCbCrToRgb8(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb)
+{
+    static const float center[8] = { 128, 128, 128, 128, 128, 128, 128, 128 };
+    JpegRow Y = jpegLoadBytes(y);
+    JpegRow Cb = jpegSub(jpegLoadBytes(cb), jpegLoad(center));
+    JpegRow Cr = jpegSub(jpegLoadBytes(cr), jpegLoad(center));
+    uint8_t r[8], g[8], b[8];
+    jpegStoreBytes(r, jpegAdd(Y, jpegScale(Cr, 1.402f)));
+    jpegStoreBytes(g, jpegSub(Y, jpegAdd(jpegScale(Cb, 0.344136f), jpegScale(Cr, 0.714136f))));
+    jpegStoreBytes(b, jpegAdd(Y, jpegScale(Cb, 1.772f)));
+    for (int i = 0; i < 8; i++)
+    {
+        rgb[i * 3] = r[i];
+        rgb[i * 3 + 1] = g[i];
+        rgb[i * 3 + 2] = b[i];
+    }
+}
+
+inline void jpegYCbCrToRgb(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb, int count)
+{
+    int i = 0;
+#if SIMD_SSE2
+    // x86 上一次 16 个像素，16 位定点：色度放在高字节，乘 12 位的系数取高 16 位，结果带 4 位小数
+    const __m128i bias = _mm_set1_epi8((char)128), zero = _mm_setzero_si128(), round = _mm_set1_epi16(8);
+    const __m128i crToR = _mm_set1_epi16((short)(1.40200f * 4096.0f + 0.5f));
+    const __m128i cbToG = _mm_set1_epi16(-(short)(0.34414f * 4096.0f + 0.5f));
+    const __m128i crToG = _mm_set1_epi16(-(short)(0.71414f * 4096.0f + 0.5f));
+    const __m128i cbToB = _mm_set1_epi16((short)(1.77200f * 4096.0f + 0.5f));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(y + i));
+        __m128i cb8 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(cb + i)), bias);
+        __m128i cr8 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(cr + i)), bias);
+        __m128i channels[2][3];
+        for (int half = 0; half < 2; half++)
+        {
+            __m128i yw = half ? _mm_unpackhi_epi8(y8, zero) : _mm_unpacklo_epi8(y8, zero);
+            __m128i cbw = half ? _mm_unpackhi_epi8(zero, cb8) : _mm_unpacklo_epi8(zero, cb8);
+            __m128i crw = half ? _mm_unpackhi_epi8(zero, cr8) : _mm_unpacklo_epi8(zero, cr8);
+            __m128i base = _mm_add_epi16(_mm_slli_epi16(yw, 4), round);
+            channels[half][0] = _mm_srai_epi16(_mm_add_epi16(base, _mm_mulhi_epi16(crw, crToR)), 4);
+            channels[half][1] = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(base, _mm_mulhi_epi16(cbw, cbToG)), _mm_mulhi_epi16(crw, crToG)), 4);
+            channels[half][2] = _mm_srai_epi16(_mm_add_epi16(base, _mm_mulhi_epi16(cbw, cbToB)), 4);
+        }
+        __m128i r = _mm_packus_epi16(channels[0][0], channels[1][0]);
+        __m128i g = _mm_packus_epi16(channels[0][1], channels[1][1]);
+        __m128i b = _mm_packus_epi16(channels[0][2], channels[1][2]);
+        uint8_t *o = rgb + i * 3;
+#if IMAGE_SSSE3
+        // 三个平面交错成 48 字节，每个输出寄存器从三个平面各取一部分
+        static const int8_t lanes[3][3][16] = {
+            { { 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5 },
+              { -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1 },
+              { -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1 } },
+            { { -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1 },
+              { 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10 },
+              { -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1 } },
+            { { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+              { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+              { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } } };
+        for (int k = 0; k < 3; k++)
+        {
+            __m128i part = _mm_or_si128(_mm_shuffle_epi8(r, _mm_loadu_si128((const __m128i *)lanes[k][0])),
+                           _mm_or_si128(_mm_shuffle_epi8(g, _mm_loadu_si128((const __m128i *)lanes[k][1])),
+                                        _mm_shuffle_epi8(b, _mm_loadu_si128((const __m128i *)lanes[k][2]))));
+            _mm_storeu_si128((__m128i *)(o + k * 16), part);
+        }
+#else
+        alignas(16) uint8_t planes[3][16];
+        _mm_store_si128((__m128i *)planes[0], r);
+        _mm_store_si128((__m128i *)planes[1], g);
+        _mm_store_si128((__m128i *)planes[2], b);
+        for (int k = 0; k < 16; k++)
+        {
+            o[k * 3] = planes[0][k];
+            o[k * 3 + 1] = planes[1][k];
+            o[k * 3 + 2] = planes[2][k];
+        }
+#endif
+    }
+#endif
+    for (; i + 8 <= count; i += 8)
+        jpegYCbCrToRgb8(y + i, cb + i, cr + i, rgb + i * 3);
+    if (i < count)
+    {
+        // 不足 8 个的尾巴先拷到临时缓冲
+        uint8_t ty[8] = {}, tcb[8] = {}, tcr[8] = {}, trgb[24];
+        memcpy(ty, y + i, count - i);
+        memcpy(tcb, cb + i, count - i);
+        memcpy(tcr, cr + i, count - i);
+        jpegYCbCrToRgb8(ty, tcb, tcr, trgb);
+        memcpy(rgb + i * 3, trgb, (count - i) * 3);
+    }
+}
+
+// 水平 2 倍的 fancy 上采样：out[2x] = (3s[x] + s[x-1] + bias0) >> shift，out[2x+1] 用 s[x+1] 和 bias1
+// s[-1] 和 s[w] 必须可读；SSE2 一次 8 个输入，输出最多多写 14 个字节
+inline void jpegUpsampleH2(const uint16_t *s, int w, uint8_t *out, int bias0, int bias1, int shift)
+{
+    int x = 0;
+#if SIMD_SSE2
+    __m128i b0 = _mm_set1_epi16((short)bias0), b1 = _mm_set1_epi16((short)bias1);
+    __m128i count = _mm_cvtsi32_si128(shift);
+    for (; x < w; x += 8)
+    {
+        __m128i current = _mm_loadu_si128((const __m128i *)(s + x));
+        __m128i three = _mm_add_epi16(_mm_add_epi16(current, current), current);
+        __m128i even = _mm_srl_epi16(_mm_add_epi16(_mm_add_epi16(three, _mm_loadu_si128((const __m128i *)(s + x - 1))), b0), count);
+        __m128i odd = _mm_srl_epi16(_mm_add_epi16(_mm_add_epi16(three, _mm_loadu_si128((const __m128i *)(s + x + 1))), b1), count);
+        __m128i bytes = _mm_packus_epi16(_mm_unpacklo_epi16(even, odd), _mm_unpackhi_epi16(even, odd));
+        _mm_storeu_si128((__m128i *)(out + x * 2), bytes);
+    }
+#endif
+    for (; x < w; x++)
+    {
+        out[x * 2] = (uint8_t)((s[x] * 3 + s[x - 1] + bias0) >> shift);
+        out[x * 2 + 1] = (uint8_t)((s[x] * 3 + s[x + 1] + bias1) >> shift);
+    }
+}
+
+// ---- JPEG 解码 ----
+
+class JpegSimdBackend : public ImageDecoderBackend
+{
+public:
+    int maxThreads = 0; // 0 表示按 CPU 核数
+
+    const char *name() const override { return "jpeg-simd"; }
+
+    bool canDecode(const uint8_t *data, size_t size) const override
+    {
+        return size > 4 && data[0] == 0xFF && data[1] == 0xD8;
+    }
+
+    // 解析到 SOS 为止，不支持的文件在这里就会失败，imageDecoder 会改用后备
+    bool readInfo(const uint8_t *data, size_t size, int &width, int &height, int &channels) override
+    {
+        Frame frame;
+        if (!parse(data, size, frame, true))
+            return false;
+        width = frame.width;
+        height = frame.height;
+        channels = (int)frame.components.size();
+        return true;
+    }
+
+    bool decodeInto(const uint8_t *data, size_t size, const ImageDecodeOptions &options, const ImageLayout &layout, uint8_t *target) override
+    {
+        Frame frame;
+        if (!parse(data, size, frame, false) || frame.width != layout.width || frame.height != layout.height)
+            return false;
+        for (Component &component : frame.components)
+            component.plane = ImageBuffer(allocator, (size_t)component.stride * component.rows);
+        if (!decodeScan(frame))
+            return false;
+        convertColor(frame, options, layout, target);
+        return true;
+    }
+
+private:
+    struct Huffman
+    {
+        uint8_t fastSymbol[512];
+        uint8_t fastLength[512];  // 0 表示码长超过 9 位
+        int maxCode[18];
+        int valueOffset[17];
+        uint8_t symbols[256];
+        // 交流表用：码字和后面的幅值一共不超过 9 位时一次查出来，值 << 8 | run << 4 | 总位数，0 表示走慢路径
+        int fastAc[512];
+    };
+
+    struct Component
+    {
+        int id, h, v, quant;
+        int dcTable = 0, acTable = 0;
+        int width, height;         // 实际的采样大小
+        int stride, rows;          // 平面按 MCU 补齐后的大小
+        ImageBuffer plane;
+    };
+
+    struct Segment
+    {
+        const uint8_t *begin, *end;
+        int firstMcu, mcuCount;
+    };
+
+    struct Frame
+    {
+        int width = 0, height = 0;
+        int hmax = 1, vmax = 1;
+        int mcusX = 0, mcusY = 0;
+        int restartInterval = 0;
+        float quant[4][64];        // 反量化乘数，自然顺序，已经乘上 AAN 缩放系数和 1/8
+        bool quantDefined[4] = {};
+        Huffman dc[4], ac[4];
+        bool huffDefined[2][4] = {}; // [0] 直流 [1] 交流，DHT 定义过的表
+        std::vector<Component> components;
+        std::vector<Segment> segments;
+    };
+
+    struct BitReader
+    {
+        const uint8_t *p, *end;
+        uint64_t buffer = 0;
+        int bits = 0;
+        bool error = false;
+
+        // 缓冲区按最高位对齐；遇到标记后补 0
+        void fill()
+        {
+            while (bits <= 56)
+            {
+                uint64_t byte = 0;
+                if (p < end)
+                {
+                    byte = *p++;
+                    if (byte == 0xFF)
+                    {
+                        if (p < end && *p == 0x00)
+                            p++;
+                        else
+                        {
+                            p = end;
+                            byte = 0;
+                        }
+                    }
+                }
+                buffer |= byte << (56 - bits);
+                bits += 8;
+            }
+        }
+        uint32_t peek(int n) const { return (uint32_t)(buffer >> (64 - n)); }
+        void consume(int n)
+        {
+            buffer <<= n;
+            bits -= n;
+        }
+
+        int decode(const Huffman &table)
+        {
+            if (bits < 16)
+                fill();
+            uint32_t look = peek(9);
+            if (table.fastLength[look])
+            {
+                consume(table.fastLength[look]);
+                return table.fastSymbol[look];
+            }
+            for (int length = 10; length <= 16; length++)
+            {
+                int code = (int)peek(length);
+                if (code <= table.maxCode[length])
+                {
+                    consume(length);
+                    return table.symbols[table.valueOffset[length] + code];
+                }
+            }
+            error = true;
+            return 0;
+        }
+
+        int receiveExtend(int size)
+        {
+            if (size == 0)
+                return 0;
+            if (bits < size)
+                fill();
+            int value = (int)peek(size);
+            consume(size);
+            return value < (1 << (size - 1)) ? value - (1 << size) + 1 : value;
+        }
+    };
+
+    static const uint8_t *zigzag()
+    {
+        static const uint8_t order[64] = {
+            0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+            12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+            35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+            58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+        return order;
+    }
+
+    static bool buildHuffman(Huffman &table, const uint8_t counts[16], const uint8_t *symbols, int total)
+    {
+        memcpy(table.symbols, symbols, total);
+        memset(table.fastLength, 0, sizeof(table.fastLength));
+        int code = 0, k = 0;
+        for (int length = 1; length <= 16; length++)
+        {
+            int count = counts[length - 1];
+            // valueOffset + code 直接得到符号下标
+            table.valueOffset[length] = k - code;
+            for (int i = 0; i < count; i++, k++, code++)
+            {
+                if (length <= 9)
+                {
+                    int first = code << (9 - length);
+                    for (int j = 0; j < (1 << (9 - length)); j++)
+                    {
+                        table.fastSymbol[first + j] = symbols[k];
+                        table.fastLength[first + j] = (uint8_t)length;
+                    }
+                }
+            }
+            table.maxCode[length] = count ? code - 1 : -1;
+            if (code > (1 << length))
+                return false;
+            code <<= 1;
+        }
+        table.maxCode[17] = INT32_MAX;
+        for (int i = 0; i < 512; i++)
+        {
+            table.fastAc[i] = 0;
+            int length = table.fastLength[i];
+            int run = table.fastSymbol[i] >> 4, size = table.fastSymbol[i] & 15;
+            if (length == 0 || size == 0 || length + size > 9)
+                continue;
+            int bits = (i << length & 511) >> (9 - size);
+            int value = bits < (1 << (size - 1)) ? bits - (1 << size) + 1 : bits;
+            table.fastAc[i] = value * 256 + run * 16 + length + size;
+        }
+        return true;
+    }
+
+    static uint16_t read16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+    // 解析到第一个 SOS 为止，切好熵编码段；headerOnly 时只检查文件头
+    bool parse(const uint8_t *data, size_t size, Frame &frame, bool headerOnly)
+    {
+        static const float aan[8] = { 1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+                                      1.0f, 0.785694958f, 0.541196100f, 0.275899379f };
+        const uint8_t *p = data + 2, *end = data + size;
+        bool haveFrame = false;
+        while (p + 4 <= end)
+        {
+            if (p[0] != 0xFF)
+                return false;
+            uint8_t marker = p[1];
+            if (marker == 0xFF)
+            {
+                p++;
+                continue;
+            }
+            uint16_t length = read16(p + 2);
+            const uint8_t *segment = p + 4, *next = p + 2 + length;
+            if (length < 2 || next > end)
+                return false;
+            switch (marker)
+            {
+                case 0xDB: // DQT
+                    for (const uint8_t *q = segment; q < next;)
+                    {
+                        int precision = q[0] >> 4, id = q[0] & 3;
+                        if (q + 1 + 64 * (precision + 1) > next)
+                            return false;
+                        for (int i = 0; i < 64; i++)
+                        {
+                            int value = precision ? read16(q + 1 + i * 2) : q[1 + i];
+                            int natural = zigzag()[i];
+                            frame.quant[id][natural] = value * aan[natural / 8] * aan[natural % 8] * 0.125f;
+                        }
+                        frame.quantDefined[id] = true;
+                        q += 1 + 64 * (precision + 1);
+                    }
+                    break;
+                case 0xC4: // DHT
+                    for (const uint8_t *q = segment; q + 17 <= next;)
+                    {
+                        int type = q[0] >> 4, id = q[0] & 3, total = 0;
+                        for (int i = 0; i < 16; i++)
+                            total += q[1 + i];
+                        if (type > 1 || total > 256 || q + 17 + total > next)
+                            return false;
+                        if (!buildHuffman(type ? frame.ac[id] : frame.dc[id], q + 1, q + 17, total))
+                            return false;
+                        frame.huffDefined[type][id] = true;
+                        q += 17 + total;
+                    }
+                    break;
+                case 0xDD: // DRI
+                    if (length < 4)
+                        return false;
+                    frame.restartInterval = read16(segment);
+                    break;
+                case 0xC0: // SOF0 基线
+                case 0xC1: // SOF1 扩展顺序，哈夫曼
+                {
+                    // 精度 1 + 高宽 4 + 分量数 1
+                    if (length < 2 + 6 || segment[0] != 8)
+                        return false;
+                    frame.height = read16(segment + 1);
+                    frame.width = read16(segment + 3);
+                    int count = segment[5];
+                    if (frame.width == 0 || frame.height == 0 || (count != 1 && count != 3) || 6 + count * 3 > length - 2)
+                        return false;
+                    for (int i = 0; i < count; i++)
+                    {
+                        const uint8_t *c = segment + 6 + i * 3;
+                        Component component = {};
+                        component.id = c[0];
+                        component.h = count == 1 ? 1 : c[1] >> 4;
+                        component.v = count == 1 ? 1 : c[1] & 15;
+                        component.quant = c[2] & 3;
+                        if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4)
+                            return false;
+                        frame.hmax = std::max(frame.hmax, component.h);
+                        frame.vmax = std::max(frame.vmax, component.v);
+                        frame.components.push_back(std::move(component));
+                    }
+                    haveFrame = true;
+                    break;
+                }
+                case 0xDA: // SOS
+                {
+                    if (length < 3)
+                        return false;
+                    int count = segment[0];
+                    // 只支持一次扫描包含所有分量，其它情况交给后备
+                    // 段长：长度 2 + 分量数 1 + 每个分量 2 + 谱选择和逐次逼近 3
+                    if (!haveFrame || count != (int)frame.components.size() || length < 2 + 1 + count * 2 + 3)
+                        return false;
+                    for (int i = 0; i < count; i++)
+                    {
+                        Component &component = frame.components[i];
+                        if (segment[1 + i * 2] != component.id || !frame.quantDefined[component.quant])
+                            return false;
+                        component.dcTable = segment[2 + i * 2] >> 4 & 3;
+                        component.acTable = segment[2 + i * 2] & 3;
+                        // 引用了没定义的表是损坏的文件，表里是未初始化的数据，不能拿来解码
+                        if (!frame.huffDefined[0][component.dcTable] || !frame.huffDefined[1][component.acTable])
+                            return false;
+                    }
+                    return headerOnly || splitSegments(frame, next, end);
+                }
+                case 0xD8:
+                case 0xD9:
+                    return false;
+                default:
+                    // 渐进式、算术编码、12 位等都不支持
+                    if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+                        return false;
+                    break;
+            }
+            p = next;
+        }
+        return false;
+    }
+
+    // 按 RST 标记切分熵编码数据，每段的 MCU 范围由重启间隔决定
+    static bool splitSegments(Frame &frame, const uint8_t *p, const uint8_t *end)
+    {
+        for (Component &component : frame.components)
+        {
+            component.width = (frame.width * component.h + frame.hmax - 1) / frame.hmax;
+            component.height = (frame.height * component.v + frame.vmax - 1) / frame.vmax;
+        }
+        frame.mcusX = (frame.width + frame.hmax * 8 - 1) / (frame.hmax * 8);
+        frame.mcusY = (frame.height + frame.vmax * 8 - 1) / (frame.vmax * 8);
+        for (Component &component : frame.components)
+        {
+            component.stride = frame.mcusX * component.h * 8;
+            component.rows = frame.mcusY * component.v * 8;
+        }
+
+        int totalMcus = frame.mcusX * frame.mcusY;
+        int interval = frame.restartInterval ? frame.restartInterval : totalMcus;
+        const uint8_t *begin = p;
+        int firstMcu = 0;
+        while (p < end)
+        {
+            const uint8_t *marker = (const uint8_t *)memchr(p, 0xFF, end - p);
+            if (!marker || marker + 1 >= end)
+                break;
+            uint8_t code = marker[1];
+            if (code == 0x00 || code == 0xFF)
+            {
+                p = marker + (code == 0x00 ? 2 : 1);
+                continue;
+            }
+            // 最后一个 MCU 之后多出来的 RST 不产生新段
+            if (firstMcu < totalMcus)
+                frame.segments.push_back({ begin, marker, firstMcu, std::min(interval, totalMcus - firstMcu) });
+            firstMcu += interval;
+            if (code < 0xD0 || code > 0xD7)
+            {
+                // 一次扫描之后应该直接结束，多次扫描的文件交给后备
+                return code == 0xD9 && firstMcu >= totalMcus;
+            }
+            begin = p = marker + 2;
+        }
+        // 没有 EOI 的截断文件
+        return false;
+    }
+
+    // 把每段分给若干线程
+    bool decodeScan(Frame &frame)
+    {
+        int threads = maxThreads > 0 ? maxThreads : (int)std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, (int)frame.segments.size());
+        std::vector<char> ok(threads, 1);
+        auto work = [&](int index) {
+            for (size_t s = index; s < frame.segments.size(); s += threads)
+                ok[index] &= decodeSegment(frame, frame.segments[s]);
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work, i);
+        work(0);
+        for (std::thread &worker : workers)
+            worker.join();
+        return std::all_of(ok.begin(), ok.end(), [](char value) { return value != 0; });
+    }
+
+    // 不同的段写平面里不重叠的 MCU，线程之间不需要同步
+    static bool decodeSegment(Frame &frame, const Segment &segment)
+    {
+        BitReader reader;
+        reader.p = segment.begin;
+        reader.end = segment.end;
+        int predictors[3] = {};
+        alignas(32) short coefficients[64];
+        for (int mcu = segment.firstMcu; mcu < segment.firstMcu + segment.mcuCount; mcu++)
+        {
+            int mcuX = mcu % frame.mcusX, mcuY = mcu / frame.mcusX;
+            for (size_t c = 0; c < frame.components.size(); c++)
+            {
+                Component &component = frame.components[c];
+                for (int by = 0; by < component.v; by++)
+                {
+                    for (int bx = 0; bx < component.h; bx++)
+                    {
+                        bool dcOnly;
+                        if (!decodeBlock(reader, frame.dc[component.dcTable], frame.ac[component.acTable], predictors[c], coefficients, dcOnly))
+                            return false;
+                        int x = (mcuX * component.h + bx) * 8, y = (mcuY * component.v + by) * 8;
+                        uint8_t *out = component.plane.data() + (size_t)y * component.stride + x;
+                        idctBlock(coefficients, dcOnly, frame.quant[component.quant], out, component.stride);
+                    }
+                }
+            }
+        }
+        return !reader.error;
+    }
+
+    // dcOnly 返回这个块是不是只有直流系数
+    static bool decodeBlock(BitReader &reader, const Huffman &dc, const Huffman &ac, int &predictor, short coefficients[64], bool &dcOnly)
+    {
+        dcOnly = true;
+        memset(coefficients, 0, 64 * sizeof(short));
+        int t = reader.decode(dc);
+        if (t > 11)
+            return false;
+        predictor += reader.receiveExtend(t);
+        coefficients[0] = (short)predictor;
+        for (int k = 1; k < 64;)
+        {
+            if (reader.bits < 16)
+                reader.fill();
+            if (int fast = ac.fastAc[reader.peek(9)])
+            {
+                k += (fast >> 4) & 15;
+                if (k > 63)
+                    return false;
+                reader.consume(fast & 15);
+                coefficients[zigzag()[k++]] = (short)(fast >> 8);
+                dcOnly = false;
+                continue;
+            }
+            int rs = reader.decode(ac);
+            int run = rs >> 4, size = rs & 15;
+            if (size == 0)
+            {
+                if (run != 15)
+                    break; // EOB
+                k += 16;
+                continue;
+            }
+            k += run;
+            if (k > 63)
+                return false;
+            coefficients[zigzag()[k]] = (short)reader.receiveExtend(size);
+            dcOnly = false;
+            k++;
+        }
+        return !reader.error;
+    }
+
+    static void idctBlock(const short coefficients[64], bool dcOnly, const float quant[64], uint8_t *out, int stride)
+    {
+        // 只有直流系数时整块是同一个值
+        if (dcOnly)
+        {
+            float value = std::nearbyint(coefficients[0] * quant[0] + 128.0f);
+            uint8_t fill = (uint8_t)std::min(std::max(value, 0.0f), 255.0f);
+            for (int y = 0; y < 8; y++)
+                memset(out + (size_t)y * stride, fill, 8);
+            return;
+        }
+        alignas(32) float block[64];
+        for (int i = 0; i < 64; i++)
+            block[i] = coefficients[i] * quant[i];
+        // 直流分量加上 128，所有输出像素都会加上
+        block[0] += 128.0f;
+        JpegRow rows[8];
+        for (int i = 0; i < 8; i++)
+            rows[i] = jpegLoad(block + i * 8);
+        jpegIdctPass(rows);   // 列
+        jpegTranspose(rows);
+        jpegIdctPass(rows);   // 行
+        jpegTranspose(rows);
+        for (int i = 0; i < 8; i++)
+            jpegStoreBytes(out + (size_t)i * stride, rows[i]);
+    }
+
+    // 色度上采样一行，和 libjpeg 的 fancy upsampling 一致(h2v1、h2v2)，其它比例直接复制
+    // sums 是调用者提供的临时缓冲，至少有分量宽度 + 16 那么大
+    static void upsampleRow(const Frame &frame, const Component &component, int y, uint8_t *out, uint16_t *sums)
+    {
+        const uint8_t *plane = component.plane.data();
+        int w = component.width;
+        if (component.h == frame.hmax && component.v == frame.vmax)
+        {
+            memcpy(out, plane + (size_t)y * component.stride, frame.width);
+            return;
+        }
+        int hs = frame.hmax / component.h, vs = frame.vmax / component.v;
+        bool fancy = hs == 2 && (vs == 1 || vs == 2) && frame.hmax == component.h * 2 && frame.vmax == component.v * vs;
+        if (fancy && w > 1)
+        {
+            int row = y / vs;
+            const uint8_t *near = plane + (size_t)row * component.stride;
+            // sums[1..w] 放这一行的值，两端各复制一个，边界就不用特殊处理
+            uint16_t *s = sums + 1;
+            if (vs == 2)
+            {
+                // 先在竖直方向按 3:1 混合近的一行和远的一行
+                int farRow = (y & 1) ? std::min(row + 1, component.height - 1) : std::max(row - 1, 0);
+                const uint8_t *far = plane + (size_t)farRow * component.stride;
+                for (int x = 0; x < w; x++)
+                    s[x] = (uint16_t)(near[x] * 3 + far[x]);
+            }
+            else
+            {
+                for (int x = 0; x < w; x++)
+                    s[x] = near[x];
+            }
+            s[-1] = s[0];
+            s[w] = s[w - 1];
+            // 再在水平方向按 3:1 混合；h2v2 偏置交替取 8 和 7，h2v1 取 1 和 2
+            jpegUpsampleH2(s, w, out, vs == 2 ? 8 : 1, vs == 2 ? 7 : 2, vs == 2 ? 4 : 2);
+            return;
+        }
+        const uint8_t *row = plane + (size_t)std::min(y * component.v / frame.vmax, component.height - 1) * component.stride;
+        for (int x = 0; x < frame.width; x++)
+            out[x] = row[x * component.h / frame.hmax];
+    }
+
+    // 上采样和颜色转换，按行分给多个线程，直接写进目标缓冲的对应行
+    void convertColor(const Frame &frame, const ImageDecodeOptions &options, const ImageLayout &layout, uint8_t *target)
+    {
+        int threads = maxThreads > 0 ? maxThreads : (int)std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, frame.height / 64));
+        int channels = (int)frame.components.size();
+        auto work = [&](int index) {
+            int first = frame.height * index / threads, last = frame.height * (index + 1) / threads;
+            // 上采样的输出比宽度多一点，h2 时会写到 2 * 分量宽度
+            size_t rowSize = (size_t)frame.width + frame.hmax * 8;
+            // 三个分量各一行，输出不是 RGB 时再加一行 RGB 的中转
+            ImageBuffer rows(allocator, rowSize * 3 + (size_t)frame.width * 3), sums(allocator, (rowSize + 16) * sizeof(uint16_t));
+            uint8_t *planes = rows.data(), *rgb = rows.data() + rowSize * 3;
+            for (int y = first; y < last; y++)
+            {
+                uint8_t *out = target + (size_t)(options.flipVertically ? frame.height - 1 - y : y) * layout.rowBytes;
+                if (channels == 1)
+                {
+                    convertRowChannels(frame.components[0].plane.data() + (size_t)y * frame.components[0].stride, 1, out,
+                                       layout.channels, frame.width);
+                    continue;
+                }
+                for (int c = 0; c < 3; c++)
+                    upsampleRow(frame, frame.components[c], y, planes + rowSize * c, (uint16_t *)sums.data());
+                if (layout.channels == 3)
+                {
+                    jpegYCbCrToRgb(planes, planes + rowSize, planes + rowSize * 2, out, frame.width);
+                    continue;
+                }
+                jpegYCbCrToRgb(planes, planes + rowSize, planes + rowSize * 2, rgb, frame.width);
+                convertRowChannels(rgb, 3, out, layout.channels, frame.width);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work, i);
+        work(0);
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+};
+
+// 按顺序尝试各个后端
+class ImageDecoder
+{
+public:
+    ImageDecoder()
+    {
+        backends.emplace_back(new JpegSimdBackend());
+        backends.emplace_back(new StbImageBackend());
+    }
+
+    // 新的后端排在最前面
+    void addBackend(ImageDecoderBackend *backend)
+    {
+        backend->allocator = backends.front()->allocator;
+        backends.emplace(backends.begin(), backend);
+    }
+
+    bool decode(const uint8_t *data, size_t size, const ImageDecodeOptions &options, DecodedImage &image)
+    {
+        for (auto &backend : backends)
+        {
+            if (backend->canDecode(data, size) && backend->decode(data, size, options, image))
+                return true;
+        }
+        return false;
+    }
+    bool decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image)
+    {
+        ImageDecodeOptions options;
+        options.channels = desiredChannels;
+        return decode(data, size, options, image);
+    }
+
+    bool decodeFile(const char *path, const ImageDecodeOptions &options, DecodedImage &image)
+    {
+        FILE *file = fopen(path, "rb");
+        if (!file)
+            return false;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        ImageBuffer contents(backends.front()->allocator, size > 0 ? size : 1);
+        bool ok = size > 0 && fread(contents.data(), 1, size, file) == (size_t)size;
+        fclose(file);
+        return ok && decode(contents.data(), size, options, image);
+    }
+
+    // 先拿到布局，调用者按 layout.size() 准备目标缓冲
+    bool readLayout(const uint8_t *data, size_t size, const ImageDecodeOptions &options, ImageLayout &layout)
+    {
+        int width, height, channels;
+        for (auto &backend : backends)
+        {
+            if (backend->canDecode(data, size) && backend->readInfo(data, size, width, height, channels))
+            {
+                layout = makeImageLayout(width, height, channels, options);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool decodeInto(const uint8_t *data, size_t size, const ImageDecodeOptions &options, const ImageLayout &layout, uint8_t *target)
+    {
+        for (auto &backend : backends)
+        {
+            if (backend->canDecode(data, size) && backend->decodeInto(data, size, options, layout, target))
+                return true;
+        }
+        return false;
+    }
+
+    // 所有后端的临时缓冲改用这个分配器
+    void setAllocator(ImageAllocator *allocator)
+    {
+        for (auto &backend : backends)
+            backend->allocator = allocator;
+    }
+
+    ImageDecoderBackend *find(const char *name)
+    {
+        for (auto &backend : backends)
+        {
+            if (strcmp(backend->name(), name) == 0)
+                return backend.get();
+        }
+        return NULL;
+    }
+
+private:
+    std::vector<std::unique_ptr<ImageDecoderBackend>> backends;
+};
+
+inline ImageDecoder imageDecoder;
+
+#endif /* image_decoder_h */
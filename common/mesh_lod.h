@@ -0,0 +1,258 @@
+//
+//  mesh_lod.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef mesh_lod_h
+#define mesh_lod_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 细节层次(LOD)
+//   - 网格简化：顶点聚类，把落在同一个网格单元里的顶点合并成一个(取平均)，去掉退化的三角形；
+//     单元逐级加倍生成 LOD 链，三角形数不再减少或者减到没有时停止
+//   - 选择：按包围球投影到屏幕上的像素大小选级别，切换阈值上下留一段滞后区间，避免在边界来回跳
+//   - 远处用公告板替身(impostor)：预先把物体渲染到一张小纹理，远处只画一个朝向摄像机的四边形
+//
+// 顶点格式和 demo 一致：非索引的三角形列表，每个顶点前三个 float 是位置，其余属性(纹理坐标等)跟随
+
+struct LodLevel
+{
+    int first; // 在合并后的顶点数组里的起始顶点
+    int count; // 顶点数
+};
+
+struct LodChain
+{
+    std::vector<float> vertices; // 所有级别的顶点连在一起，一次上传到一个 VBO
+    std::vector<LodLevel> levels;
+    int stride = 0;              // 每个顶点的 float 数
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;         // 包围球半径
+};
+
+// 顶点聚类简化，返回新的三角形列表
+inline std::vector<float> simplifyMesh(const float *vertices, int stride, int count, float cellSize)
+{
+    struct Cluster
+    {
+        std::vector<float> sum;
+        int count = 0;
+    };
+    auto cellKey = [cellSize](const float *v) {
+        int64_t x = (int64_t)std::floor(v[0] / cellSize);
+        int64_t y = (int64_t)std::floor(v[1] / cellSize);
+        int64_t z = (int64_t)std::floor(v[2] / cellSize);
+        return (uint64_t)((x & 0x1FFFFF) | (y & 0x1FFFFF) << 21 | (z & 0x1FFFFF) << 42);
+    };
+
+    // 每个单元的代表顶点是单元内所有顶点的平均
+    std::unordered_map<uint64_t, Cluster> clusters;
+    for (int i = 0; i < count; i++)
+    {
+        const float *v = vertices + i * stride;
+        Cluster &cluster = clusters[cellKey(v)];
+        if (cluster.sum.empty())
+            cluster.sum.assign(stride, 0.0f);
+        for (int k = 0; k < stride; k++)
+            cluster.sum[k] += v[k];
+        cluster.count++;
+    }
+
+    std::vector<float> result;
+    for (int t = 0; t + 2 < count; t += 3)
+    {
+        uint64_t keys[3];
+        for (int k = 0; k < 3; k++)
+            keys[k] = cellKey(vertices + (t + k) * stride);
+        // 两个顶点落在同一个单元，三角形退化，丢掉
+        if (keys[0] == keys[1] || keys[1] == keys[2] || keys[0] == keys[2])
+            continue;
+        for (int k = 0; k < 3; k++)
+        {
+            const Cluster &cluster = clusters[keys[k]];
+            for (int c = 0; c < stride; c++)
+                result.push_back(cluster.sum[c] / cluster.count);
+        }
+    }
+    return result;
+}
+
+// 生成 LOD 链，第 0 级是原始网格
+inline LodChain buildLodChain(const float *vertices, int stride, int count, int maxLevels = 4)
+{
+    LodChain chain;
+    chain.stride = stride;
+
+    // 包围球：包围盒中心 + 最远顶点距离
+    glm::vec3 minimum(INFINITY), maximum(-INFINITY);
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 p(vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+        minimum = glm::min(minimum, p);
+        maximum = glm::max(maximum, p);
+    }
+    chain.center = (minimum + maximum) * 0.5f;
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 p(vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+        chain.radius = std::max(chain.radius, glm::length(p - chain.center));
+    }
+
+    chain.vertices.assign(vertices, vertices + count * stride);
+    chain.levels.push_back({ 0, count });
+    // 第一级的单元大小是包围盒最长边的 1/16，之后逐级加倍
+    glm::vec3 extent = maximum - minimum;
+    float cellSize = std::max(extent.x, std::max(extent.y, extent.z)) / 16.0f;
+    int previousCount = count;
+    for (int level = 1; level < maxLevels && cellSize > 0.0f; level++, cellSize *= 2.0f)
+    {
+        std::vector<float> simplified = simplifyMesh(vertices, stride, count, cellSize);
+        int simplifiedCount = (int)simplified.size() / stride;
+        if (simplifiedCount == 0)
+            break;
+        if (simplifiedCount >= previousCount)
+        {
+            // 这一级没有变化，换更大的单元再试，不占用级别
+            level--;
+            if (cellSize > std::max(extent.x, std::max(extent.y, extent.z)))
+                break;
+            continue;
+        }
+        chain.levels.push_back({ (int)chain.vertices.size() / stride, simplifiedCount });
+        chain.vertices.insert(chain.vertices.end(), simplified.begin(), simplified.end());
+        previousCount = simplifiedCount;
+    }
+    return chain;
+}
+
+// 包围球投影到屏幕上的直径(像素)
+inline float projectedSize(float radius, float distance, float fovY, float viewportHeight)
+{
+    if (distance <= radius)
+        return viewportHeight;
+    return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight;
+}
+
+// 按屏幕大小选级别，带滞后
+// minPixels[i] 是使用第 i 级的最小屏幕大小，从大到小排列；小于最后一个阈值时用替身(返回 levels 数)
+struct LodSelector
+{
+    std::vector<float> minPixels;
+    float hysteresis = 0.15f; // 切换阈值上下各留的比例
+
+    int impostorLevel() const { return (int)minPixels.size(); }
+
+    int select(int current, float pixels) const
+    {
+        int level = current < 0 ? 0 : current;
+        // 变粗：低于当前级别阈值的下沿
+        while (level < impostorLevel() && pixels < minPixels[level] * (1.0f - hysteresis))
+            level++;
+        // 变细：超过上一级阈值的上沿
+        while (level > 0 && pixels > minPixels[level - 1] * (1.0f + hysteresis))
+            level--;
+        // 第一次选择时没有历史，不用滞后
+        if (current < 0)
+        {
+            level = 0;
+            while (level < impostorLevel() && pixels < minPixels[level])
+                level++;
+        }
+        return level;
+    }
+};
+
+// 替身：物体渲染到一张带透明通道的纹理上，远处画成朝向摄像机的四边形
+class Impostor
+{
+public:
+    static const int SIZE = 128;
+
+    // 创建纹理和四边形，需要在 OpenGL 上下文创建之后调用
+    void init()
+    {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SIZE, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glGenFramebuffers(1, &framebuffer);
+
+        // 四边形两个三角形，顶点是 [-1, 1] 的角点，着色器里按大小展开
+        const float corners[] = { -1, -1, 1, -1, 1, 1, 1, 1, -1, 1, -1, -1 };
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    void release()
+    {
+        glDeleteTextures(1, &texture);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteVertexArrays(1, &quadVAO);
+        glDeleteBuffers(1, &quadVBO);
+    }
+
+    // 渲染替身纹理：绑定纹理帧缓冲，清成全透明后调用 draw
+    // draw 负责用正交投影把包围球画满视口；完成后恢复到 restoreFramebuffer
+    template <typename DrawFn>
+    void bake(DrawFn draw, GLuint restoreFramebuffer, int restoreWidth, int restoreHeight)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        glViewport(0, 0, SIZE, SIZE);
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        draw();
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindFramebuffer(GL_FRAMEBUFFER, restoreFramebuffer);
+        glViewport(0, 0, restoreWidth, restoreHeight);
+        baked = true;
+    }
+
+    // 画一个四边形，着色器和 uniform 由调用者设置
+    void drawQuad() const
+    {
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+
+    GLuint getTexture() const { return texture; }
+    bool isBaked() const { return baked; }
+
+private:
+    GLuint texture = 0;
+    GLuint depthBuffer = 0;
+    GLuint framebuffer = 0;
+    GLuint quadVAO = 0;
+    GLuint quadVBO = 0;
+    bool baked = false;
+};
+
+#endif /* mesh_lod_h */
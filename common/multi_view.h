@@ -0,0 +1,245 @@
+//
+//  multi_view.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef multi_view_h
+#define multi_view_h
+
+#include <glad/glad.h>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// 单次提交的多视图渲染
+// 目标是分层的纹理(GL_TEXTURE_2D_ARRAY 或立方体贴图)，每个视图一层；
+// 每个物体只提交一次实例化绘制，实例数 = 视图数，着色器里用 gl_InstanceID 选视图矩阵和 gl_Layer：
+//   - 驱动支持 GL_ARB_shader_viewport_layer_array / GL_AMD_vertex_shader_layer 时顶点着色器直接写 gl_Layer
+//   - 否则经过一个只转发顶点的几何着色器写 gl_Layer
+// 顶点着色器约定：uniform mat4 viewProjections[MULTI_VIEW_MAX]，视图 = gl_InstanceID % viewCount
+// 用途：环境贴图 6 个面一次画完，分屏的几个视图一次画完再拼到窗口上
+//
+// 用法：
+//   MultiViewTarget probe;
+//   probe.initCubemap(256);
+//   MultiView views;
+//   views.setCubemap(position, 0.1f, 100.0f);
+//   probe.begin();
+//   views.apply(program);                 // 设置 viewProjections、viewCount
+//   views.drawArrays(GL_TRIANGLES, 0, 36); // 6 个面一次提交
+//   probe.end(0, width, height);
+
+const int MULTI_VIEW_MAX = 6;
+
+// 让顶点着色器能直接写 gl_Layer 的扩展名，优先 ARB；都不支持时返回 NULL，这时要用几何着色器
+// 着色器里的 #extension 要用这里返回的名字，两个扩展不能互相代替
+inline const char *multiViewVertexLayerExtension()
+{
+    static const char *extensions[] = { "GL_ARB_shader_viewport_layer_array", "GL_AMD_vertex_shader_layer" };
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (const char *extension : extensions)
+    {
+        for (GLint i = 0; i < count; i++)
+        {
+            const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+            if (name && strcmp(name, extension) == 0)
+                return extension;
+        }
+    }
+    return NULL;
+}
+
+// 一组视图的矩阵
+class MultiView
+{
+public:
+    int viewCount = 0;
+    glm::mat4 viewProjections[MULTI_VIEW_MAX];
+
+    void clear() { viewCount = 0; }
+
+    // 加一个视图，返回它的层号，满了返回 -1
+    int add(const glm::mat4 &viewProjection)
+    {
+        if (viewCount >= MULTI_VIEW_MAX)
+            return -1;
+        viewProjections[viewCount] = viewProjection;
+        return viewCount++;
+    }
+
+    // 立方体贴图 6 个面，顺序和 GL_TEXTURE_CUBE_MAP_POSITIVE_X + 层号一致
+    void setCubemap(const glm::vec3 &position, float nearPlane, float farPlane)
+    {
+        // 立方体贴图的面是从内部看的，上方向按规范取 -Y(上下两个面例外)
+        static const glm::vec3 directions[6] = {
+            glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f, 0.0f),
+            glm::vec3( 0.0f,-1.0f, 0.0f), glm::vec3( 0.0f, 0.0f, 1.0f), glm::vec3(0.0f,  0.0f,-1.0f)
+        };
+        static const glm::vec3 ups[6] = {
+            glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f,  1.0f),
+            glm::vec3(0.0f,  0.0f,-1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+        };
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
+        clear();
+        for (int face = 0; face < 6; face++)
+            add(projection * glm::lookAt(position, position + directions[face], ups[face]));
+    }
+
+    // 设置当前程序的视图矩阵，程序切换后要重新调用
+    void apply(GLuint program) const
+    {
+        glUniformMatrix4fv(glGetUniformLocation(program, "viewProjections"), viewCount, GL_FALSE, &viewProjections[0][0][0]);
+        glUniform1i(glGetUniformLocation(program, "viewCount"), viewCount);
+    }
+
+    // 一次提交画到所有视图
+    void drawArrays(GLenum mode, GLint first, GLsizei count) const
+    {
+        glDrawArraysInstanced(mode, first, count, viewCount);
+    }
+
+    // 本身就是实例化的绘制：实例数乘上视图数，着色器里物体实例 = gl_InstanceID / viewCount
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) const
+    {
+        glDrawArraysInstanced(mode, first, count, instances * viewCount);
+    }
+};
+
+// 分层渲染目标：颜色和深度都是分层纹理，整个纹理挂到帧缓冲上(glFramebufferTexture)，
+// 每个图元画到哪一层由着色器写的 gl_Layer 决定
+class MultiViewTarget
+{
+public:
+    // 普通的多视图，layers 层 width x height，比如分屏
+    void init(int width, int height, int layers)
+    {
+        create(GL_TEXTURE_2D_ARRAY, width, height, layers);
+    }
+
+    // 立方体贴图，6 层
+    void initCubemap(int size)
+    {
+        create(GL_TEXTURE_CUBE_MAP, size, size, 6);
+    }
+
+    // 大小变了才重建，层数和类型不变；跟着窗口或动态分辨率走的目标每帧调一次
+    void resize(int w, int h)
+    {
+        if (w <= 0 || h <= 0 || (w == width && h == height))
+            return;
+        create(target, w, h, layers);
+    }
+
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        if (framebuffer)
+            glDeleteFramebuffers(1, &framebuffer);
+        if (readFramebuffer)
+            glDeleteFramebuffers(1, &readFramebuffer);
+        if (colorTexture)
+            glDeleteTextures(1, &colorTexture);
+        if (depthTexture)
+            glDeleteTextures(1, &depthTexture);
+        framebuffer = readFramebuffer = colorTexture = depthTexture = 0;
+    }
+
+    // 绑定分层帧缓冲、设置视口，所有层一起清屏
+    void begin()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // 画完恢复到 targetFramebuffer；立方体贴图顺便生成 mip，采样时可以用三线性过滤
+    void end(GLuint targetFramebuffer, int targetWidth, int targetHeight)
+    {
+        if (target == GL_TEXTURE_CUBE_MAP)
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, colorTexture);
+            glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+        glViewport(0, 0, targetWidth, targetHeight);
+    }
+
+    // 把一层拉伸到目标帧缓冲的一个矩形里，分屏时每个视图调一次
+    void blitLayer(int layer, GLuint targetFramebuffer, int x, int y, int w, int h)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        if (target == GL_TEXTURE_CUBE_MAP)
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, colorTexture, 0);
+        else
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, layer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+        glBlitFramebuffer(0, 0, width, height, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT,
+                          w == width && h == height ? GL_NEAREST : GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+    }
+
+    GLuint getColorTexture() const { return colorTexture; }
+    GLenum getTarget() const { return target; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getLayers() const { return layers; }
+
+private:
+    GLuint framebuffer = 0;
+    GLuint readFramebuffer = 0; // 按层读取，拼分屏用
+    GLuint colorTexture = 0;
+    GLuint depthTexture = 0;
+    GLenum target = GL_TEXTURE_2D_ARRAY;
+    int width = 0, height = 0, layers = 0;
+
+    void create(GLenum textureTarget, int w, int h, int count)
+    {
+        release();
+        target = textureTarget;
+        width = w;
+        height = h;
+        layers = count;
+
+        // 分层帧缓冲要求所有附件都是分层的，深度也用同样层数的纹理
+        GLuint textures[2];
+        glGenTextures(2, textures);
+        colorTexture = textures[0];
+        depthTexture = textures[1];
+        for (int i = 0; i < 2; i++)
+        {
+            GLenum internalFormat = i == 0 ? GL_RGBA8 : GL_DEPTH_COMPONENT24;
+            GLenum format = i == 0 ? GL_RGBA : GL_DEPTH_COMPONENT;
+            GLenum type = i == 0 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_INT;
+            glBindTexture(target, textures[i]);
+            if (target == GL_TEXTURE_CUBE_MAP)
+            {
+                for (int face = 0; face < 6; face++)
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, internalFormat, w, h, 0, format, type, NULL);
+            }
+            else
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, w, h, count, 0, format, type, NULL);
+            bool mipmaps = i == 0 && target == GL_TEXTURE_CUBE_MAP;
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(target, 0);
+
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glGenFramebuffers(1, &framebuffer);
+        glGenFramebuffers(1, &readFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    }
+};
+
+#endif /* multi_view_h */
@@ -0,0 +1,223 @@
+//
+//  occlusion_culling.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef occlusion_culling_h
+#define occlusion_culling_h
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include "simd.h"
+
+// 软件遮挡剔除
+// 思路与 masked occlusion culling 类似：在 CPU 上把少量遮挡体光栅化到一张低分辨率深度缓冲里，
+// 然后用物体包围盒在屏幕上的投影矩形去查询，如果矩形内所有像素都比包围盒最近点还近，说明物体被完全遮挡，不用提交绘制
+// 深度约定与 OpenGL 一致：[0,1]，越小越近，清空为 1.0
+class OcclusionCuller
+{
+public:
+    static const int WIDTH = 256;   // 缓冲宽度，必须是4的倍数，方便一次处理4个像素
+    static const int HEIGHT = 192;  // 缓冲高度
+    static const int TILE = 8;      // 分块大小，每块记录最远深度(Hi-Z)，用于快速判定
+    static const int TILES_X = WIDTH / TILE;
+    static const int TILES_Y = HEIGHT / TILE;
+
+    struct Stats
+    {
+        int occluderTriangles = 0; // 本帧光栅化的遮挡三角形
+        int tested = 0;            // 本帧查询的物体数
+        int culled = 0;            // 本帧被剔除的物体数
+    };
+
+    OcclusionCuller() : depth(WIDTH * HEIGHT, 1.0f), tileMax(TILES_X * TILES_Y, 1.0f) {}
+
+    // 每帧开始时清空深度缓冲
+    void beginFrame()
+    {
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        std::fill(tileMax.begin(), tileMax.end(), 1.0f);
+        stats = Stats();
+    }
+
+    // 光栅化一个遮挡体(三角形列表)，vertices 中每个顶点前3个 float 是位置，stride 是顶点间隔的 float 数
+    void rasterizeOccluder(const float *vertices, int stride, int vertexCount, const glm::mat4 &mvp)
+    {
+        for (int i = 0; i + 2 < vertexCount; i += 3)
+        {
+            glm::vec4 v[3];
+            for (int k = 0; k < 3; k++)
+            {
+                const float *p = vertices + (i + k) * stride;
+                v[k] = mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+            }
+            rasterizeTriangle(v);
+        }
+    }
+
+    // 所有遮挡体光栅化完成后调用，更新每个分块的最远深度
+    void endOccluders()
+    {
+        for (int ty = 0; ty < TILES_Y; ty++)
+        {
+            for (int tx = 0; tx < TILES_X; tx++)
+            {
+                f32x4 m = simd_set1(0.0f);
+                for (int y = ty * TILE; y < (ty + 1) * TILE; y++)
+                {
+                    const float *row = &depth[y * WIDTH + tx * TILE];
+                    for (int x = 0; x < TILE; x += 4)
+                        m = simd_max(m, simd_load(row + x));
+                }
+                tileMax[ty * TILES_X + tx] = simd_hmax(m);
+            }
+        }
+    }
+
+    // 查询包围盒(模型空间)是否可能可见，mvp 为该物体的 projection * view * model
+    // 判定是保守的：拿不准的情况一律当作可见
+    bool isVisible(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const glm::mat4 &mvp)
+    {
+        stats.tested++;
+
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner((c & 1) ? boundsMax.x : boundsMin.x,
+                             (c & 2) ? boundsMax.y : boundsMin.y,
+                             (c & 4) ? boundsMax.z : boundsMin.z);
+            glm::vec4 clip = mvp * glm::vec4(corner, 1.0f);
+            // 有顶点跨过近平面，投影不可靠，直接当作可见
+            if (clip.w <= NEAR_W || clip.z < -clip.w)
+                return true;
+            float invW = 1.0f / clip.w;
+            float sx = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+            float sy = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+            float sz = clip.z * invW * 0.5f + 0.5f;
+            minX = std::fmin(minX, sx); maxX = std::fmax(maxX, sx);
+            minY = std::fmin(minY, sy); maxY = std::fmax(maxY, sy);
+            minZ = std::fmin(minZ, sz);
+        }
+
+        // 完全在屏幕外，顺带做了视锥剔除
+        if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT || minZ > 1.0f)
+        {
+            stats.culled++;
+            return false;
+        }
+
+        int x0 = std::max(0, (int)std::floor(minX));
+        int y0 = std::max(0, (int)std::floor(minY));
+        int x1 = std::min(WIDTH - 1, (int)std::ceil(maxX));
+        int y1 = std::min(HEIGHT - 1, (int)std::ceil(maxY));
+
+        f32x4 zRef = simd_set1(minZ);
+        for (int ty = y0 / TILE; ty <= y1 / TILE; ty++)
+        {
+            for (int tx = x0 / TILE; tx <= x1 / TILE; tx++)
+            {
+                // 整块都比包围盒近，跳过逐像素检查
+                if (tileMax[ty * TILES_X + tx] < minZ)
+                    continue;
+
+                int py0 = std::max(y0, ty * TILE), py1 = std::min(y1, ty * TILE + TILE - 1);
+                int px0 = std::max(x0, tx * TILE) & ~3, px1 = std::min(x1, tx * TILE + TILE - 1);
+                for (int y = py0; y <= py1; y++)
+                {
+                    const float *row = &depth[y * WIDTH];
+                    for (int x = px0; x <= px1; x += 4)
+                    {
+                        // 越界的通道(在矩形外)不参与判定
+                        mask4 inRect = simd_and(simd_cmpge(simd_set((float)x, (float)x + 1, (float)x + 2, (float)x + 3), simd_set1((float)x0)),
+                                                simd_cmplt(simd_set((float)x, (float)x + 1, (float)x + 2, (float)x + 3), simd_set1((float)x1 + 1)));
+                        if (simd_movemask(simd_and(inRect, simd_cmpge(simd_load(row + x), zRef))))
+                            return true;
+                    }
+                }
+            }
+        }
+
+        stats.culled++;
+        return false;
+    }
+
+    const Stats &getStats() const { return stats; }
+    const float *getDepthBuffer() const { return depth.data(); }
+
+private:
+    static constexpr float NEAR_W = 1e-5f;
+
+    std::vector<float> depth;   // 低分辨率深度缓冲
+    std::vector<float> tileMax; // 分块最远深度
+    Stats stats;
+
+    void rasterizeTriangle(const glm::vec4 *clip)
+    {
+        float sx[3], sy[3], zMax = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            // 需要近平面裁剪的三角形直接放弃，不写入深度是保守的
+            if (clip[k].w <= NEAR_W || clip[k].z < -clip[k].w)
+                return;
+            float invW = 1.0f / clip[k].w;
+            sx[k] = (clip[k].x * invW * 0.5f + 0.5f) * WIDTH;
+            sy[k] = (clip[k].y * invW * 0.5f + 0.5f) * HEIGHT;
+            // 整个三角形使用最远顶点的深度，保证写入值不会比真实深度更近
+            zMax = std::fmax(zMax, clip[k].z * invW * 0.5f + 0.5f);
+        }
+
+        // 有向面积，统一成逆时针，这样立方体数据里顺逆时针混用也没关系
+        float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+        if (std::fabs(area) < 1e-6f)
+            return;
+        if (area < 0.0f)
+        {
+            std::swap(sx[1], sx[2]);
+            std::swap(sy[1], sy[2]);
+        }
+
+        int x0 = std::max(0, (int)std::floor(std::fmin(sx[0], std::fmin(sx[1], sx[2])))) & ~3;
+        int y0 = std::max(0, (int)std::floor(std::fmin(sy[0], std::fmin(sy[1], sy[2]))));
+        int x1 = std::min(WIDTH - 1, (int)std::ceil(std::fmax(sx[0], std::fmax(sx[1], sx[2]))));
+        int y1 = std::min(HEIGHT - 1, (int)std::ceil(std::fmax(sy[0], std::fmax(sy[1], sy[2]))));
+        if (x0 > x1 || y0 > y1)
+            return;
+        stats.occluderTriangles++;
+
+        // 边函数 E(x,y) = A*x + B*y + C，三个边都 >= 0 时像素中心在三角形内
+        float A[3], B[3], C[3];
+        for (int e = 0; e < 3; e++)
+        {
+            int a = e, b = (e + 1) % 3;
+            A[e] = sy[a] - sy[b];
+            B[e] = sx[b] - sx[a];
+            C[e] = sx[a] * sy[b] - sx[b] * sy[a];
+        }
+
+        f32x4 zTri = simd_set1(zMax);
+        f32x4 zero = simd_set1(0.0f);
+        f32x4 offsets = simd_set(0.5f, 1.5f, 2.5f, 3.5f);
+        for (int y = y0; y <= y1; y++)
+        {
+            float py = y + 0.5f;
+            float *row = &depth[y * WIDTH];
+            for (int x = x0; x <= x1; x += 4)
+            {
+                f32x4 px = simd_add(simd_set1((float)x), offsets);
+                mask4 inside = simd_cmpge(simd_madd(simd_set1(A[0]), px, simd_set1(B[0] * py + C[0])), zero);
+                inside = simd_and(inside, simd_cmpge(simd_madd(simd_set1(A[1]), px, simd_set1(B[1] * py + C[1])), zero));
+                inside = simd_and(inside, simd_cmpge(simd_madd(simd_set1(A[2]), px, simd_set1(B[2] * py + C[2])), zero));
+                if (!simd_movemask(inside))
+                    continue;
+                f32x4 d = simd_load(row + x);
+                simd_store(row + x, simd_select(inside, simd_min(d, zTri), d));
+            }
+        }
+    }
+};
+
+#endif /* occlusion_culling_h */
@@ -0,0 +1,378 @@
+//
+//  occlusion_query.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef occlusion_query_h
+#define occlusion_query_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+    #define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif
+
+// 硬件遮挡查询
+// 可能被挡住的物体先画包围盒(不写颜色和深度)，挂一个"有没有样本通过深度测试"的查询，再决定画不画物体本身：
+//   - OCCLUSION_CONDITIONAL：同一帧里用 glBeginConditionalRender，GPU 自己根据查询结果跳过绘制，CPU 不等结果
+//   - OCCLUSION_PREVIOUS_FRAME：用前几帧读回的结果决定画不画，没有 GPU 等待，但物体刚露出来的一两帧可能缺失
+// 查询类型优先用 GL_ANY_SAMPLES_PASSED_CONSERVATIVE(OpenGL 4.3 / GL_ARB_ES3_compatibility)，
+// 允许硬件用粗粒度的深度做判断，更快；不支持时用 GL_ANY_SAMPLES_PASSED
+// 查询对象放在池里复用，结果读回之后回收，不会每帧创建删除
+// 包围盒和近平面相交(摄像机在包围盒里或者贴得很近)时包围盒的前面会被裁掉，这时不查询，直接当作可见
+// 包围盒要在遮挡体(比如最近的几个物体或者深度预渲染)画完之后再查询
+//
+// 用法：
+//   occlusionQueries.init();
+//   occlusionQueries.beginFrame();                       // 读回之前的结果，回收查询
+//   画遮挡体
+//   occlusionQueries.beginQueries();
+//   for (物体) occlusionQueries.query(编号, projection * view * 包围盒变换);  // 单位立方体 [-0.5, 0.5]
+//   occlusionQueries.endQueries();                       // 恢复颜色、深度写入，之后要重新绑定程序和 VAO
+//   for (物体) { if (occlusionQueries.beginObject(编号)) { 画物体; occlusionQueries.endObject(); } }
+
+inline const char *occlusionQueryVertexSource = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+uniform mat4 mvp;
+void main()
+{
+   gl_Position = mvp * vec4(aPos, 1.0);
+}
+)";
+
+// 只做深度测试，不输出颜色
+inline const char *occlusionQueryFragmentSource = R"(#version 330 core
+void main()
+{
+}
+)";
+
+enum OcclusionQueryMode
+{
+    OCCLUSION_CONDITIONAL,
+    OCCLUSION_PREVIOUS_FRAME,
+    OCCLUSION_QUERY_MODE_COUNT
+};
+
+inline const char *occlusionQueryModeName(OcclusionQueryMode mode)
+{
+    static const char *names[] = { "conditional", "previous-frame" };
+    return names[mode];
+}
+
+inline bool parseOcclusionQueryMode(const std::string &name, OcclusionQueryMode &mode)
+{
+    for (int i = 0; i < OCCLUSION_QUERY_MODE_COUNT; i++)
+    {
+        if (name == occlusionQueryModeName((OcclusionQueryMode)i))
+        {
+            mode = (OcclusionQueryMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct OcclusionQueryStats
+{
+    uint64_t queries = 0;   // 累计发出的查询
+    uint64_t occluded = 0;  // 累计读回的结果里被挡住的
+    uint64_t skipped = 0;   // 累计因为和近平面相交没有查询的
+    int lastOccluded = 0;   // 最近读回的一帧被挡住的个数
+    int poolSize = 0;       // 池里一共创建过的查询对象
+};
+
+// 查询对象池
+class QueryPool
+{
+public:
+    GLuint acquire()
+    {
+        if (freeQueries.empty())
+        {
+            // 一次创建一批
+            GLuint batch[32];
+            glGenQueries(32, batch);
+            freeQueries.insert(freeQueries.end(), batch, batch + 32);
+            all.insert(all.end(), batch, batch + 32);
+        }
+        GLuint query = freeQueries.back();
+        freeQueries.pop_back();
+        return query;
+    }
+
+    void recycle(GLuint query) { freeQueries.push_back(query); }
+
+    int size() const { return (int)all.size(); }
+
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        if (!all.empty())
+            glDeleteQueries((GLsizei)all.size(), all.data());
+        all.clear();
+        freeQueries.clear();
+    }
+
+private:
+    std::vector<GLuint> all;
+    std::vector<GLuint> freeQueries;
+};
+
+class OcclusionQueries
+{
+public:
+    static const int FRAME_LATENCY = 4; // 最多同时有几帧的查询没读回
+    OcclusionQueryMode mode = OCCLUSION_CONDITIONAL;
+
+    // 创建包围盒和程序，需要在 OpenGL 上下文创建之后调用
+    void init()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool conservative = major > 4 || (major == 4 && minor >= 3) || extensionSupported("GL_ARB_ES3_compatibility");
+        queryTarget = conservative ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+        // 单位立方体，8 个角点 36 个索引
+        const float corners[] = {
+            -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,
+            -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f
+        };
+        const GLubyte indices[] = {
+            0, 1, 2, 2, 3, 0,   4, 5, 6, 6, 7, 4,   0, 4, 7, 7, 3, 0,
+            1, 5, 6, 6, 2, 1,   0, 1, 5, 5, 4, 0,   3, 2, 6, 6, 7, 3
+        };
+        glGenVertexArrays(1, &boxVAO);
+        glGenBuffers(1, &boxVBO);
+        glGenBuffers(1, &boxEBO);
+        glBindVertexArray(boxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+
+        program = createProgram();
+        mvpLocation = glGetUniformLocation(program, "mvp");
+        std::cout << "OcclusionQueries: " << (conservative ? "GL_ANY_SAMPLES_PASSED_CONSERVATIVE" : "GL_ANY_SAMPLES_PASSED") << std::endl;
+    }
+
+    void release()
+    {
+        for (Frame &frame : frames)
+            frame.queries.clear();
+        pool.release();
+        glDeleteVertexArrays(1, &boxVAO);
+        glDeleteBuffers(1, &boxVBO);
+        glDeleteBuffers(1, &boxEBO);
+        glDeleteProgram(program);
+    }
+
+    // 每帧开始时调用：读回已经完成的查询，回收查询对象
+    void beginFrame()
+    {
+        readResults();
+        frameIndex++;
+        Frame &frame = frames[frameIndex % FRAME_LATENCY];
+        // 这一帧的槽位还有没读回的查询(GPU 落后太多)，只能等结果
+        if (!frame.queries.empty())
+            readFrame(frame, true);
+        std::fill(currentQuery.begin(), currentQuery.end(), 0);
+    }
+
+    // 开始画包围盒：不写颜色和深度，深度测试保持开启
+    void beginQueries()
+    {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glUseProgram(program);
+        glBindVertexArray(boxVAO);
+    }
+
+    // 查询一个物体，boxMvp 把单位立方体变换到裁剪空间
+    void query(int object, const glm::mat4 &boxMvp)
+    {
+        ensureObject(object);
+        // 和近平面相交：直接当作可见
+        if (crossesNearPlane(boxMvp))
+        {
+            visible[object] = true;
+            stats.skipped++;
+            return;
+        }
+        GLuint query = pool.acquire();
+        glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &boxMvp[0][0]);
+        glBeginQuery(queryTarget, query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, (void *)0);
+        glEndQuery(queryTarget);
+        currentQuery[object] = query;
+        frames[frameIndex % FRAME_LATENCY].queries.push_back({ object, query });
+        stats.queries++;
+    }
+
+    // 包围盒画完，恢复颜色、深度写入；程序和 VAO 由调用方重新绑定
+    void endQueries()
+    {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+    }
+
+    // 开始画一个物体，返回 false 时直接跳过；返回 true 时画完要调用 endObject
+    bool beginObject(int object)
+    {
+        ensureObject(object);
+        conditional = false;
+        if (mode == OCCLUSION_PREVIOUS_FRAME)
+            return visible[object];
+        // 查询结果在 GPU 上等，不会让 CPU 等；这一帧没有查询的物体直接画
+        if (currentQuery[object])
+        {
+            glBeginConditionalRender(currentQuery[object], GL_QUERY_WAIT);
+            conditional = true;
+        }
+        return true;
+    }
+
+    void endObject()
+    {
+        if (conditional)
+            glEndConditionalRender();
+        conditional = false;
+    }
+
+    OcclusionQueryStats getStats() const
+    {
+        OcclusionQueryStats result = stats;
+        result.poolSize = pool.size();
+        return result;
+    }
+
+private:
+    struct Frame
+    {
+        std::vector<std::pair<int, GLuint>> queries; // 物体编号和它的查询
+    };
+
+    QueryPool pool;
+    Frame frames[FRAME_LATENCY];
+    unsigned int frameIndex = 0;
+    std::vector<GLuint> currentQuery; // 这一帧每个物体的查询，0 表示没有查询
+    std::vector<bool> visible;        // 最近读回的结果，没有结果时当作可见
+    GLenum queryTarget = GL_ANY_SAMPLES_PASSED;
+    GLuint boxVAO = 0, boxVBO = 0, boxEBO = 0;
+    GLuint program = 0;
+    GLint mvpLocation = -1;
+    bool conditional = false;
+    OcclusionQueryStats stats;
+
+    void ensureObject(int object)
+    {
+        if (object >= (int)visible.size())
+        {
+            visible.resize(object + 1, true);
+            currentQuery.resize(object + 1, 0);
+        }
+    }
+
+    // 从最早的一帧开始读，某一帧还没完成就停下，下一帧再读
+    void readResults()
+    {
+        for (int age = FRAME_LATENCY - 1; age >= 0; age--)
+        {
+            Frame &frame = frames[(frameIndex + FRAME_LATENCY - age) % FRAME_LATENCY];
+            if (frame.queries.empty())
+                continue;
+            if (!readFrame(frame, false))
+                break;
+        }
+    }
+
+    // wait 为 false 时最后一个查询还没完成就返回 false；查询按顺序完成，最后一个好了前面的都好了
+    bool readFrame(Frame &frame, bool wait)
+    {
+        if (!wait)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(frame.queries.back().second, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return false;
+        }
+        int occluded = 0;
+        for (const auto &entry : frame.queries)
+        {
+            GLuint passed = 0;
+            glGetQueryObjectuiv(entry.second, GL_QUERY_RESULT, &passed);
+            visible[entry.first] = passed != 0;
+            occluded += passed == 0;
+            pool.recycle(entry.second);
+        }
+        stats.occluded += occluded;
+        stats.lastOccluded = occluded;
+        frame.queries.clear();
+        return true;
+    }
+
+    // 任何一个角点在近平面后面(z < -w)
+    static bool crossesNearPlane(const glm::mat4 &mvp)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 clip = mvp * glm::vec4((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f, 1.0f);
+            if (clip.z < -clip.w)
+                return true;
+        }
+        return false;
+    }
+
+    static bool extensionSupported(const char *extension)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+            if (name && strcmp(name, extension) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    static GLuint createProgram()
+    {
+        int success;
+        char infoLog[512];
+        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertexShader, 1, &occlusionQueryVertexSource, NULL);
+        glCompileShader(vertexShader);
+        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragmentShader, 1, &occlusionQueryFragmentSource, NULL);
+        glCompileShader(fragmentShader);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::OCCLUSION_QUERY::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return program;
+    }
+};
+
+#endif /* occlusion_query_h */
@@ -0,0 +1,275 @@
+//
+//  overdraw.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef overdraw_h
+#define overdraw_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// 重复着色(overdraw)热力图
+// 场景画到自己的离屏目标里，模板缓冲当计数器：每个通过深度测试的片元把模板值加 1(GL_INCR，到 255 饱和)
+// 只改模板状态，不碰场景里任何一个着色器，所有程序(包括替身、间接绘制)都会被统计到
+// 片元着色器里 discard 掉的片元(比如 awesomeface.png 的透明部分)不写模板，不计入
+// 显示：每个计数级别画一个全屏三角形，模板测试只让这一级的像素通过，按级别上色
+// 同时每一级挂一个 GL_SAMPLES_PASSED 查询，得到每一级的像素数，几帧之后读回算平均和最大重复次数，不会让 CPU 等 GPU
+//
+// 用法：
+//   overdraw.init();
+//   overdraw.begin();      // 绑定离屏目标(大小和当前视口一样)，清屏并设置模板计数，之后正常画场景
+//   overdraw.end();        // 画热力图，拷回 begin 时绑定的帧缓冲
+//   overdraw.getAverage(); overdraw.getMax();
+
+inline const char *overdrawVertexSource = R"(#version 330 core
+// 不需要顶点缓冲，按 gl_VertexID 生成覆盖全屏的三角形
+void main()
+{
+   vec2 position = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);
+   gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+inline const char *overdrawFragmentSource = R"(#version 330 core
+out vec4 FragColor;
+uniform vec3 color;
+void main()
+{
+   FragColor = vec4(color, 1.0);
+}
+)";
+
+class OverdrawView
+{
+public:
+    static const int LEVELS = 32;        // 0 到 LEVELS-1 单独统计，最后一级是 LEVELS-1 及以上
+    static const int QUERY_LATENCY = 4;  // 几帧之后再读查询结果
+
+    // 创建程序、查询和空 VAO，需要在 OpenGL 上下文创建之后调用
+    void init()
+    {
+        program = createProgram();
+        glGenVertexArrays(1, &vao);
+        for (int i = 0; i < QUERY_LATENCY; i++)
+            glGenQueries(LEVELS, queries[i]);
+    }
+
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        releaseTarget();
+        if (program)
+            glDeleteProgram(program);
+        if (vao)
+            glDeleteVertexArrays(1, &vao);
+        for (int i = 0; i < QUERY_LATENCY; i++)
+            glDeleteQueries(LEVELS, queries[i]);
+        program = vao = 0;
+    }
+
+    // 开始统计：记下当前的帧缓冲和视口，改画到离屏目标
+    void begin()
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        width = viewport[2];
+        height = viewport[3];
+        if (width > targetWidth || height > targetHeight)
+            createTarget(std::max(width, targetWidth), std::max(height, targetHeight));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+        glClearStencil(0);
+        glStencilMask(0xFF);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        // 模板测试总是通过，深度测试也通过时加 1；深度测试失败的片元一般在着色前就被丢掉了，不算
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+    }
+
+    // 画热力图并拷回 begin 之前的帧缓冲
+    void end()
+    {
+        readResults();
+
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glDepthMask(GL_FALSE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        glStencilMask(0x00);
+        glUseProgram(program);
+        glBindVertexArray(vao);
+        GLint colorLoc = glGetUniformLocation(program, "color");
+        GLuint *frameQueries = queries[frame % QUERY_LATENCY];
+        for (int level = 0; level < LEVELS; level++)
+        {
+            // 最后一级包括所有更大的计数：ref <= 模板值
+            glStencilFunc(level == LEVELS - 1 ? GL_LEQUAL : GL_EQUAL, level, 0xFF);
+            float color[3];
+            heatColor(level, color);
+            glUniform3fv(colorLoc, 1, color);
+            glBeginQuery(GL_SAMPLES_PASSED, frameQueries[level]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEndQuery(GL_SAMPLES_PASSED);
+        }
+        pending[frame % QUERY_LATENCY] = true;
+        frame++;
+
+        glStencilMask(0xFF);
+        glDisable(GL_STENCIL_TEST);
+        glDepthMask(GL_TRUE);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+        if (blend)
+            glEnable(GL_BLEND);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    }
+
+    // 最近一次读回的结果：平均每个像素着色几次(包括没有画到的像素)，最大次数，有画到的像素里的平均次数
+    float getAverage() const { return average; }
+    int getMax() const { return maxLevel; }
+    bool isMaxSaturated() const { return maxLevel >= LEVELS - 1; }
+    float getCoveredAverage() const { return coveredAverage; }
+
+    // 计数对应的颜色：0 黑，之后 蓝 -> 青 -> 绿 -> 黄 -> 红 -> 白
+    static void heatColor(int level, float color[3])
+    {
+        static const float ramp[6][3] = {
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 1.0f }, { 0.0f, 1.0f, 0.0f },
+            { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }
+        };
+        if (level == 0)
+        {
+            color[0] = color[1] = color[2] = 0.0f;
+            return;
+        }
+        // 1 到 8 次占前面大部分颜色，再多的都偏红白
+        float t = std::min(1.0f, std::log2((float)level) / std::log2((float)(LEVELS - 1))) * 5.0f;
+        int i = std::min(4, (int)t);
+        float f = t - i;
+        for (int c = 0; c < 3; c++)
+            color[c] = ramp[i][c] + (ramp[i + 1][c] - ramp[i][c]) * f;
+    }
+
+private:
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthStencilBuffer = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint queries[QUERY_LATENCY][LEVELS] = {};
+    bool pending[QUERY_LATENCY] = {};
+    unsigned int frame = 0;
+    GLint previousFramebuffer = 0;
+    int width = 0, height = 0;
+    int targetWidth = 0, targetHeight = 0;
+    float average = 0.0f;
+    float coveredAverage = 0.0f;
+    int maxLevel = 0;
+
+    void createTarget(int w, int h)
+    {
+        releaseTarget();
+        targetWidth = w;
+        targetHeight = h;
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glGenRenderbuffers(1, &depthStencilBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthStencilBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    }
+
+    void releaseTarget()
+    {
+        if (framebuffer)
+            glDeleteFramebuffers(1, &framebuffer);
+        if (colorBuffer)
+            glDeleteRenderbuffers(1, &colorBuffer);
+        if (depthStencilBuffer)
+            glDeleteRenderbuffers(1, &depthStencilBuffer);
+        framebuffer = colorBuffer = depthStencilBuffer = 0;
+        targetWidth = targetHeight = 0;
+    }
+
+    // 读取已经完成的一帧：各级像素数 -> 平均和最大
+    void readResults()
+    {
+        // 从最早的一帧开始读；当前帧要复用的那组查询没完成也只能等
+        for (int age = QUERY_LATENCY; age >= 1; age--)
+        {
+            unsigned int index = (frame + QUERY_LATENCY - age) % QUERY_LATENCY;
+            if (!pending[index])
+                continue;
+            GLint available = age == QUERY_LATENCY;
+            if (!available)
+                glGetQueryObjectiv(queries[index][LEVELS - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            double pixels = 0.0, covered = 0.0, fragments = 0.0;
+            int highest = 0;
+            for (int level = 0; level < LEVELS; level++)
+            {
+                GLuint count = 0;
+                glGetQueryObjectuiv(queries[index][level], GL_QUERY_RESULT, &count);
+                pixels += count;
+                fragments += (double)count * level;
+                if (level > 0)
+                    covered += count;
+                if (count)
+                    highest = level;
+            }
+            pending[index] = false;
+            average = pixels > 0.0 ? (float)(fragments / pixels) : 0.0f;
+            coveredAverage = covered > 0.0 ? (float)(fragments / covered) : 0.0f;
+            maxLevel = highest;
+        }
+    }
+
+    static GLuint createProgram()
+    {
+        int success;
+        char infoLog[512];
+        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertexShader, 1, &overdrawVertexSource, NULL);
+        glCompileShader(vertexShader);
+        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragmentShader, 1, &overdrawFragmentSource, NULL);
+        glCompileShader(fragmentShader);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::OVERDRAW::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return program;
+    }
+};
+
+#endif /* overdraw_h */
@@ -0,0 +1,315 @@
+//
+//  profiler.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef profiler_h
+#define profiler_h
+
+#include <glad/glad.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+// 分析器
+// CPU 端：RAII 作用域记录开始/结束时间戳，时间戳直接读 CPU 计数器(x86 的 TSC / ARM 的 CNTVCT)，
+//        每个线程写自己的缓冲，写入不加锁
+// GPU 端：用 GL_TIMESTAMP 查询记录区间，查询对象按帧轮换，几帧之后再读回，不会让 CPU 等 GPU
+// 两边的数据都可以导出为 Chrome / Perfetto 能打开的 trace JSON
+//
+// 用法：
+//   PROFILE_ZONE("Frame");                       // CPU 区间，到作用域结束
+//   PROFILE_GPU_ZONE(gpuProfiler, "Scene");      // GPU 区间，到作用域结束
+//   gpuProfiler.endFrame();                      // 每帧 swap 之前调用
+//   Profiler::instance().writeChromeTrace("trace.json");
+
+// 定义为 0 时所有区间宏都编译为空
+#ifndef PROFILER_ENABLED
+    #define PROFILER_ENABLED 1
+#endif
+
+// 读取 CPU 时间戳，单位由平台决定，导出时再换算成微秒
+inline uint64_t profilerTicks()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline uint64_t profilerNanoseconds()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Profiler
+{
+public:
+    struct Event
+    {
+        const char *name; // 必须是字符串常量，只记录指针
+        uint64_t begin;   // CPU 区间是时间戳计数，GPU 区间是纳秒
+        uint64_t end;
+    };
+
+    // 每个线程一个缓冲，容量固定，写满后丢弃新事件
+    struct ThreadBuffer
+    {
+        static const size_t CAPACITY = 1 << 18;
+        std::unique_ptr<Event[]> events;
+        std::atomic<size_t> count;
+        std::string name;
+        int id;
+
+        ThreadBuffer() : events(new Event[CAPACITY]), count(0), id(0) {}
+
+        void push(const char *name, uint64_t begin, uint64_t end)
+        {
+            size_t n = count.load(std::memory_order_relaxed);
+            if (n >= CAPACITY)
+                return;
+            events[n] = { name, begin, end };
+            count.store(n + 1, std::memory_order_release);
+        }
+    };
+
+    static Profiler &instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // 当前线程的缓冲，第一次调用时注册
+    ThreadBuffer &threadBuffer()
+    {
+        thread_local ThreadBuffer *buffer = NULL;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.emplace_back(new ThreadBuffer());
+            buffer = threads.back().get();
+            buffer->id = (int)threads.size();
+            buffer->name = buffer->id == 1 ? "Main" : "Thread " + std::to_string(buffer->id);
+        }
+        return *buffer;
+    }
+
+    // 给当前线程起个名字，显示在 trace 里
+    void setThreadName(const std::string &name)
+    {
+        threadBuffer().name = name;
+    }
+
+    // GPU 区间由 GpuProfiler 读回后写入，时间已经换算到 CPU 的纳秒时间轴上
+    void addGpuEvent(const char *name, uint64_t beginNs, uint64_t endNs)
+    {
+        gpuEvents.push(name, beginNs, endNs);
+    }
+
+    // 导出 Chrome trace 格式(chrome://tracing 或 ui.perfetto.dev 打开)
+    // 其它线程仍在写入也可以调用，只导出已经写完的事件
+    bool writeChromeTrace(const char *path)
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+            return false;
+
+        // 用启动到现在的两对时间戳估计计数器频率
+        uint64_t ticksNow = profilerTicks();
+        uint64_t nsNow = profilerNanoseconds();
+        double nsPerTick = nsNow > startNs && ticksNow > startTicks ?
+            (double)(nsNow - startNs) / (double)(ticksNow - startTicks) : 1.0;
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &thread : threads)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", thread->id, thread->name.c_str());
+            first = false;
+            size_t count = thread->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++)
+            {
+                const Event &event = thread->events[i];
+                double ts = (double)(int64_t)(event.begin - startTicks) * nsPerTick / 1000.0;
+                double dur = (double)(event.end - event.begin) * nsPerTick / 1000.0;
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.name, thread->id, ts, dur);
+            }
+        }
+        // GPU 单独作为一个进程显示
+        fprintf(file, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}", first ? "" : ",\n");
+        size_t count = gpuEvents.count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            const Event &event = gpuEvents.events[i];
+            double ts = (double)(int64_t)(event.begin - startNs) / 1000.0;
+            double dur = (double)(event.end - event.begin) / 1000.0;
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":2,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, ts, dur);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        return true;
+    }
+
+    uint64_t getStartNs() const { return startNs; }
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    ThreadBuffer gpuEvents;
+    uint64_t startTicks;
+    uint64_t startNs;
+
+    Profiler() : startTicks(profilerTicks()), startNs(profilerNanoseconds()) {}
+};
+
+// 程序启动时就创建分析器，让时间轴从启动开始
+inline Profiler &profilerStartup = Profiler::instance();
+
+// CPU 区间
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name) : name(name), begin(profilerTicks()) {}
+    ~ProfileZone()
+    {
+        Profiler::instance().threadBuffer().push(name, begin, profilerTicks());
+    }
+
+private:
+    const char *name;
+    uint64_t begin;
+};
+
+// GPU 区间，每帧最多 MAX_ZONES 个，结果在 FRAME_LATENCY 帧之后读回
+class GpuProfiler
+{
+public:
+    static const int FRAME_LATENCY = 4;
+    static const int MAX_ZONES = 64;
+
+    GpuProfiler()
+    {
+        for (Frame &frame : frames)
+            glGenQueries(MAX_ZONES * 2, frame.queries);
+        calibrate();
+    }
+
+    // 需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        for (Frame &frame : frames)
+            glDeleteQueries(MAX_ZONES * 2, frame.queries);
+    }
+
+    int beginZone(const char *name)
+    {
+        Frame &frame = frames[frameIndex % FRAME_LATENCY];
+        if (frame.zoneCount >= MAX_ZONES)
+            return -1;
+        int zone = frame.zoneCount++;
+        frame.names[zone] = name;
+        glQueryCounter(frame.queries[zone * 2], GL_TIMESTAMP);
+        return zone;
+    }
+
+    void endZone(int zone)
+    {
+        if (zone < 0)
+            return;
+        Frame &frame = frames[frameIndex % FRAME_LATENCY];
+        glQueryCounter(frame.queries[zone * 2 + 1], GL_TIMESTAMP);
+    }
+
+    // 每帧结束时调用，读回最早那一帧的结果
+    void endFrame()
+    {
+        frameIndex++;
+        Frame &oldest = frames[frameIndex % FRAME_LATENCY];
+        if (oldest.zoneCount > 0)
+        {
+            // 几帧之前的查询一般早已完成，没完成说明 GPU 严重落后，宁可等一下也不覆盖查询
+            for (int i = 0; i < oldest.zoneCount; i++)
+            {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(oldest.queries[i * 2], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(oldest.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+                lastZoneMs[i] = (end - begin) / 1e6;
+                Profiler::instance().addGpuEvent(oldest.names[i], begin + gpuToCpuOffset, end + gpuToCpuOffset);
+            }
+            lastZoneCount = oldest.zoneCount;
+        }
+        oldest.zoneCount = 0;
+        // GPU 时钟可能漂移，隔一段时间重新对齐
+        if (frameIndex % 600 == 0)
+            calibrate();
+    }
+
+    // 最近一次读回的各区间耗时(毫秒)，按 beginZone 的顺序
+    double zoneMilliseconds(int zone) const { return zone < lastZoneCount ? lastZoneMs[zone] : 0.0; }
+
+private:
+    struct Frame
+    {
+        GLuint queries[MAX_ZONES * 2];
+        const char *names[MAX_ZONES];
+        int zoneCount = 0;
+    };
+    Frame frames[FRAME_LATENCY];
+    uint64_t frameIndex = 0;
+    int64_t gpuToCpuOffset = 0;
+    double lastZoneMs[MAX_ZONES] = {};
+    int lastZoneCount = 0;
+
+    // 同时读取 GPU 和 CPU 的当前时间，算出两个时间轴的偏移
+    void calibrate()
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuToCpuOffset = (int64_t)profilerNanoseconds() - gpuNow;
+    }
+};
+
+class GpuProfileZone
+{
+public:
+    GpuProfileZone(GpuProfiler &profiler, const char *name) : profiler(profiler), zone(profiler.beginZone(name)) {}
+    ~GpuProfileZone() { profiler.endZone(zone); }
+
+private:
+    GpuProfiler &profiler;
+    int zone;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if PROFILER_ENABLED
+    #define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+    #define PROFILE_GPU_ZONE(profiler, name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(profiler, name)
+#else
+    #define PROFILE_ZONE(name)
+    #define PROFILE_GPU_ZONE(profiler, name)
+#endif
+
+#endif /* profiler_h */
@@ -0,0 +1,317 @@
+//
+//  regression.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef regression_h
+#define regression_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 回归测试模式
+// 设置 REGRESSION_DIR 环境变量后，demo 在隐藏窗口里把画面渲染到离屏帧缓冲，
+// 时间改用固定步长的时钟(每帧 1/60 秒)，跑完固定帧数后：
+//   - 把指定帧的画面和参考图比较，用 YIQ 色差判断像素是否不同，不同像素超过比例就失败
+//   - 把平均帧耗时(每帧 glFinish 后计时)和基准比较，慢了超过比例就失败
+// 同时设置 REGRESSION_UPDATE=1 时改为写入参考图和基准，需要在确认画面正确的机器上生成
+// 参考图是 <REGRESSION_DIR>/<demo>_<帧号>.ppm，基准是 <REGRESSION_DIR>/<demo>.baseline
+// 全部 demo 用 run_regression.sh 一起跑
+//
+// 用法：
+//   regressionInit("Camera");           // glfwCreateWindow 之前
+//   regressionSetup(SCR_WIDTH, SCR_HEIGHT); // gladLoadGLLoader 之后
+//   float time = regressionTime();       // 代替 glfwGetTime
+//   if (regressionEndFrame()) glfwSetWindowShouldClose(window, true); // glfwSwapBuffers 之前
+//   regressionEndFrame(false);           // 没画场景的帧(比如等着色器编译)，不计帧号和耗时
+//   return regressionFinish();           // main 的返回值
+
+// 比较的帧，最后一个就是总帧数 - 1
+const unsigned int REGRESSION_CAPTURE_FRAMES[] = { 1, 60, 119 };
+const unsigned int REGRESSION_FRAME_COUNT = 120;
+// 前面的帧有编译、上传等一次性开销，不计入帧耗时
+const unsigned int REGRESSION_WARMUP_FRAMES = 10;
+// 色差阈值(0~1)，越小越严格
+const double REGRESSION_COLOR_THRESHOLD = 0.1;
+// 允许不同的像素比例
+const double REGRESSION_MAX_DIFF_RATIO = 0.001;
+// 允许比基准慢的比例
+const double REGRESSION_MAX_SLOWDOWN = 0.15;
+
+struct RegressionState
+{
+    bool active = false;
+    bool update = false;
+    bool failed = false;
+    std::string name;
+    std::string dir;
+    int width = 0;
+    int height = 0;
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+    unsigned int frame = 0;
+    double frameTimeSum = 0.0;
+    unsigned int frameTimeCount = 0;
+    std::chrono::steady_clock::time_point lastFrameEnd;
+};
+
+inline RegressionState regression;
+
+// 读取环境变量，开启时窗口不显示，并关闭 Retina 的高分辨率帧缓冲，保证各机器上画面大小一致
+inline bool regressionInit(const char *name)
+{
+    const char *dir = getenv("REGRESSION_DIR");
+    if (!dir)
+        return false;
+    regression.active = true;
+    regression.update = getenv("REGRESSION_UPDATE") != NULL;
+    regression.name = name;
+    regression.dir = std::string(dir) + "/";
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    #ifdef __APPLE__
+        glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GL_FALSE);
+    #endif
+    return true;
+}
+
+// 创建离屏帧缓冲并绑定，demo 之后的绘制都画到这里
+// demo 自己切换回默认帧缓冲时要改用 regressionDefaultFramebuffer()
+inline void regressionSetup(int width, int height)
+{
+    if (!regression.active)
+        return;
+    regression.width = width;
+    regression.height = height;
+    glGenRenderbuffers(1, &regression.colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, regression.colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &regression.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, regression.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &regression.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, regression.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, regression.colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, regression.depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("[regression] %s: offscreen framebuffer incomplete\n", regression.name.c_str());
+        regression.failed = true;
+    }
+    glViewport(0, 0, width, height);
+    regression.lastFrameEnd = std::chrono::steady_clock::now();
+}
+
+inline GLuint regressionDefaultFramebuffer()
+{
+    return regression.framebuffer;
+}
+
+// 回归模式下是固定步长的时钟，否则就是 glfwGetTime
+inline double regressionTime()
+{
+    if (regression.active)
+        return regression.frame / 60.0;
+    return glfwGetTime();
+}
+
+// 二进制 PPM，第一行是图像顶部
+inline bool regressionWritePPM(const std::string &path, int width, int height, const std::vector<uint8_t> &rgb)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    fwrite(rgb.data(), 1, rgb.size(), file);
+    fclose(file);
+    return true;
+}
+
+inline bool regressionReadPPM(const std::string &path, int &width, int &height, std::vector<uint8_t> &rgb)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    int maxValue = 0;
+    bool ok = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && maxValue == 255 && fgetc(file) != EOF;
+    if (ok)
+    {
+        rgb.resize((size_t)width * height * 3);
+        ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    }
+    fclose(file);
+    return ok;
+}
+
+// 两个像素的感知色差，YIQ 空间加权的平方距离，归一化到 0~1
+inline double regressionColorDelta(const uint8_t *a, const uint8_t *b)
+{
+    double r = a[0] - b[0], g = a[1] - b[1], bl = a[2] - b[2];
+    double y = r * 0.29889531 + g * 0.58662247 + bl * 0.11448223;
+    double i = r * 0.59597799 - g * 0.27417610 - bl * 0.32180189;
+    double q = r * 0.21147017 - g * 0.52261711 + bl * 0.31114694;
+    return (0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q) / 35215.0;
+}
+
+// 读回当前帧，和参考图比较或者写入参考图
+inline void regressionCheckImage()
+{
+    int width = regression.width, height = regression.height;
+    std::vector<uint8_t> pixels((size_t)width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, regression.framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    // OpenGL 的第一行在底部
+    std::vector<uint8_t> image(pixels.size());
+    size_t row = (size_t)width * 3;
+    for (int y = 0; y < height; y++)
+        memcpy(&image[y * row], &pixels[(height - 1 - y) * row], row);
+
+    std::string path = regression.dir + regression.name + "_" + std::to_string(regression.frame) + ".ppm";
+    if (regression.update)
+    {
+        if (!regressionWritePPM(path, width, height, image))
+        {
+            printf("[regression] %s: failed to write %s\n", regression.name.c_str(), path.c_str());
+            regression.failed = true;
+        }
+        return;
+    }
+
+    int referenceWidth, referenceHeight;
+    std::vector<uint8_t> reference;
+    if (!regressionReadPPM(path, referenceWidth, referenceHeight, reference))
+    {
+        printf("[regression] %s frame %u: FAIL (missing reference %s)\n", regression.name.c_str(), regression.frame, path.c_str());
+        regression.failed = true;
+        return;
+    }
+    if (referenceWidth != width || referenceHeight != height)
+    {
+        printf("[regression] %s frame %u: FAIL (size %dx%d, reference %dx%d)\n", regression.name.c_str(), regression.frame,
+               width, height, referenceWidth, referenceHeight);
+        regression.failed = true;
+        return;
+    }
+
+    // 不同的像素在差异图里标红，其余像素变淡
+    const double threshold = REGRESSION_COLOR_THRESHOLD * REGRESSION_COLOR_THRESHOLD;
+    size_t different = 0;
+    std::vector<uint8_t> diff(image.size());
+    for (size_t p = 0; p < (size_t)width * height; p++)
+    {
+        const uint8_t *a = &image[p * 3], *b = &reference[p * 3];
+        if (regressionColorDelta(a, b) > threshold)
+        {
+            different++;
+            diff[p * 3] = 255;
+            diff[p * 3 + 1] = 0;
+            diff[p * 3 + 2] = 0;
+        }
+        else
+        {
+            uint8_t gray = (uint8_t)(191 + (a[0] + a[1] + a[2]) / 12);
+            diff[p * 3] = diff[p * 3 + 1] = diff[p * 3 + 2] = gray;
+        }
+    }
+    double ratio = (double)different / ((double)width * height);
+    bool pass = ratio <= REGRESSION_MAX_DIFF_RATIO;
+    printf("[regression] %s frame %u: %s (%.3f%% pixels differ)\n", regression.name.c_str(), regression.frame,
+           pass ? "PASS" : "FAIL", ratio * 100.0);
+    if (!pass)
+    {
+        regression.failed = true;
+        regressionWritePPM(regression.dir + regression.name + "_" + std::to_string(regression.frame) + "_actual.ppm", width, height, image);
+        regressionWritePPM(regression.dir + regression.name + "_" + std::to_string(regression.frame) + "_diff.ppm", width, height, diff);
+    }
+}
+
+// 每帧 glfwSwapBuffers 之前调用，返回 true 表示已经跑完，应该退出渲染循环
+inline bool regressionEndFrame(bool counted = true)
+{
+    if (!regression.active)
+        return false;
+    // 等 GPU 做完这一帧，帧耗时包含 GPU 时间
+    glFinish();
+    auto now = std::chrono::steady_clock::now();
+    // 不计数的帧不推进时钟，也不算进下一帧的耗时
+    if (!counted)
+    {
+        regression.lastFrameEnd = now;
+        return false;
+    }
+    if (regression.frame >= REGRESSION_WARMUP_FRAMES)
+    {
+        regression.frameTimeSum += std::chrono::duration<double, std::milli>(now - regression.lastFrameEnd).count();
+        regression.frameTimeCount++;
+    }
+    for (unsigned int captureFrame : REGRESSION_CAPTURE_FRAMES)
+    {
+        if (captureFrame == regression.frame)
+            regressionCheckImage();
+    }
+    // 读回不计入下一帧的耗时
+    regression.lastFrameEnd = std::chrono::steady_clock::now();
+    regression.frame++;
+    return regression.frame >= REGRESSION_FRAME_COUNT;
+}
+
+// 比较帧耗时，释放离屏帧缓冲，返回进程的退出码
+// 需要在 glfwTerminate 之前调用
+inline int regressionFinish()
+{
+    if (!regression.active)
+        return 0;
+    glDeleteFramebuffers(1, &regression.framebuffer);
+    glDeleteRenderbuffers(1, &regression.colorBuffer);
+    glDeleteRenderbuffers(1, &regression.depthBuffer);
+
+    if (regression.frame < REGRESSION_FRAME_COUNT)
+    {
+        printf("[regression] %s: FAIL (stopped after %u frames)\n", regression.name.c_str(), regression.frame);
+        return 1;
+    }
+    double average = regression.frameTimeCount ? regression.frameTimeSum / regression.frameTimeCount : 0.0;
+    std::string baselinePath = regression.dir + regression.name + ".baseline";
+    if (regression.update)
+    {
+        FILE *file = fopen(baselinePath.c_str(), "w");
+        if (file)
+        {
+            fprintf(file, "%.4f\n", average);
+            fclose(file);
+        }
+        printf("[regression] %s: updated references, frame time %.3f ms\n", regression.name.c_str(), average);
+        return regression.failed || !file ? 1 : 0;
+    }
+
+    double baseline = 0.0;
+    FILE *file = fopen(baselinePath.c_str(), "r");
+    if (!file || fscanf(file, "%lf", &baseline) != 1)
+    {
+        printf("[regression] %s frame time %.3f ms: FAIL (missing baseline %s)\n", regression.name.c_str(), average, baselinePath.c_str());
+        regression.failed = true;
+    }
+    else
+    {
+        bool pass = average <= baseline * (1.0 + REGRESSION_MAX_SLOWDOWN);
+        printf("[regression] %s frame time %.3f ms (baseline %.3f ms, %+.1f%%): %s\n", regression.name.c_str(), average, baseline,
+               baseline > 0.0 ? (average / baseline - 1.0) * 100.0 : 0.0, pass ? "PASS" : "FAIL");
+        regression.failed |= !pass;
+    }
+    if (file)
+        fclose(file);
+    return regression.failed ? 1 : 0;
+}
+
+#endif /* regression_h */
@@ -0,0 +1,115 @@
+//
+//  scene_graph.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef scene_graph_h
+#define scene_graph_h
+
+#include <glm/glm.hpp>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+// 场景图
+// 节点按数组下标编号，父节点的下标总是小于子节点(添加节点时父节点必须已经存在)，
+// 所以从前往后扫一遍就能保证先算父节点再算子节点，不需要递归
+// 各属性分开存放(SoA)，更新时只访问需要的数组
+// 修改局部变换只做标记，update 时从第一个脏节点开始线性扫描，
+// 只重新计算脏节点和它们的子树，静态节点的世界矩阵保持不变
+//
+// 用法：
+//   SceneGraph scene;
+//   int root = scene.addNode(SceneGraph::NO_PARENT);
+//   int cube = scene.addNode(root, glm::translate(glm::mat4(1.0f), position));
+//   scene.setLocal(cube, newLocal);   // 只标记
+//   scene.update();                   // 每帧绘制前调用一次
+//   glUniformMatrix4fv(loc, 1, GL_FALSE, &scene.world(cube)[0][0]);
+
+class SceneGraph
+{
+public:
+    static const int NO_PARENT = -1;
+
+    int addNode(int parent, const glm::mat4 &local = glm::mat4(1.0f))
+    {
+        int node = (int)parents.size();
+        // 父节点必须先添加，保证父节点下标小于子节点
+        if (parent >= node)
+            parent = NO_PARENT;
+        parents.push_back(parent);
+        locals.push_back(local);
+        worlds.push_back(local);
+        dirty.push_back(1);
+        changed.push_back(0);
+        markDirty(node);
+        return node;
+    }
+
+    void setLocal(int node, const glm::mat4 &local)
+    {
+        locals[node] = local;
+        markDirty(node);
+    }
+
+    const glm::mat4 &local(int node) const { return locals[node]; }
+    const glm::mat4 &world(int node) const { return worlds[node]; }
+    int parent(int node) const { return parents[node]; }
+    int size() const { return (int)parents.size(); }
+
+    // 这一帧世界矩阵是否被重新计算过，可以据此更新依赖世界矩阵的数据(包围盒等)
+    bool worldChanged(int node) const { return changed[node] != 0; }
+
+    // 重新计算脏节点及其子树的世界矩阵，返回重新计算的节点数
+    int update()
+    {
+        int count = size();
+        // 上一次更新标记的节点先清掉
+        for (int node = firstChanged; node < count; node++)
+            changed[node] = 0;
+        firstChanged = INT_MAX;
+        lastUpdated = 0;
+        if (firstDirty >= count)
+            return 0;
+
+        for (int node = firstDirty; node < count; node++)
+        {
+            int p = parents[node];
+            bool parentChanged = p != NO_PARENT && changed[p];
+            if (!dirty[node] && !parentChanged)
+                continue;
+            worlds[node] = p == NO_PARENT ? locals[node] : worlds[p] * locals[node];
+            dirty[node] = 0;
+            changed[node] = 1;
+            if (node < firstChanged)
+                firstChanged = node;
+            lastUpdated++;
+        }
+        firstDirty = INT_MAX;
+        return lastUpdated;
+    }
+
+    // 上一次 update 重新计算的节点数
+    int lastUpdateCount() const { return lastUpdated; }
+
+private:
+    std::vector<int32_t> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;   // 局部变换改过
+    std::vector<uint8_t> changed; // 上一次 update 中世界矩阵变过
+    int firstDirty = INT_MAX;     // 最小的脏节点下标，它之前的节点不用看
+    int firstChanged = INT_MAX;
+    int lastUpdated = 0;
+
+    void markDirty(int node)
+    {
+        dirty[node] = 1;
+        if (node < firstDirty)
+            firstDirty = node;
+    }
+};
+
+#endif /* scene_graph_h */
@@ -0,0 +1,489 @@
+//
+//  shader_reload.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef shader_reload_h
+#define shader_reload_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include "shader_variant.h"
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// 着色器热重载
+// 着色器从文件加载，支持 #include "xxx.glsl"(相对当前文件路径，每个阶段里同一个文件只展开一次)；有文件读不到时报错，不编译
+// 后台线程监听文件变化(Linux 用 inotify，其它平台轮询修改时间)，改动后重新编译：
+//   - 驱动支持 GL_KHR_parallel_shader_compile 时，主线程提交编译后每帧查询 GL_COMPLETION_STATUS_KHR，不会阻塞
+//   - 否则在一个共享上下文的隐藏窗口里由后台线程编译链接，用 fence 通知主线程
+// 新程序链接成功之前一直使用旧程序，编译失败时打印日志并保留旧程序
+// 可以带一个几何着色器(比如多视图渲染里选择 gl_Layer)，不需要时留空
+class ShaderReloader
+{
+public:
+    explicit ShaderReloader(GLFWwindow *window)
+    {
+        parallelCompile = glfwExtensionSupported("GL_KHR_parallel_shader_compile") ||
+                          glfwExtensionSupported("GL_ARB_parallel_shader_compile");
+        if (parallelCompile)
+        {
+            // 让驱动自己决定编译线程数
+            typedef void (*MaxThreadsProc)(GLuint);
+            MaxThreadsProc maxThreads = (MaxThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+            if (!maxThreads)
+                maxThreads = (MaxThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+            if (maxThreads)
+                maxThreads(0xFFFFFFFF);
+        }
+        else
+        {
+            // 共享上下文必须在主线程创建，之后交给后台线程使用
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            workerWindow = glfwCreateWindow(1, 1, "ShaderCompiler", NULL, window);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+            if (workerWindow == NULL)
+                std::cout << "ERROR::SHADER::RELOAD::SHARED_CONTEXT_FAILED" << std::endl;
+        }
+        // 两种异步方式都不可用时退化为主线程同步编译
+        compileOnMainThread = parallelCompile || workerWindow == NULL;
+        running = true;
+        watcher = std::thread(&ShaderReloader::watchLoop, this);
+    }
+
+    ~ShaderReloader()
+    {
+        running = false;
+        if (watcher.joinable())
+            watcher.join();
+        for (Entry &entry : entries)
+        {
+            if (entry.program)
+                glDeleteProgram(entry.program);
+            if (entry.pending.program)
+                glDeleteProgram(entry.pending.program);
+        }
+        if (workerWindow)
+            glfwDestroyWindow(workerWindow);
+    }
+
+    // 加载一个着色器程序，返回编号。编译是异步的，链接完成之前 program() 返回 0
+    int load(const std::string &vertexPath, const std::string &fragmentPath, const std::string &defines = "",
+             const std::string &geometryPath = "")
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry entry;
+        entry.vertexPath = vertexPath;
+        entry.fragmentPath = fragmentPath;
+        entry.geometryPath = geometryPath;
+        entry.defines = defines;
+        entries.push_back(entry);
+        int id = (int)entries.size() - 1;
+        dirty.insert(id);
+        return id;
+    }
+
+    // 当前可用的程序对象，热重载后会变化，需要每帧重新获取
+    unsigned int program(int id) const
+    {
+        return entries[id].program;
+    }
+
+    // 主线程每帧调用：提交待编译的着色器，检查编译是否完成，完成后替换程序
+    // 有程序被替换时返回 true，调用方需要重新设置只设置一次的 uniform(比如纹理单元)
+    bool update()
+    {
+        std::vector<Source> sources;
+        std::vector<Compiled> compiled;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // 初次加载的程序在主线程读文件，后续改动由后台线程读
+            for (int id : dirty)
+            {
+                Source source;
+                if (readSources(id, source))
+                    readySources.push_back(source);
+            }
+            dirty.clear();
+            if (compileOnMainThread)
+                sources.swap(readySources);
+            compiled.swap(readyPrograms);
+        }
+
+        for (const Source &source : sources)
+            submit(source);
+
+        bool swapped = false;
+        for (Entry &entry : entries)
+        {
+            Pending &pending = entry.pending;
+            if (!pending.program)
+                continue;
+            // 并行编译还没结束，下一帧再查
+            int done = GL_TRUE;
+            if (parallelCompile)
+                glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done)
+                continue;
+            swapped |= finish(entry, pending);
+            pending = Pending();
+        }
+
+        for (const Compiled &result : compiled)
+        {
+            // 后台线程的 fence 还没有完成就留到下一帧
+            if (glClientWaitSync(result.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                readyPrograms.push_back(result);
+                continue;
+            }
+            glDeleteSync(result.fence);
+            Pending linked;
+            linked.program = result.program;
+            swapped |= finish(entries[result.id], linked);
+        }
+        return swapped;
+    }
+
+private:
+    struct Source
+    {
+        int id;
+        std::string name;
+        std::string vertex;
+        std::string fragment;
+        std::string geometry; // 没有几何着色器时为空
+        std::set<std::string> dependencies;
+    };
+    struct Pending
+    {
+        unsigned int program = 0;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        unsigned int geometryShader = 0;
+    };
+    struct Compiled
+    {
+        int id;
+        unsigned int program;
+        GLsync fence;
+    };
+    struct Entry
+    {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::string geometryPath;
+        std::string defines;
+        std::set<std::string> dependencies; // 展开后用到的所有文件
+        unsigned int program = 0;           // 当前在用的程序
+        Pending pending;                    // 正在并行编译的程序
+    };
+
+    std::vector<Entry> entries;
+    std::set<int> dirty;                 // 需要重新读取的程序
+    std::vector<Source> readySources;    // 已读取、等待提交编译的源码
+    std::vector<Compiled> readyPrograms; // 后台线程编译完成的程序
+    std::mutex mutex;
+    std::thread watcher;
+    std::atomic<bool> running;
+    bool parallelCompile = false;
+    bool compileOnMainThread = false;
+    GLFWwindow *workerWindow = NULL;
+
+    // 读取文件并展开 #include，已经展开过的文件跳过
+    static bool preprocess(const std::string &path, std::string &out, std::set<std::string> &dependencies, int depth)
+    {
+        if (depth > 16 || dependencies.count(path))
+            return depth <= 16;
+        dependencies.insert(path);
+
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+            return false;
+        }
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        std::string line;
+        bool ok = true;
+        while (std::getline(file, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            if (start != std::string::npos && line.compare(start, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', start);
+                size_t close = line.find('"', open + 1);
+                if (open == std::string::npos || close == std::string::npos)
+                {
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE " << path << ": " << line << std::endl;
+                    ok = false;
+                    continue;
+                }
+                ok &= preprocess(directory + line.substr(open + 1, close - open - 1), out, dependencies, depth + 1);
+                continue;
+            }
+            out += line;
+            out += '\n';
+        }
+        return ok;
+    }
+
+    // 调用方需要持有 mutex；有文件读不到时返回 false，这次不编译，继续用原来的程序
+    bool readSources(int id, Source &source)
+    {
+        Entry &entry = entries[id];
+        source.id = id;
+        source.name = entry.fragmentPath;
+        const std::string *paths[3] = { &entry.vertexPath, &entry.fragmentPath, &entry.geometryPath };
+        std::string *outputs[3] = { &source.vertex, &source.fragment, &source.geometry };
+        bool ok = true;
+        for (int stage = 0; stage < 3; stage++)
+        {
+            if (paths[stage]->empty())
+                continue;
+            // 每个阶段单独记录展开过的文件，几个阶段共用的头文件在每个阶段里都要展开一次
+            std::set<std::string> included;
+            ok &= preprocess(*paths[stage], *outputs[stage], included, 0);
+            *outputs[stage] = injectShaderDefines(*outputs[stage], entry.defines);
+            source.dependencies.insert(included.begin(), included.end());
+        }
+        // 读失败也记下依赖，文件改好之后还能触发重载
+        entry.dependencies = source.dependencies;
+        if (!ok)
+            std::cout << "ERROR::SHADER::PREPROCESS_FAILED " << entry.fragmentPath << std::endl;
+        return ok;
+    }
+
+    static unsigned int compileShader(GLenum type, const std::string &source)
+    {
+        unsigned int shader = glCreateShader(type);
+        const char *text = source.c_str();
+        glShaderSource(shader, 1, &text, NULL);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    // 编译源码里的所有着色器并链接，不检查状态
+    static Pending compileProgram(const Source &source)
+    {
+        Pending result;
+        result.vertexShader = compileShader(GL_VERTEX_SHADER, source.vertex);
+        result.fragmentShader = compileShader(GL_FRAGMENT_SHADER, source.fragment);
+        if (!source.geometry.empty())
+            result.geometryShader = compileShader(GL_GEOMETRY_SHADER, source.geometry);
+        result.program = glCreateProgram();
+        glAttachShader(result.program, result.vertexShader);
+        glAttachShader(result.program, result.fragmentShader);
+        if (result.geometryShader)
+            glAttachShader(result.program, result.geometryShader);
+        glLinkProgram(result.program);
+        return result;
+    }
+
+    static void deleteShaders(const Pending &pending)
+    {
+        glDeleteShader(pending.vertexShader);
+        glDeleteShader(pending.fragmentShader);
+        if (pending.geometryShader)
+            glDeleteShader(pending.geometryShader);
+    }
+
+    // 主线程提交并行编译，不查询状态
+    void submit(const Source &source)
+    {
+        Entry &entry = entries[source.id];
+        if (entry.pending.program)
+        {
+            // 上一次改动还没编译完，直接作废
+            glDeleteProgram(entry.pending.program);
+            deleteShaders(entry.pending);
+        }
+        entry.pending = compileProgram(source);
+    }
+
+    // 检查链接结果，成功则替换旧程序
+    static bool checkProgram(const Pending &linked, const std::string &name)
+    {
+        int success;
+        char infoLog[512];
+        const struct { unsigned int shader; const char *stage; } stages[] = {
+            { linked.vertexShader, "VERTEX" }, { linked.fragmentShader, "FRAGMENT" }, { linked.geometryShader, "GEOMETRY" }
+        };
+        for (const auto &stage : stages)
+        {
+            if (!stage.shader)
+                continue;
+            glGetShaderiv(stage.shader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(stage.shader, 512, NULL, infoLog);
+                std::cout << "ERROR::SHADER::" << stage.stage << "::COMPILATION_FAILED " << name << "\n" << infoLog << std::endl;
+            }
+        }
+        unsigned int program = linked.program;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED " << name << "\n" << infoLog << std::endl;
+        }
+        return success;
+    }
+
+    // linked 里的着色器为 0 表示已经删除(后台线程编译的程序)
+    bool finish(Entry &entry, const Pending &linked)
+    {
+        unsigned int program = linked.program;
+        bool success = checkProgram(linked, entry.fragmentPath);
+        if (linked.vertexShader)
+            deleteShaders(linked);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            return false;
+        }
+        if (entry.program)
+            glDeleteProgram(entry.program);
+        entry.program = program;
+        return true;
+    }
+
+    // 后台线程：监听文件变化，非并行编译模式下顺便在共享上下文里编译
+    void watchLoop()
+    {
+        if (workerWindow)
+            glfwMakeContextCurrent(workerWindow);
+
+        std::map<std::string, time_t> modified;
+#ifdef __linux__
+        int notify = inotify_init1(IN_NONBLOCK);
+        std::map<int, std::string> watchedDirectories;
+#endif
+        while (running)
+        {
+            std::set<std::string> changed;
+#ifdef __linux__
+            // 编辑器保存文件经常是先写临时文件再改名，所以监听目录而不是文件
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const Entry &entry : entries)
+                {
+                    for (const std::string &path : entry.dependencies)
+                    {
+                        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+                        bool watched = false;
+                        for (auto &item : watchedDirectories)
+                            watched |= item.second == directory;
+                        if (!watched)
+                        {
+                            int wd = inotify_add_watch(notify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                            if (wd >= 0)
+                                watchedDirectories[wd] = directory;
+                        }
+                    }
+                }
+            }
+            pollfd fd = { notify, POLLIN, 0 };
+            if (poll(&fd, 1, 100) > 0)
+            {
+                char buffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+                ssize_t length;
+                while ((length = read(notify, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char *p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event *)p)->len)
+                    {
+                        inotify_event *event = (inotify_event *)p;
+                        if (event->len)
+                            changed.insert(watchedDirectories[event->wd] + event->name);
+                    }
+                }
+            }
+#else
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const Entry &entry : entries)
+                {
+                    for (const std::string &path : entry.dependencies)
+                    {
+                        struct stat info;
+                        if (stat(path.c_str(), &info) != 0)
+                            continue;
+                        auto it = modified.find(path);
+                        if (it != modified.end() && it->second != info.st_mtime)
+                            changed.insert(path);
+                        modified[path] = info.st_mtime;
+                    }
+                }
+            }
+#endif
+
+            std::vector<Source> sources;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (int id = 0; id < (int)entries.size(); id++)
+                {
+                    for (const std::string &path : changed)
+                    {
+                        if (entries[id].dependencies.count(path))
+                        {
+                            std::cout << "Reloading shader " << entries[id].fragmentPath << std::endl;
+                            Source source;
+                            if (readSources(id, source))
+                                readySources.push_back(source);
+                            break;
+                        }
+                    }
+                }
+                if (!compileOnMainThread)
+                    sources.swap(readySources);
+            }
+
+            // 共享上下文里同步编译，完成后插入 fence 交给主线程
+            for (const Source &source : sources)
+            {
+                Pending linked = compileProgram(source);
+                unsigned int program = linked.program;
+                bool success = checkProgram(linked, source.name);
+                deleteShaders(linked);
+                if (!success)
+                {
+                    glDeleteProgram(program);
+                    continue;
+                }
+                Compiled result = { source.id, program, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) };
+                glFlush();
+                std::lock_guard<std::mutex> lock(mutex);
+                readyPrograms.push_back(result);
+            }
+        }
+#ifdef __linux__
+        close(notify);
+#endif
+        if (workerWindow)
+            glfwMakeContextCurrent(NULL);
+    }
+};
+
+#endif /* shader_reload_h */
@@ -0,0 +1,196 @@
+//
+//  shader_variant.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef shader_variant_h
+#define shader_variant_h
+
+#include <glad/glad.h>
+#include <array>
+#include <cstdio>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 着色器变体
+// 特性位和常量在 C++ 里声明，编译着色器时以 #define 的形式注入到 #version 之后，
+// 着色器里用 #ifdef / 宏常量代替运行时分支和 uniform，不需要手工维护多份着色器
+//
+// 用法：
+//   enum ColorFeature : unsigned int { VERTEX_COLOR = 1u << 0, UNIFORM_COLOR = 1u << 1 };
+//   ShaderVariants<2> variants(vs, fs, {"VERTEX_COLOR", "UNIFORM_COLOR"}, {ShaderConstant::Float("MIX_FACTOR", 0.4)});
+//   glUseProgram(variants.get(variantKey(UNIFORM_COLOR)));
+
+// 编译期常量，会生成 #define NAME VALUE
+struct ShaderConstant
+{
+    const char *name;
+    double value;
+    bool isInt;
+
+    static constexpr ShaderConstant Float(const char *name, double value) { return { name, value, false }; }
+    static constexpr ShaderConstant Int(const char *name, int value) { return { name, (double)value, true }; }
+};
+
+// 把多个特性位合成变体的 key，key 同时也是变体表的下标
+constexpr unsigned int variantKey() { return 0; }
+template <typename... Rest>
+constexpr unsigned int variantKey(unsigned int bit, Rest... rest) { return bit | variantKey(rest...); }
+
+// 生成常量的 #define 列表
+inline std::string constantDefines(const std::vector<ShaderConstant> &constants)
+{
+    std::string defines;
+    for (const ShaderConstant &constant : constants)
+    {
+        char value[64];
+        // GLSL 的浮点常量必须带小数点
+        if (constant.isInt)
+            snprintf(value, sizeof(value), "%d", (int)constant.value);
+        else
+            snprintf(value, sizeof(value), "%#.9g", constant.value);
+        defines += std::string("#define ") + constant.name + " " + value + "\n";
+    }
+    return defines;
+}
+
+// 生成一个变体的 #define 列表
+template <size_t FEATURE_COUNT>
+std::string variantDefines(unsigned int key, const std::array<const char *, FEATURE_COUNT> &features,
+                           const std::vector<ShaderConstant> &constants = {})
+{
+    std::string defines;
+    for (size_t i = 0; i < FEATURE_COUNT; i++)
+    {
+        if (key & (1u << i))
+            defines += std::string("#define ") + features[i] + "\n";
+    }
+    return defines + constantDefines(constants);
+}
+
+// #define 要放在 #version 之后
+inline std::string injectShaderDefines(const std::string &source, const std::string &defines)
+{
+    if (defines.empty())
+        return source;
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+        return defines + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + defines;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+// 一个着色器程序的全部变体，2^FEATURE_COUNT 个程序放在定长数组里，绘制时按 key 直接取，O(1)
+// 变体默认在第一次使用时编译，也可以用 precompile 提前编译
+template <size_t FEATURE_COUNT>
+class ShaderVariants
+{
+public:
+    static constexpr unsigned int VARIANT_COUNT = 1u << FEATURE_COUNT;
+
+    ShaderVariants(const char *vertexSource, const char *fragmentSource,
+                   const std::array<const char *, FEATURE_COUNT> &features,
+                   const std::vector<ShaderConstant> &constants = {})
+        : vertexSource(vertexSource), fragmentSource(fragmentSource), features(features), constants(constants)
+    {
+        programs.fill(0);
+    }
+
+    // 删除所有已编译的变体，需要在 OpenGL 上下文销毁前调用
+    void release()
+    {
+        for (unsigned int &program : programs)
+        {
+            if (program)
+                glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    // 取得变体对应的程序，还没编译过就现在编译
+    unsigned int get(unsigned int key)
+    {
+        unsigned int &program = programs[key & (VARIANT_COUNT - 1)];
+        if (program == 0)
+            program = compile(key);
+        return program;
+    }
+
+    // 提前编译一批变体，避免第一次用到时卡顿
+    void precompile(std::initializer_list<unsigned int> keys)
+    {
+        for (unsigned int key : keys)
+            get(key);
+    }
+
+    // 提前编译所有变体
+    void precompileAll()
+    {
+        for (unsigned int key = 0; key < VARIANT_COUNT; key++)
+            get(key);
+    }
+
+private:
+    const char *vertexSource;
+    const char *fragmentSource;
+    std::array<const char *, FEATURE_COUNT> features;
+    std::vector<ShaderConstant> constants;
+    std::array<unsigned int, VARIANT_COUNT> programs;
+
+    unsigned int compile(unsigned int key)
+    {
+        std::string defines = variantDefines(key, features, constants);
+        std::string vertex = injectShaderDefines(vertexSource, defines);
+        std::string fragment = injectShaderDefines(fragmentSource, defines);
+        const char *text;
+        int success;
+        char infoLog[512];
+
+        // 创建一个顶点着色器
+        unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        text = vertex.c_str();
+        glShaderSource(vertexShader, 1, &text, NULL);
+        glCompileShader(vertexShader);
+        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED variant " << key << "\n" << infoLog << std::endl;
+        }
+
+        // 创建一个片元着色器
+        unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        text = fragment.c_str();
+        glShaderSource(fragmentShader, 1, &text, NULL);
+        glCompileShader(fragmentShader);
+        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED variant " << key << "\n" << infoLog << std::endl;
+        }
+
+        // 关联着色器
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED variant " << key << "\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return program;
+    }
+};
+
+#endif /* shader_variant_h */
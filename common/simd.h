@@ -0,0 +1,222 @@
+//
+//  simd.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef simd_h
+#define simd_h
+
+// 4路 float 向量的最小封装：x86 上走 SSE2，Apple Silicon 上走 NEON，其它平台退化为标量
+// 只提供遮挡剔除、图像处理等热点代码需要的几个操作
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SIMD_NEON 1
+#endif
+
+struct f32x4
+{
+#if SIMD_SSE2
+    __m128 v;
+#elif SIMD_NEON
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+};
+
+// 按位掩码，比较结果用
+typedef f32x4 mask4;
+
+inline f32x4 simd_set1(float s)
+{
+    f32x4 r;
+#if SIMD_SSE2
+    r.v = _mm_set1_ps(s);
+#elif SIMD_NEON
+    r.v = vdupq_n_f32(s);
+#else
+    r.v[0] = r.v[1] = r.v[2] = r.v[3] = s;
+#endif
+    return r;
+}
+
+inline f32x4 simd_set(float a, float b, float c, float d)
+{
+    f32x4 r;
+#if SIMD_SSE2
+    r.v = _mm_setr_ps(a, b, c, d);
+#elif SIMD_NEON
+    float tmp[4] = { a, b, c, d };
+    r.v = vld1q_f32(tmp);
+#else
+    r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d;
+#endif
+    return r;
+}
+
+// 非对齐读写
+inline f32x4 simd_load(const float *p)
+{
+    f32x4 r;
+#if SIMD_SSE2
+    r.v = _mm_loadu_ps(p);
+#elif SIMD_NEON
+    r.v = vld1q_f32(p);
+#else
+    for (int i = 0; i < 4; i++) r.v[i] = p[i];
+#endif
+    return r;
+}
+
+inline void simd_store(float *p, f32x4 a)
+{
+#if SIMD_SSE2
+    _mm_storeu_ps(p, a.v);
+#elif SIMD_NEON
+    vst1q_f32(p, a.v);
+#else
+    for (int i = 0; i < 4; i++) p[i] = a.v[i];
+#endif
+}
+
+#if SIMD_SSE2
+    #define SIMD_BINARY(name, sse, neon, op) \
+        inline f32x4 name(f32x4 a, f32x4 b) { f32x4 r; r.v = sse(a.v, b.v); return r; }
+#elif SIMD_NEON
+    #define SIMD_BINARY(name, sse, neon, op) \
+        inline f32x4 name(f32x4 a, f32x4 b) { f32x4 r; r.v = neon(a.v, b.v); return r; }
+#else
+    #define SIMD_BINARY(name, sse, neon, op) \
+        inline f32x4 name(f32x4 a, f32x4 b) { f32x4 r; for (int i = 0; i < 4; i++) r.v[i] = op; return r; }
+#endif
+
+SIMD_BINARY(simd_add, _mm_add_ps, vaddq_f32, a.v[i] + b.v[i])
+SIMD_BINARY(simd_sub, _mm_sub_ps, vsubq_f32, a.v[i] - b.v[i])
+SIMD_BINARY(simd_mul, _mm_mul_ps, vmulq_f32, a.v[i] * b.v[i])
+SIMD_BINARY(simd_min, _mm_min_ps, vminq_f32, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+SIMD_BINARY(simd_max, _mm_max_ps, vmaxq_f32, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef SIMD_BINARY
+
+// a*b + c
+inline f32x4 simd_madd(f32x4 a, f32x4 b, f32x4 c)
+{
+#if SIMD_NEON
+    f32x4 r;
+    r.v = vmlaq_f32(c.v, a.v, b.v);
+    return r;
+#else
+    return simd_add(simd_mul(a, b), c);
+#endif
+}
+
+// 比较，返回全1/全0掩码
+inline mask4 simd_cmpge(f32x4 a, f32x4 b)
+{
+    mask4 r;
+#if SIMD_SSE2
+    r.v = _mm_cmpge_ps(a.v, b.v);
+#elif SIMD_NEON
+    r.v = vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v));
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int bits = a.v[i] >= b.v[i] ? 0xFFFFFFFFu : 0u;
+        __builtin_memcpy(&r.v[i], &bits, 4);
+    }
+#endif
+    return r;
+}
+
+inline mask4 simd_cmplt(f32x4 a, f32x4 b)
+{
+    mask4 r;
+#if SIMD_SSE2
+    r.v = _mm_cmplt_ps(a.v, b.v);
+#elif SIMD_NEON
+    r.v = vreinterpretq_f32_u32(vcltq_f32(a.v, b.v));
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int bits = a.v[i] < b.v[i] ? 0xFFFFFFFFu : 0u;
+        __builtin_memcpy(&r.v[i], &bits, 4);
+    }
+#endif
+    return r;
+}
+
+inline mask4 simd_and(mask4 a, mask4 b)
+{
+    mask4 r;
+#if SIMD_SSE2
+    r.v = _mm_and_ps(a.v, b.v);
+#elif SIMD_NEON
+    r.v = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)));
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int x, y;
+        __builtin_memcpy(&x, &a.v[i], 4);
+        __builtin_memcpy(&y, &b.v[i], 4);
+        x &= y;
+        __builtin_memcpy(&r.v[i], &x, 4);
+    }
+#endif
+    return r;
+}
+
+// mask 为真的通道取 a，否则取 b
+inline f32x4 simd_select(mask4 m, f32x4 a, f32x4 b)
+{
+    f32x4 r;
+#if SIMD_SSE2
+    r.v = _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v));
+#elif SIMD_NEON
+    r.v = vbslq_f32(vreinterpretq_u32_f32(m.v), a.v, b.v);
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int bits;
+        __builtin_memcpy(&bits, &m.v[i], 4);
+        r.v[i] = bits ? a.v[i] : b.v[i];
+    }
+#endif
+    return r;
+}
+
+// 掩码的低4位，每个通道一位
+inline int simd_movemask(mask4 m)
+{
+#if SIMD_SSE2
+    return _mm_movemask_ps(m.v);
+#elif SIMD_NEON
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(m.v), 31);
+    return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                 (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+#else
+    int r = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int bits;
+        __builtin_memcpy(&bits, &m.v[i], 4);
+        r |= (bits >> 31) << i;
+    }
+    return r;
+#endif
+}
+
+// 水平求最大值
+inline float simd_hmax(f32x4 a)
+{
+    float tmp[4];
+    simd_store(tmp, a);
+    float m = tmp[0] > tmp[1] ? tmp[0] : tmp[1];
+    float n = tmp[2] > tmp[3] ? tmp[2] : tmp[3];
+    return m > n ? m : n;
+}
+
+#endif /* simd_h */
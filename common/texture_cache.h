@@ -0,0 +1,392 @@
+//
+//  texture_cache.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef texture_cache_h
+#define texture_cache_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gpu_resources.h"
+#include "image_decoder.h"
+
+// 按内容去重的纹理缓存
+//   - 键是文件内容的哈希(FNV-1a)加上是否翻转，不同路径下内容相同的图片只解码、上传一次
+//   - 引用计数：acquire 加一，release 减一；减到 0 的纹理不马上删除，放进 LRU，下次 acquire 直接命中
+//   - 显存预算：超出时从最久没用、没有引用的纹理开始，先逐级丢掉最高的 mip(重建一张小一级的纹理，
+//     显存降到约 1/4)，都降到最小之后再整个删除；被丢掉细节的纹理再次 acquire 时从文件重新加载
+//   - 纹理对象由 GpuResources 管理，删除推迟到 GPU 用完之后
+// 纹理参数(环绕、过滤)由调用者在 acquire 之后设置，内容相同的纹理共享同一组参数
+//
+// 用法：
+//   TextureCache textureCache(resources, 256 << 20);
+//   TextureHandle texture = textureCache.acquire("container.jpg", false);
+//   glBindTexture(GL_TEXTURE_2D, resources.get(texture));
+//   textureCache.release(texture);
+//   textureCache.clear();             // resources.release() 之前调用
+
+struct TextureCacheStats
+{
+    uint64_t requests = 0;
+    uint64_t hits = 0;          // 同一路径再次请求，纹理还在
+    uint64_t dedupes = 0;       // 不同路径，内容和已有纹理相同
+    uint64_t loads = 0;         // 解码并上传
+    uint64_t mipDrops = 0;      // 因预算丢掉一级 mip
+    uint64_t evictions = 0;     // 因预算整个删除
+    size_t residentBytes = 0;
+    size_t peakBytes = 0;
+    size_t textures = 0;
+};
+
+class TextureCache
+{
+public:
+    // 丢 mip 时纹理最长边不小于这个值，再小就整个删除
+    static const int MIN_DROP_SIZE = 32;
+
+    TextureCache(GpuResources &gpuResources, size_t budgetBytes) : resources(gpuResources), budget(budgetBytes) {}
+
+    void setBudget(size_t budgetBytes)
+    {
+        budget = budgetBytes;
+        enforceBudget();
+    }
+
+    // 从文件加载，失败时返回空句柄
+    TextureHandle acquire(const std::string &path, bool flip)
+    {
+        return acquireSource({ path, NULL, 0 }, flip);
+    }
+
+    // 从内存加载(例如归档里的一段)，data 在缓存的整个生命周期内都要有效，降级后重新加载时还会用到
+    TextureHandle acquireMemory(const std::string &name, const unsigned char *data, size_t size, bool flip)
+    {
+        return acquireSource({ name, data, size }, flip);
+    }
+
+    void release(TextureHandle &texture)
+    {
+        for (auto &item : entries)
+        {
+            Entry &entry = item.second;
+            if (entry.texture == texture && entry.references > 0)
+            {
+                if (--entry.references == 0)
+                    entry.lru = unused.insert(unused.end(), entry.key);
+                break;
+            }
+        }
+        texture = TextureHandle();
+        enforceBudget();
+    }
+
+    // 删除所有纹理，没有 release 的也一起删除
+    void clear()
+    {
+        for (auto &item : entries)
+            resources.destroy(item.second.texture);
+        entries.clear();
+        unused.clear();
+        pathKeys.clear();
+        stats.residentBytes = 0;
+    }
+
+    TextureCacheStats getStats() const
+    {
+        TextureCacheStats result = stats;
+        result.textures = entries.size();
+        return result;
+    }
+
+private:
+    // 纹理的来源：文件路径，或者一段内存
+    struct Source
+    {
+        std::string path;
+        const unsigned char *data;
+        size_t size;
+    };
+
+    struct Entry
+    {
+        uint64_t key = 0;
+        Source source;           // 重新加载用
+        TextureHandle texture;
+        int width = 0, height = 0;
+        int channels = 0;
+        int dropped = 0;         // 已经丢掉的 mip 级数
+        size_t bytes = 0;
+        int references = 0;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    GpuResources &resources;
+    size_t budget;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::unordered_map<std::string, uint64_t> pathKeys; // 路径 -> 内容键，同一路径不再读文件
+    std::list<uint64_t> unused;                         // 没有引用的纹理，前面是最久没用的
+    TextureCacheStats stats;
+
+    TextureHandle acquireSource(const Source &source, bool flip)
+    {
+        stats.requests++;
+        std::string pathKey = (source.data ? "memory:" : "") + source.path + (flip ? "|flip" : "");
+        uint64_t key = 0;
+        std::vector<unsigned char> storage;
+        const unsigned char *data = NULL;
+        size_t size = 0;
+        auto known = pathKeys.find(pathKey);
+        if (known != pathKeys.end() && entries.count(known->second))
+        {
+            key = known->second;
+            stats.hits++;
+        }
+        else
+        {
+            if (!readSource(source, storage, data, size))
+            {
+                printf("TextureCache: failed to read %s\n", source.path.c_str());
+                return TextureHandle();
+            }
+            key = contentKey(data, size, flip);
+            pathKeys[pathKey] = key;
+            if (entries.count(key))
+                stats.dedupes++;
+        }
+
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            Entry &entry = it->second;
+            // 被丢过 mip 的纹理，重新加载完整的
+            if (entry.dropped > 0 && entry.references == 0)
+            {
+                if (!data && !readSource(entry.source, storage, data, size))
+                    return TextureHandle();
+                unloadEntry(entry);
+                if (!uploadEntry(entry, data, size, flip))
+                {
+                    unused.erase(entry.lru);
+                    entries.erase(it);
+                    return TextureHandle();
+                }
+            }
+            if (entry.references++ == 0)
+                unused.erase(entry.lru);
+            enforceBudget();
+            return entry.texture;
+        }
+
+        Entry &entry = entries[key];
+        entry.key = key;
+        entry.source = source;
+        entry.references = 1;
+        if (!uploadEntry(entry, data, size, flip))
+        {
+            printf("TextureCache: failed to decode %s\n", source.path.c_str());
+            entries.erase(key);
+            return TextureHandle();
+        }
+        enforceBudget();
+        return entry.texture;
+    }
+
+    // 内存来源直接返回指针，文件来源读进 storage
+    static bool readSource(const Source &source, std::vector<unsigned char> &storage, const unsigned char *&data, size_t &size)
+    {
+        if (source.data)
+        {
+            data = source.data;
+            size = source.size;
+            return size > 0;
+        }
+        FILE *file = fopen(source.path.c_str(), "rb");
+        if (!file)
+            return false;
+        fseek(file, 0, SEEK_END);
+        long length = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        storage.resize(length > 0 ? length : 0);
+        size_t read = fread(storage.data(), 1, storage.size(), file);
+        fclose(file);
+        data = storage.data();
+        size = storage.size();
+        return read == storage.size() && !storage.empty();
+    }
+
+    static uint64_t contentKey(const unsigned char *data, size_t size, bool flip)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return flip ? hash ^ 0x9E3779B97F4A7C15ull : hash;
+    }
+
+    // 显存估算，RGB 按驱动常见的 4 字节对齐
+    static size_t levelBytes(int width, int height, int channels)
+    {
+        return (size_t)width * height * (channels == 3 ? 4 : channels);
+    }
+
+    static size_t chainBytes(int width, int height, int channels)
+    {
+        size_t bytes = 0;
+        while (true)
+        {
+            bytes += levelBytes(width, height, channels);
+            if (width == 1 && height == 1)
+                return bytes;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+
+    static void formatOf(int channels, GLenum &format, GLint &internalFormat)
+    {
+        static const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        static const GLint internalFormats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+        format = formats[channels - 1];
+        internalFormat = internalFormats[channels - 1];
+    }
+
+    bool uploadEntry(Entry &entry, const unsigned char *contents, size_t size, bool flip)
+    {
+        // 大的 JPEG 走 SIMD 解码；翻转是这次解码的选项，不改 stb_image 的全局状态
+        ImageDecodeOptions options;
+        options.flipVertically = flip;
+        DecodedImage image;
+        if (!imageDecoder.decode(contents, size, options, image))
+            return false;
+        int width = image.width, height = image.height, channels = image.channels;
+        GLenum format;
+        GLint internalFormat;
+        formatOf(channels, format, internalFormat);
+        entry.texture = resources.createTexture();
+        glBindTexture(GL_TEXTURE_2D, resources.get(entry.texture));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, image.pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        entry.width = width;
+        entry.height = height;
+        entry.channels = channels;
+        entry.dropped = 0;
+        entry.bytes = chainBytes(width, height, channels);
+        addBytes(entry.bytes);
+        stats.loads++;
+        return true;
+    }
+
+    void unloadEntry(Entry &entry)
+    {
+        resources.destroy(entry.texture);
+        stats.residentBytes -= entry.bytes;
+        entry.bytes = 0;
+    }
+
+    void addBytes(size_t bytes)
+    {
+        stats.residentBytes += bytes;
+        stats.peakBytes = std::max(stats.peakBytes, stats.residentBytes);
+    }
+
+    // 丢掉最高一级 mip：把第 1 级以下读回来，上传到一张新纹理
+    bool dropTopMip(Entry &entry)
+    {
+        int width = std::max(1, entry.width / 2), height = std::max(1, entry.height / 2);
+        if (std::max(width, height) < MIN_DROP_SIZE)
+            return false;
+        GLenum format;
+        GLint internalFormat;
+        formatOf(entry.channels, format, internalFormat);
+        GLuint old = resources.get(entry.texture);
+        glBindTexture(GL_TEXTURE_2D, old);
+        GLint wrapS, wrapT, minFilter, magFilter;
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapS);
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &wrapT);
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter);
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &magFilter);
+
+        std::vector<std::vector<unsigned char>> levels;
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        for (int w = width, h = height, level = 1;; level++)
+        {
+            levels.emplace_back((size_t)w * h * entry.channels);
+            glGetTexImage(GL_TEXTURE_2D, level, format, GL_UNSIGNED_BYTE, levels.back().data());
+            if (w == 1 && h == 1)
+                break;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+        TextureHandle smaller = resources.createTexture();
+        glBindTexture(GL_TEXTURE_2D, resources.get(smaller));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int w = width, h = height, level = 0; level < (int)levels.size(); level++)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, levels[level].data());
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+
+        unloadEntry(entry);
+        entry.texture = smaller;
+        entry.width = width;
+        entry.height = height;
+        entry.dropped++;
+        entry.bytes = chainBytes(width, height, entry.channels);
+        addBytes(entry.bytes);
+        stats.mipDrops++;
+        return true;
+    }
+
+    // 超出预算时，按 LRU 顺序每张没有引用的纹理丢一级 mip，一轮一轮进行；都不能再丢时从最久没用的开始删除
+    void enforceBudget()
+    {
+        while (stats.residentBytes > budget && !unused.empty())
+        {
+            bool dropped = false;
+            for (uint64_t key : unused)
+            {
+                if (stats.residentBytes <= budget)
+                    return;
+                dropped |= dropTopMip(entries[key]);
+            }
+            if (dropped)
+                continue;
+            uint64_t key = unused.front();
+            unused.pop_front();
+            unloadEntry(entries[key]);
+            entries.erase(key);
+            stats.evictions++;
+        }
+    }
+};
+
+// 从环境变量 TEXTURE_BUDGET_MB 读预算，默认 256MB
+inline size_t textureBudgetFromEnv()
+{
+    const char *budget = getenv("TEXTURE_BUDGET_MB");
+    return (size_t)(budget && atoi(budget) > 0 ? atoi(budget) : 256) << 20;
+}
+
+#endif /* texture_cache_h */
@@ -0,0 +1,692 @@
+//
+//  virtual_texture.h
+//  common
+//
+//  Created by 文强 on 2026/10/19.
+//
+
+#ifndef virtual_texture_h
+#define virtual_texture_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// 虚拟纹理
+// 超大图片离线切成固定大小的瓦片，每一级 mip 也切好，存成一个文件(.vtex)；运行时只有用到的瓦片在显存里：
+//   - 反馈：场景先用低分辨率画一遍，每个像素输出它需要的瓦片(级别 + 坐标)，PBO 异步读回
+//   - 加载：缺的瓦片交给后台线程从文件读，粗的级别优先，主线程每帧最多上传几块
+//   - 物理页缓存：一张固定大小的纹理分成若干页，满了按 LRU 淘汰当前帧没用到的页
+//   - 间接表：每个虚拟瓦片对应的物理页，不在显存里的瓦片指向最近的已加载的上级瓦片，画面先模糊再变清楚
+// 最粗的一级(只有一块)常驻，任何位置都有东西可画
+// 显存占用只有物理页纹理和间接表，和图片大小无关
+//
+// 瓦片四周各带 border 个像素的邻居，双线性过滤跨过瓦片边缘时不会采到别的页
+//
+// 用法：
+//   buildVirtualTextureFile(rgba, width, height, "image.vtex");   // 离线
+//   VirtualTexture vt;
+//   vt.open("image.vtex");
+//   片元着色器拼上 virtualTextureShaderSource，用 sampleVirtualTexture(uv) / virtualTextureFeedback(uv)
+//   vt.beginFeedback(width, height); 画场景(反馈着色器); vt.endFeedback(framebuffer, width, height);
+//   vt.update();                       // 处理反馈、上传瓦片、更新间接表
+//   vt.bind(program, 0, 1);            // 画场景(采样着色器)
+
+struct VirtualTextureHeader
+{
+    char magic[8];      // "VTEX0001"
+    uint32_t width;     // 第 0 级的像素大小
+    uint32_t height;
+    uint32_t tileSize;  // 瓦片内容的边长，不含 border
+    uint32_t border;
+    uint32_t levels;
+    uint32_t reserved;
+};
+
+// 每一级的大小和瓦片数；下一级的像素是上一级 2x2 的平均，大小向上取整
+struct VirtualTextureLayout
+{
+    std::vector<int> levelWidth, levelHeight;
+    std::vector<int> tilesX, tilesY;
+    std::vector<uint64_t> firstTile; // 这一级第一块瓦片在文件里的序号
+    int tileSize = 0;
+    int border = 0;
+
+    int pageSize() const { return tileSize + 2 * border; }
+    size_t tileBytes() const { return (size_t)pageSize() * pageSize() * 4; }
+    int levels() const { return (int)levelWidth.size(); }
+
+    void compute(int width, int height, int tile, int tileBorder)
+    {
+        tileSize = tile;
+        border = tileBorder;
+        uint64_t tiles = 0;
+        while (true)
+        {
+            levelWidth.push_back(width);
+            levelHeight.push_back(height);
+            tilesX.push_back((width + tileSize - 1) / tileSize);
+            tilesY.push_back((height + tileSize - 1) / tileSize);
+            firstTile.push_back(tiles);
+            tiles += (uint64_t)tilesX.back() * tilesY.back();
+            if (tilesX.back() == 1 && tilesY.back() == 1)
+                break;
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+
+    uint64_t tileOffset(int level, int x, int y) const
+    {
+        uint64_t index = firstTile[level] + (uint64_t)y * tilesX[level] + x;
+        return sizeof(VirtualTextureHeader) + index * tileBytes();
+    }
+};
+
+// 生成下一级 mip，2x2 平均，奇数边上的像素重复一次
+inline void downsampleRgba(const uint8_t *src, int w, int h, uint8_t *dst, int nw, int nh)
+{
+    for (int y = 0; y < nh; y++)
+    {
+        int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+        for (int x = 0; x < nw; x++)
+        {
+            int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+            for (int c = 0; c < 4; c++)
+            {
+                int sum = src[((size_t)y0 * w + x0) * 4 + c] + src[((size_t)y0 * w + x1) * 4 + c] +
+                          src[((size_t)y1 * w + x0) * 4 + c] + src[((size_t)y1 * w + x1) * 4 + c];
+                dst[((size_t)y * nw + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+// 离线切片：rgba 是第 0 级的像素，每次只在内存里保留当前一级
+inline bool buildVirtualTextureFile(const uint8_t *rgba, int width, int height, const std::string &path, int tileSize = 128, int border = 1)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        printf("VirtualTexture: cannot write %s\n", path.c_str());
+        return false;
+    }
+    VirtualTextureLayout layout;
+    layout.compute(width, height, tileSize, border);
+    VirtualTextureHeader header = {};
+    memcpy(header.magic, "VTEX0001", 8);
+    header.width = width;
+    header.height = height;
+    header.tileSize = tileSize;
+    header.border = border;
+    header.levels = layout.levels();
+    fwrite(&header, sizeof(header), 1, file);
+
+    int pageSize = layout.pageSize();
+    std::vector<uint8_t> level(rgba, rgba + (size_t)width * height * 4);
+    std::vector<uint8_t> tile(layout.tileBytes());
+    for (int l = 0; l < layout.levels(); l++)
+    {
+        int w = layout.levelWidth[l], h = layout.levelHeight[l];
+        for (int ty = 0; ty < layout.tilesY[l]; ty++)
+        {
+            for (int tx = 0; tx < layout.tilesX[l]; tx++)
+            {
+                // 超出图片的部分(包括 border)取最近的边缘像素
+                for (int y = 0; y < pageSize; y++)
+                {
+                    int sy = std::min(std::max(ty * tileSize + y - border, 0), h - 1);
+                    for (int x = 0; x < pageSize; x++)
+                    {
+                        int sx = std::min(std::max(tx * tileSize + x - border, 0), w - 1);
+                        memcpy(&tile[((size_t)y * pageSize + x) * 4], &level[((size_t)sy * w + sx) * 4], 4);
+                    }
+                }
+                fwrite(tile.data(), 1, tile.size(), file);
+            }
+        }
+        // 生成下一级
+        if (l + 1 < layout.levels())
+        {
+            int nw = layout.levelWidth[l + 1], nh = layout.levelHeight[l + 1];
+            std::vector<uint8_t> next((size_t)nw * nh * 4);
+            downsampleRgba(level.data(), w, h, next.data(), nw, nh);
+            level.swap(next);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// 片元着色器用的函数，拼在 #version 之后
+// 间接表每个像素：rg 是物理页坐标，b 是实际映射的级别；各级的表上下叠放，vtLevelRow 是每一级的起始行
+// 反馈输出：r/g 是瓦片坐标的低 8 位，b 是高 4 位，a 是级别 + 1(0 表示没有请求)
+inline const char *virtualTextureShaderSource = R"(
+uniform sampler2D vtPhysical;
+uniform sampler2D vtIndirection;
+uniform vec2 vtSize;
+uniform float vtTileSize;
+uniform float vtBorder;
+uniform float vtPageSize;
+uniform float vtPhysicalSize;
+uniform int vtLevels;
+uniform int vtLevelRow[16];
+uniform float vtFeedbackScale;
+
+// 按屏幕导数估算需要的级别，scale 是渲染分辨率相对屏幕缩小的倍数
+float vtLevel(vec2 uv, float scale)
+{
+    vec2 texel = uv * vtSize;
+    vec2 dx = dFdx(texel) / scale, dy = dFdy(texel) / scale;
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    return clamp(lod, 0.0, float(vtLevels - 1));
+}
+
+ivec2 vtTile(vec2 uv, int level)
+{
+    return ivec2(clamp(uv, 0.0, 0.99999) * vtSize / (vtTileSize * exp2(float(level))));
+}
+
+vec4 sampleVirtualTexture(vec2 uv)
+{
+    int level = int(vtLevel(uv, 1.0));
+    ivec2 tile = vtTile(uv, level);
+    vec4 entry = texelFetch(vtIndirection, ivec2(tile.x, vtLevelRow[level] + tile.y), 0);
+    vec2 page = floor(entry.rg * 255.0 + 0.5);
+    float mapped = floor(entry.b * 255.0 + 0.5);
+    // 映射的可能是上级瓦片，在它里面的位置按它的级别算
+    vec2 inTile = fract(clamp(uv, 0.0, 0.99999) * vtSize / (vtTileSize * exp2(mapped)));
+    vec2 physical = (page * vtPageSize + vtBorder + inTile * vtTileSize) / vtPhysicalSize;
+    return textureLod(vtPhysical, physical, 0.0);
+}
+
+vec4 virtualTextureFeedback(vec2 uv)
+{
+    int level = int(vtLevel(uv, vtFeedbackScale));
+    ivec2 tile = vtTile(uv, level);
+    return vec4(float(tile.x & 255), float(tile.y & 255), float((tile.x >> 8) | ((tile.y >> 8) << 4)), float(level + 1)) / 255.0;
+}
+)";
+
+struct VirtualTextureStats
+{
+    int residentPages = 0;
+    int physicalPages = 0;
+    int pendingTiles = 0;    // 等待加载的瓦片
+    uint64_t uploads = 0;    // 累计上传
+    uint64_t evictions = 0;  // 累计淘汰
+    size_t gpuBytes = 0;     // 物理页纹理 + 间接表
+};
+
+class VirtualTexture
+{
+public:
+    static const int FEEDBACK_DIVISOR = 4; // 反馈缓冲相对屏幕缩小的倍数
+    static const int FEEDBACK_BUFFERS = 3;
+    int maxUploadsPerFrame = 8;
+
+    // pagesPerSide 是物理页纹理每边的页数
+    bool open(const std::string &path, int pagesPerSide = 16)
+    {
+        file = fopen(path.c_str(), "rb");
+        VirtualTextureHeader header;
+        if (!file || fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "VTEX0001", 8) != 0)
+        {
+            printf("VirtualTexture: cannot open %s\n", path.c_str());
+            if (file)
+                fclose(file);
+            file = NULL;
+            return false;
+        }
+        layout.compute(header.width, header.height, header.tileSize, header.border);
+        if (layout.levels() > 16 || layout.tilesX[0] > 4096 || layout.tilesY[0] > 4096 || pagesPerSide > 256)
+        {
+            printf("VirtualTexture: %s is too large\n", path.c_str());
+            fclose(file);
+            file = NULL;
+            return false;
+        }
+
+        // 物理页纹理
+        pages = pagesPerSide;
+        physicalSize = pages * layout.pageSize();
+        glGenTextures(1, &physicalTexture);
+        glBindTexture(GL_TEXTURE_2D, physicalTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, physicalSize, physicalSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        slots.resize(pages * pages);
+        for (int i = 0; i < (int)slots.size(); i++)
+            slots[i].lru = lru.insert(lru.end(), i);
+
+        // 间接表，各级上下叠放
+        indirectionWidth = layout.tilesX[0];
+        indirectionHeight = 0;
+        for (int l = 0; l < layout.levels(); l++)
+        {
+            levelRow.push_back(indirectionHeight);
+            indirectionHeight += layout.tilesY[l];
+        }
+        indirection.assign((size_t)indirectionWidth * indirectionHeight * 4, 0);
+        glGenTextures(1, &indirectionTexture);
+        glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, indirectionWidth, indirectionHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // 最粗的一级同步加载并常驻
+        int top = layout.levels() - 1;
+        std::vector<uint8_t> pixels;
+        readTile(file, tileKey(top, 0, 0), pixels);
+        int slot = allocateSlot();
+        slots[slot].pinned = true;
+        upload(slot, tileKey(top, 0, 0), pixels);
+        updateIndirection();
+
+        glGenFramebuffers(1, &feedbackFramebuffer);
+        glGenBuffers(FEEDBACK_BUFFERS, feedbackPbos);
+
+        running = true;
+        loader = std::thread(&VirtualTexture::loaderLoop, this, path);
+        return true;
+    }
+
+    void release()
+    {
+        if (!file)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        workAvailable.notify_all();
+        if (loader.joinable())
+            loader.join();
+        fclose(file);
+        file = NULL;
+        for (Feedback &feedback : feedbacks)
+            glDeleteSync(feedback.fence);
+        feedbacks.clear();
+        glDeleteTextures(1, &physicalTexture);
+        glDeleteTextures(1, &indirectionTexture);
+        glDeleteFramebuffers(1, &feedbackFramebuffer);
+        glDeleteTextures(1, &feedbackColor);
+        glDeleteRenderbuffers(1, &feedbackDepth);
+        glDeleteBuffers(FEEDBACK_BUFFERS, feedbackPbos);
+    }
+
+    // 设置着色器的 uniform 并绑定纹理
+    void bind(GLuint program, int physicalUnit, int indirectionUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + physicalUnit);
+        glBindTexture(GL_TEXTURE_2D, physicalTexture);
+        glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+        glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+        glUniform1i(glGetUniformLocation(program, "vtPhysical"), physicalUnit);
+        glUniform1i(glGetUniformLocation(program, "vtIndirection"), indirectionUnit);
+        glUniform2f(glGetUniformLocation(program, "vtSize"), (float)layout.levelWidth[0], (float)layout.levelHeight[0]);
+        glUniform1f(glGetUniformLocation(program, "vtTileSize"), (float)layout.tileSize);
+        glUniform1f(glGetUniformLocation(program, "vtBorder"), (float)layout.border);
+        glUniform1f(glGetUniformLocation(program, "vtPageSize"), (float)layout.pageSize());
+        glUniform1f(glGetUniformLocation(program, "vtPhysicalSize"), (float)physicalSize);
+        glUniform1i(glGetUniformLocation(program, "vtLevels"), layout.levels());
+        glUniform1iv(glGetUniformLocation(program, "vtLevelRow"), (GLsizei)levelRow.size(), levelRow.data());
+        glUniform1f(glGetUniformLocation(program, "vtFeedbackScale"), (float)FEEDBACK_DIVISOR);
+    }
+
+    // 绑定反馈缓冲并清空，之后用反馈着色器画场景
+    void beginFeedback(int width, int height)
+    {
+        int w = std::max(1, width / FEEDBACK_DIVISOR), h = std::max(1, height / FEEDBACK_DIVISOR);
+        if (w != feedbackWidth || h != feedbackHeight)
+            resizeFeedback(w, h);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+        glViewport(0, 0, feedbackWidth, feedbackHeight);
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    }
+
+    // 发起反馈缓冲的异步读回，恢复帧缓冲和视口
+    void endFeedback(GLuint restoreFramebuffer, int width, int height)
+    {
+        // 读回都还没完成时跳过这一帧的反馈
+        if (feedbacks.size() < FEEDBACK_BUFFERS)
+        {
+            GLuint pbo = feedbackPbos[nextPbo];
+            nextPbo = (nextPbo + 1) % FEEDBACK_BUFFERS;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            feedbacks.push_back({ pbo, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), feedbackWidth, feedbackHeight });
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, restoreFramebuffer);
+        glViewport(0, 0, width, height);
+    }
+
+    // 每帧调用：处理完成的反馈，更新加载队列，上传加载好的瓦片
+    void update()
+    {
+        frame++;
+        readFeedback();
+
+        std::vector<Loaded> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!loaded.empty() && (int)ready.size() < maxUploadsPerFrame)
+            {
+                inFlight.erase(loaded.front().key);
+                ready.push_back(std::move(loaded.front()));
+                loaded.pop_front();
+            }
+        }
+        bool changed = false;
+        for (Loaded &tile : ready)
+        {
+            if (resident.count(tile.key))
+                continue;
+            int slot = allocateSlot();
+            if (slot < 0)
+                break; // 所有页这一帧都要用，放弃，下次反馈会再请求
+            upload(slot, tile.key, tile.pixels);
+            stats.uploads++;
+            changed = true;
+        }
+        if (changed)
+            updateIndirection();
+    }
+
+    VirtualTextureStats getStats()
+    {
+        VirtualTextureStats result = stats;
+        result.residentPages = (int)resident.size();
+        result.physicalPages = pages * pages;
+        result.gpuBytes = (size_t)physicalSize * physicalSize * 4 + indirection.size();
+        std::lock_guard<std::mutex> lock(mutex);
+        result.pendingTiles = (int)(requests.size() + inFlight.size());
+        return result;
+    }
+
+    int width() const { return layout.levelWidth[0]; }
+    int height() const { return layout.levelHeight[0]; }
+
+private:
+    struct Slot
+    {
+        uint64_t key = 0;
+        bool used = false;
+        bool pinned = false;
+        uint64_t lastUsedFrame = 0;
+        std::list<int>::iterator lru;
+    };
+    struct Feedback
+    {
+        GLuint pbo;
+        GLsync fence;
+        int width, height;
+    };
+    struct Loaded
+    {
+        uint64_t key;
+        std::vector<uint8_t> pixels;
+    };
+
+    VirtualTextureLayout layout;
+    FILE *file = NULL;
+    int pages = 0;
+    int physicalSize = 0;
+    GLuint physicalTexture = 0;
+    GLuint indirectionTexture = 0;
+    int indirectionWidth = 0, indirectionHeight = 0;
+    std::vector<int> levelRow;
+    std::vector<uint8_t> indirection;
+
+    std::vector<Slot> slots;
+    std::list<int> lru; // 前面是最久没用的
+    std::unordered_map<uint64_t, int> resident;
+    uint64_t frame = 0;
+    VirtualTextureStats stats;
+
+    GLuint feedbackFramebuffer = 0, feedbackColor = 0, feedbackDepth = 0;
+    int feedbackWidth = 0, feedbackHeight = 0;
+    GLuint feedbackPbos[FEEDBACK_BUFFERS] = {};
+    int nextPbo = 0;
+    std::deque<Feedback> feedbacks;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::vector<uint64_t> requests; // 按优先级排好，加载线程从后往前取
+    std::unordered_set<uint64_t> inFlight; // 正在加载或者加载好还没上传的
+    std::deque<Loaded> loaded;
+    bool running = false;
+    std::thread loader;
+
+    static uint64_t tileKey(int level, int x, int y) { return (uint64_t)level << 48 | (uint64_t)y << 24 | (uint64_t)x; }
+    static int keyLevel(uint64_t key) { return (int)(key >> 48); }
+    static int keyY(uint64_t key) { return (int)((key >> 24) & 0xFFFFFF); }
+    static int keyX(uint64_t key) { return (int)(key & 0xFFFFFF); }
+
+    bool readTile(FILE *source, uint64_t key, std::vector<uint8_t> &pixels) const
+    {
+        pixels.resize(layout.tileBytes());
+        uint64_t offset = layout.tileOffset(keyLevel(key), keyX(key), keyY(key));
+        return fseeko(source, (off_t)offset, SEEK_SET) == 0 && fread(pixels.data(), 1, pixels.size(), source) == pixels.size();
+    }
+
+    void resizeFeedback(int w, int h)
+    {
+        feedbackWidth = w;
+        feedbackHeight = h;
+        if (feedbackColor)
+            glDeleteTextures(1, &feedbackColor);
+        if (feedbackDepth)
+            glDeleteRenderbuffers(1, &feedbackDepth);
+        glGenTextures(1, &feedbackColor);
+        glBindTexture(GL_TEXTURE_2D, feedbackColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glGenRenderbuffers(1, &feedbackDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+        for (GLuint pbo : feedbackPbos)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)w * h * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // 取最久没用、这一帧也没用到的页；返回 -1 表示没有可用的页
+    int allocateSlot()
+    {
+        for (int slot : lru)
+        {
+            Slot &s = slots[slot];
+            if (s.pinned)
+                continue;
+            if (s.used && s.lastUsedFrame >= frame)
+                return -1; // 后面的更新，都在用
+            if (s.used)
+            {
+                resident.erase(s.key);
+                stats.evictions++;
+            }
+            s.used = false;
+            return slot;
+        }
+        return -1;
+    }
+
+    void touch(int slot)
+    {
+        Slot &s = slots[slot];
+        s.lastUsedFrame = frame;
+        lru.splice(lru.end(), lru, s.lru);
+    }
+
+    void upload(int slot, uint64_t key, const std::vector<uint8_t> &pixels)
+    {
+        Slot &s = slots[slot];
+        s.key = key;
+        s.used = true;
+        resident[key] = slot;
+        touch(slot);
+        int pageSize = layout.pageSize();
+        glBindTexture(GL_TEXTURE_2D, physicalTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % pages) * pageSize, (slot / pages) * pageSize, pageSize, pageSize,
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+
+    // 从粗到细重建间接表，没加载的瓦片沿用上级瓦片的映射
+    void updateIndirection()
+    {
+        for (int l = layout.levels() - 1; l >= 0; l--)
+        {
+            for (int y = 0; y < layout.tilesY[l]; y++)
+            {
+                for (int x = 0; x < layout.tilesX[l]; x++)
+                {
+                    uint8_t *entry = &indirection[((size_t)(levelRow[l] + y) * indirectionWidth + x) * 4];
+                    auto it = resident.find(tileKey(l, x, y));
+                    if (it != resident.end())
+                    {
+                        entry[0] = (uint8_t)(it->second % pages);
+                        entry[1] = (uint8_t)(it->second / pages);
+                        entry[2] = (uint8_t)l;
+                        entry[3] = 255;
+                    }
+                    else
+                    {
+                        const uint8_t *parent = &indirection[((size_t)(levelRow[l + 1] + y / 2) * indirectionWidth + x / 2) * 4];
+                        memcpy(entry, parent, 4);
+                    }
+                }
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, indirectionWidth, indirectionHeight, GL_RGBA, GL_UNSIGNED_BYTE, indirection.data());
+    }
+
+    // 读最新完成的反馈，整理出需要的瓦片：已加载的标记使用，缺的连同上级一起请求
+    void readFeedback()
+    {
+        std::vector<uint8_t> pixels;
+        int width = 0, height = 0;
+        while (!feedbacks.empty())
+        {
+            Feedback &feedback = feedbacks.front();
+            GLenum result = glClientWaitSync(feedback.fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(feedback.fence);
+            // 只保留最新的一份
+            width = feedback.width;
+            height = feedback.height;
+            pixels.resize((size_t)width * height * 4);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback.pbo);
+            if (const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixels.size(), GL_MAP_READ_BIT))
+            {
+                memcpy(pixels.data(), mapped, pixels.size());
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            feedbacks.pop_front();
+        }
+        if (pixels.empty())
+            return;
+
+        std::unordered_set<uint64_t> needed;
+        uint32_t previous = 0;
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            uint32_t value;
+            memcpy(&value, &pixels[i], 4);
+            // 相邻像素通常是同一块瓦片
+            if (pixels[i + 3] == 0 || value == previous)
+                continue;
+            previous = value;
+            int level = pixels[i + 3] - 1;
+            int x = pixels[i] | (pixels[i + 2] & 0x0F) << 8;
+            int y = pixels[i + 1] | (pixels[i + 2] >> 4) << 8;
+            if (level >= layout.levels())
+                continue;
+            // 连同上级一起，保证缺页时回退的瓦片不会太粗
+            for (int l = level; l < layout.levels(); l++, x /= 2, y /= 2)
+            {
+                if (x >= layout.tilesX[l] || y >= layout.tilesY[l] || !needed.insert(tileKey(l, x, y)).second)
+                    break;
+            }
+        }
+
+        std::vector<uint64_t> missing;
+        for (uint64_t key : needed)
+        {
+            auto it = resident.find(key);
+            if (it != resident.end())
+                touch(it->second);
+            else
+                missing.push_back(key);
+        }
+        // 加载线程从后往前取，所以粗的级别放在后面
+        std::sort(missing.begin(), missing.end(), [](uint64_t a, uint64_t b) { return keyLevel(a) < keyLevel(b); });
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // 上一次没来得及加载的请求作废，换成这一帧的；正在加载和加载好还没上传的不再请求
+            missing.erase(std::remove_if(missing.begin(), missing.end(), [this](uint64_t key) { return inFlight.count(key) > 0; }),
+                          missing.end());
+            requests.swap(missing);
+        }
+        workAvailable.notify_one();
+    }
+
+    void loaderLoop(std::string path)
+    {
+        // 加载线程用自己的文件句柄，不和主线程抢文件位置
+        FILE *source = fopen(path.c_str(), "rb");
+        std::vector<uint8_t> pixels;
+        while (true)
+        {
+            uint64_t key;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this] { return !requests.empty() || !running; });
+                if (!running)
+                    break;
+                key = requests.back();
+                requests.pop_back();
+                inFlight.insert(key);
+            }
+            bool ok = source && readTile(source, key, pixels);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok)
+                loaded.push_back({ key, pixels });
+            else
+                inFlight.erase(key);
+        }
+        if (source)
+            fclose(source);
+    }
+};
+
+#endif /* virtual_texture_h */
@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+#  run_regression.sh
+#  依次以回归测试模式运行所有 demo，比较画面和帧耗时(见 common/regression.h)
+#
+#  用法：
+#    ./run_regression.sh <可执行文件目录> [参考图目录]            比较
+#    ./run_regression.sh --update <可执行文件目录> [参考图目录]   重新生成参考图和基准
+#  可执行文件目录一般是 Xcode 的 Build/Products/Debug，参考图目录默认是 ./regression
+#
+
+UPDATE=0
+if [ "$1" == "--update" ]; then
+    UPDATE=1
+    shift
+fi
+if [ -z "$1" ]; then
+    echo "usage: $0 [--update] <bin_dir> [reference_dir]"
+    exit 2
+fi
+BIN_DIR=$1
+REFERENCE_DIR=${2:-$(cd "$(dirname "$0")" && pwd)/regression}
+mkdir -p "$REFERENCE_DIR"
+
+DEMOS="triangle shader Texture Transformation Coordinate Camera"
+FAILED=""
+for demo in $DEMOS; do
+    if [ ! -x "$BIN_DIR/$demo" ]; then
+        echo "[regression] $demo: FAIL (missing $BIN_DIR/$demo)"
+        FAILED="$FAILED $demo"
+        continue
+    fi
+    if [ $UPDATE == 1 ]; then
+        REGRESSION_DIR="$REFERENCE_DIR" REGRESSION_UPDATE=1 "$BIN_DIR/$demo"
+    else
+        REGRESSION_DIR="$REFERENCE_DIR" "$BIN_DIR/$demo"
+    fi
+    if [ $? != 0 ]; then
+        FAILED="$FAILED $demo"
+    fi
+done
+
+if [ -n "$FAILED" ]; then
+    echo "FAILED:$FAILED"
+    exit 1
+fi
+echo "ALL PASSED"
+exit 0
@@ -9,6 +9,8 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include "../../common/shader_variant.h"
+#include "../../common/regression.h"
 
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
@@ -36,26 +38,44 @@ const char *vertexShaderSource = "#version 330 core\n"
     "void main()\n"
     "{\n"
     "   gl_Position = vec4(aPos,1.0);\n"
-    "   vertexColor = vec4(0.5, 0.0, 0.0, 1.0);\n"
+    "   vertexColor = vec4(VERTEX_RED, 0.0, 0.0, 1.0);\n"
     "}\0";
-// 片元着色
+// 片元着色，颜色来源由变体特性位决定，不再维护两份着色器
+// VERTEX_COLOR: 使用顶点着色器输出的颜色
+// UNIFORM_COLOR: 使用外部赋值的 uniform 颜色
 const char *fragmentShaderSource = "#version 330 core\n"
     "out vec4 FragColor;\n"
     "in vec4 vertexColor;\n" // 输入与顶点着色器的输出一致
-    "void main()\n"
-    "{\n"
-    "   FragColor = vertexColor;\n"
-    "}\n\0";
-
-// 全局变量片元着色
-const char *fragmentShaderSource1 = "#version 330 core\n"
-    "out vec4 FragColor;\n"
+    "#ifdef UNIFORM_COLOR\n"
     "uniform vec4 ourColor;\n" // 外部赋值
+    "#endif\n"
     "void main()\n"
     "{\n"
+    "#if defined(UNIFORM_COLOR)\n"
     "   FragColor = ourColor;\n"
+    "#elif defined(VERTEX_COLOR)\n"
+    "   FragColor = vertexColor;\n"
+    "#else\n"
+    "   FragColor = vec4(VERTEX_RED, 0.0, 0.0, 1.0);\n"
+    "#endif\n"
     "}\n\0";
 
+// 着色器变体特性位，顺序与 SHADER_FEATURES 一致
+enum ShaderFeature : unsigned int
+{
+    VERTEX_COLOR  = 1u << 0,
+    UNIFORM_COLOR = 1u << 1,
+};
+const std::array<const char *, 2> SHADER_FEATURES = { "VERTEX_COLOR", "UNIFORM_COLOR" };
+// 当前使用的变体，按 V 键切换
+unsigned int currentVariant = variantKey(UNIFORM_COLOR);
+
+// 按键事件，V 键在各个变体之间切换
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_PRESS && key == GLFW_KEY_V)
+        currentVariant = (currentVariant + 1) % (1u << SHADER_FEATURES.size());
+}
 
 int main()
 {
@@ -68,6 +88,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("shader");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -80,6 +102,8 @@ int main()
     glfwMakeContextCurrent(window);
     // 绑定窗口大小变化回调
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // 绑定按键事件
+    glfwSetKeyCallback(window, key_callback);
     
     // 初始化glad，是用来管理OpenGL的函数指针的
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -87,49 +111,15 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
 
     
-    // 创建一个顶点着色器
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL); // 加载顶点着色器代码
-    glCompileShader(vertexShader); // 编译着色器
-    // 检查着色器编译是否成功
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    
-    // 创建一个片元着色器
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource1, NULL); // 加载片元着色器代码
-    glCompileShader(fragmentShader);// 编译着色器
-    // 检查着色器编译是否成功
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    
-    
-    //关联着色器
-    unsigned int shaderProgram = glCreateProgram(); // 创建一个着色器程序，着色器程序对象是多个着色器合并之后的版本
-    glAttachShader(shaderProgram, vertexShader); // 挂载顶点着色器
-    glAttachShader(shaderProgram, fragmentShader); // 挂载片元着色器
-    glLinkProgram(shaderProgram); // 关联到opengl程序对象
-    
-    // 检查关联状态
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);  // 挂载后删除顶点着色器
-    glDeleteShader(fragmentShader);// 挂载后删除片元着色器
+    // 着色器变体，VERTEX_RED 作为编译期常量注入
+    ShaderVariants<2> shaderVariants(vertexShaderSource, fragmentShaderSource, SHADER_FEATURES,
+                                     { ShaderConstant::Float("VERTEX_RED", 0.5) });
+    // 提前编译默认变体，其余变体第一次用到时再编译
+    shaderVariants.precompile({ currentVariant });
 
     // 四个顶点
     float vertices[] = {
@@ -197,17 +187,22 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f); // 设置清空屏幕所用的颜色
         glClear(GL_COLOR_BUFFER_BIT); // 用上面设置的颜色清空屏幕
         
-        // 使用挂载了着色器的程序对象
+        // 按 key 直接取出当前变体的程序对象
+        unsigned int shaderProgram = shaderVariants.get(currentVariant);
         glUseProgram(shaderProgram);
         
         // 获取运行的秒数
-        float timeValue = glfwGetTime();
+        float timeValue = regressionTime();
         // 使用sin函数让颜色在0.0到1.0之间改变
         float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
-        // 查询uniform ourColor的位置值
-        int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-        // 设置uniform值， 注意更新之前要先使用glUseProgram使用该程序对象
-        glUniform4f(vertexColorLocation, 0.0f, greenValue, 0.0f, 1.0f);
+        // 只有 UNIFORM_COLOR 变体才有这个 uniform
+        if (currentVariant & UNIFORM_COLOR)
+        {
+            // 查询uniform ourColor的位置值
+            int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
+            // 设置uniform值， 注意更新之前要先使用glUseProgram使用该程序对象
+            glUniform4f(vertexColorLocation, 0.0f, greenValue, 0.0f, 1.0f);
+        }
         
         //绑定顶点数组
         glBindVertexArray(VAO);
@@ -216,6 +211,9 @@ int main()
         // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     
+        // 回归测试跑完固定帧数后退出
+        if (regressionEndFrame())
+            glfwSetWindowShouldClose(window, true);
         glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
         glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
     }
@@ -224,9 +222,10 @@ int main()
     // 删除缓冲数组
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
-    // 删除程序对象
-    glDeleteProgram(shaderProgram);
+    // 删除所有变体的程序对象
+    shaderVariants.release();
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }
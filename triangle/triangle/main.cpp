@@ -8,6 +8,7 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include "../../common/regression.h"
 
 // 声明函数
 // 按键事件，按下esc按钮时退出窗口
@@ -55,6 +56,8 @@ int main()
     #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
+    // 设置了 REGRESSION_DIR 时以回归测试模式运行
+    regressionInit("triangle");
     
     // 创建一个窗口对象
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -74,6 +77,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 回归测试模式下画到离屏帧缓冲
+    regressionSetup(SCR_WIDTH, SCR_HEIGHT);
 
     
     // 创建一个顶点着色器
@@ -193,6 +198,9 @@ int main()
         // 使用EBO的情况下,要使用glDrawElements来利用EBO绘制图形
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         
+        // 回归测试跑完固定帧数后退出
+        if (regressionEndFrame())
+            glfwSetWindowShouldClose(window, true);
         glfwSwapBuffers(window); //函数会交换颜色缓冲, 将缓冲区内容绘制到屏幕
         glfwPollEvents(); // 检查有没有触发什么事件、更新窗口状态，并调用对应的回调函数
     }
@@ -204,6 +212,7 @@ int main()
     // 删除程序对象
     glDeleteProgram(shaderProgram);
     // 当渲染循环结束后我们需要正确释放/删除之前的分配的所有资源
+    int result = regressionFinish();
     glfwTerminate();
-    return 0;
+    return result;
 }